@@ -0,0 +1,194 @@
+#include "async.h"
+
+#include <atomic>
+#include <optional>
+
+/*
+ * Partage et reconstruction pour les applications en coroutines : co_await confie la requête aux workers du
+ * dealer_engine (requête en place, sans copie des données) et suspend la coroutine, qui est reprise à la fin du
+ * calcul. Aucun thread n'attend : des milliers de requêtes peuvent être en vol sur un seul thread exécuteur.
+ *
+ * Etats d'une opération :
+ *  NEW -> QUEUED (soumise) -> RUNNING (prise par un worker, voir starting) -> DONE (calculée, coroutine reprise) ;
+ *  NEW -> CANCELLED : annulée avant la soumission, la coroutine n'est pas suspendue ;
+ *  QUEUED -> CANCELLED : annulée en file, la coroutine est reprise aussitôt, le worker saute le calcul.
+ * Chaque transition est un compare-exchange : la coroutine est reprise exactement une fois. L'opération est
+ * partagée entre l'attente et le dealer_engine (self), la dernière référence la libère.
+ */
+
+#define ASYNC_NEW 0
+#define ASYNC_QUEUED 1
+#define ASYNC_RUNNING 2
+#define ASYNC_CANCELLED 3
+#define ASYNC_DONE 4
+
+// Appelée par le stop_token de l'opération
+struct async_cancel
+{
+    async_operation * operation;
+
+    void operator()() const;
+};
+
+struct async_operation : public dealer_request, public dealer_listener
+{
+    std::atomic<int> state;
+    int status;
+    std::coroutine_handle<> handle;
+    async_executor * executor;
+    std::shared_ptr<async_operation> self;  // Référence du dealer_engine, rendue par completed
+    std::optional<std::stop_callback<async_cancel> > callback;
+
+    void resume()
+    {
+        if (executor != NULL) {
+            executor->post(handle);
+        } else {
+            handle.resume();
+        }
+    }
+
+    // Fonction appelée par le worker avant le calcul : une opération annulée n'est pas calculée
+    bool starting(dealer_request *)
+    {
+        int expected = ASYNC_QUEUED;
+        return state.compare_exchange_strong(expected, ASYNC_RUNNING, std::memory_order_acq_rel);
+    }
+
+    void completed(dealer_request *)
+    {
+        std::shared_ptr<async_operation> keep = std::move(self);
+        int expected = ASYNC_RUNNING;
+        if (state.compare_exchange_strong(expected, ASYNC_DONE, std::memory_order_acq_rel))
+        {
+            status = response[0];
+            resume();
+        }
+    }
+};
+
+void async_cancel::operator()() const
+{
+    int expected = ASYNC_NEW;
+    if (operation->state.compare_exchange_strong(expected, ASYNC_CANCELLED, std::memory_order_acq_rel)) {
+        return;
+    }
+    if (expected == ASYNC_QUEUED && operation->state.compare_exchange_strong(expected, ASYNC_CANCELLED, std::memory_order_acq_rel))
+    {
+        operation->status = DEALER_ERROR_CANCELLED;
+        operation->resume();
+    }
+}
+
+void async_loop::post(std::coroutine_handle<> handle)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    handles_.push_back(handle);
+    ready_.notify_one();
+}
+
+// Fonction qui reprend les coroutines postées, dans l'ordre, jusqu'à stop()
+void async_loop::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        ready_.wait(lock, [this] { return stopping_ || !handles_.empty(); });
+        if (handles_.empty()) {
+            break;
+        }
+        std::coroutine_handle<> handle = handles_.front();
+        handles_.pop_front();
+        lock.unlock();
+        handle.resume();
+        lock.lock();
+    }
+    stopping_ = false;
+}
+
+// Fonction qui interrompt run() une fois les coroutines déjà postées reprises
+void async_loop::stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    ready_.notify_one();
+}
+
+async_request::async_request(dealer_engine & engine, std::shared_ptr<async_operation> operation, std::stop_token stop, async_executor * executor)
+    : engine_(&engine), operation_(operation), stop_(stop), executor_(executor)
+{
+}
+
+// Fonction qui soumet la requête ; renvoie false si la coroutine continue sans être suspendue (annulée ou refusée)
+// Une fois la requête soumise, la coroutine peut être reprise par un autre thread : seules des variables locales
+// sont utilisées ensuite
+bool async_request::await_suspend(std::coroutine_handle<> handle)
+{
+    std::shared_ptr<async_operation> operation = operation_;
+    dealer_engine * engine = engine_;
+    operation->handle = handle;
+    operation->executor = executor_;
+    operation->callback.emplace(stop_, async_cancel { operation.get() });
+
+    int expected = ASYNC_NEW;
+    if (!operation->state.compare_exchange_strong(expected, ASYNC_QUEUED, std::memory_order_acq_rel))
+    {
+        operation->status = DEALER_ERROR_CANCELLED;
+        return false;
+    }
+
+    operation->self = operation;
+    if (engine->submit(operation.get())) {
+        return true;
+    }
+
+    // File pleine : la requête n'a jamais été prise, sauf annulation entre-temps qui a déjà repris la coroutine
+    operation->self.reset();
+    expected = ASYNC_QUEUED;
+    if (!operation->state.compare_exchange_strong(expected, ASYNC_DONE, std::memory_order_acq_rel)) {
+        return true;
+    }
+    operation->status = DEALER_ERROR_BUSY;
+    return false;
+}
+
+int async_request::await_resume() const
+{
+    return operation_->status;
+}
+
+// Fonction qui crée une opération en place sur engine
+static std::shared_ptr<async_operation> async_operation_create(int op, int k, int n, const unsigned char * input, unsigned char * output, size_t length)
+{
+    std::shared_ptr<async_operation> operation = std::make_shared<async_operation>();
+    operation->state = ASYNC_NEW;
+    operation->status = DEALER_ERROR_INTERNAL;
+    operation->executor = NULL;
+    operation->listener = operation.get();
+    operation->body.assign(DEALER_HEADER_BYTES, 0);
+    operation->body[0] = op;
+    operation->body[1] = k;
+    operation->body[2] = n;
+    operation->input = input;
+    operation->output = output;
+    operation->length = length;
+    return operation;
+}
+
+// Fonction qui prépare le partage en place du secret de length octets
+async_request async_split(dealer_engine & engine, const unsigned char * secret, size_t length, int k, int n, unsigned char * shares,
+                          std::stop_token stop, async_executor * executor)
+{
+    return async_request(engine, async_operation_create(DEALER_OP_SPLIT, k, n, secret, shares, length), stop, executor);
+}
+
+// Fonction qui prépare la reconstruction en place à partir des k parts de length octets bout à bout dans shares
+async_request async_combine(dealer_engine & engine, const int * x, int k, const unsigned char * shares, size_t length, unsigned char * secret,
+                            std::stop_token stop, async_executor * executor)
+{
+    std::shared_ptr<async_operation> operation = async_operation_create(DEALER_OP_COMBINE, k, 0, shares, secret, length);
+    for (int i = 0; i < k; i++) {
+        operation->body.push_back(x[i]);
+    }
+    return async_request(engine, operation, stop, executor);
+}
@@ -0,0 +1,92 @@
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include "dealer.h"
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+
+// Reprise des coroutines : une requête calculée ou annulée est confiée à post, appelée depuis un worker ou depuis
+// le thread qui annule
+struct async_executor
+{
+    virtual ~async_executor() {}
+
+    virtual void post(std::coroutine_handle<> handle) = 0;
+};
+
+// Exécuteur d'un seul thread : run() reprend les coroutines postées jusqu'à stop()
+class async_loop : public async_executor
+{
+public:
+    async_loop() : stopping_(false) {}
+
+    void post(std::coroutine_handle<> handle);
+
+    // Fonction qui reprend les coroutines postées, dans l'ordre, jusqu'à stop()
+    void run();
+
+    // Fonction qui interrompt run() une fois les coroutines déjà postées reprises
+    void stop();
+
+private:
+    async_loop(const async_loop &);
+    async_loop & operator=(const async_loop &);
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::coroutine_handle<> > handles_;
+    bool stopping_;
+};
+
+// Tâche détachée : la coroutine démarre aussitôt et son état est libéré à sa fin
+struct async_task
+{
+    struct promise_type
+    {
+        async_task get_return_object() { return async_task(); }
+        std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+        std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+struct async_operation;
+
+// Requête du dealer_engine attendue par co_await, qui rend son statut : DEALER_ERROR_BUSY si la file de calcul est
+// pleine, DEALER_ERROR_CANCELLED si l'annulation arrive avant que le calcul ne commence (un calcul commencé va à son
+// terme). A n'attendre qu'une fois
+class async_request
+{
+public:
+    async_request(dealer_engine & engine, std::shared_ptr<async_operation> operation, std::stop_token stop, async_executor * executor);
+
+    bool await_ready() const { return false; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    int await_resume() const;
+
+private:
+    dealer_engine * engine_;
+    std::shared_ptr<async_operation> operation_;
+    std::stop_token stop_;
+    async_executor * executor_;             // NULL : reprise dans le worker ou le thread qui annule
+};
+
+// Fonction qui prépare le partage en place du secret de length octets : les n parts (abscisses 1 ... n) sont écrites
+// bout à bout dans shares. secret et shares doivent rester valides jusqu'à la reprise de la coroutine
+async_request async_split(dealer_engine & engine, const unsigned char * secret, size_t length, int k, int n, unsigned char * shares,
+                          std::stop_token stop = std::stop_token(), async_executor * executor = NULL);
+
+// Fonction qui prépare la reconstruction en place à partir des k parts de length octets bout à bout dans shares,
+// d'abscisses x : le secret est écrit dans secret
+async_request async_combine(dealer_engine & engine, const int * x, int k, const unsigned char * shares, size_t length, unsigned char * secret,
+                            std::stop_token stop = std::stop_token(), async_executor * executor = NULL);
+
+#endif
@@ -0,0 +1,141 @@
+#include "batch.h"
+
+#include <algorithm>
+
+// Fonction qui initialise un lot de count éléments nuls de Z/pZ
+void field_batch_init(field_batch & batch, size_t count, mpz_t prime)
+{
+    batch.count = count;
+    batch.limbs = mpz_size(prime);
+    batch.data.assign(count * batch.limbs, 0);
+}
+
+// Fonction qui range la valeur dans l'élément i du lot
+void field_batch_set(field_batch & batch, size_t i, mpz_t value)
+{
+    mp_limb_t * element = batch.data.data() + i * batch.limbs;
+
+    // mpz_getlimbn renvoie 0 au-delà de la taille de la valeur, ce qui complète l'élément par des zéros
+    for (mp_size_t l = 0; l < batch.limbs; l++) {
+        element[l] = mpz_getlimbn(value, l);
+    }
+}
+
+// Fonction qui lit l'élément i du lot
+void field_batch_get(mpz_t value, const field_batch & batch, size_t i)
+{
+    const mp_limb_t * element = batch.data.data() + i * batch.limbs;
+
+    mp_limb_t * limbs = mpz_limbs_write(value, batch.limbs);
+    for (mp_size_t l = 0; l < batch.limbs; l++) {
+        limbs[l] = element[l];
+    }
+    mpz_limbs_finish(value, batch.limbs);
+}
+
+// Fonction qui copie la ligne r (cols éléments) d'une matrice dans un lot
+void field_batch_get_row(field_batch & row, const field_batch & matrix, size_t r, size_t cols)
+{
+    row.count = cols;
+    row.limbs = matrix.limbs;
+
+    std::vector<mp_limb_t>::const_iterator first = matrix.data.begin() + r * cols * matrix.limbs;
+    row.data.assign(first, first + cols * matrix.limbs);
+}
+
+// Fonction qui copie un lot dans la ligne r d'une matrice ayant row.count colonnes
+void field_batch_set_row(field_batch & matrix, size_t r, const field_batch & row)
+{
+    std::copy(row.data.begin(), row.data.end(), matrix.data.begin() + r * row.count * matrix.limbs);
+}
+
+// Fonction qui calcule result[i] = result[i] + other[i] modulo prime pour tous les éléments du lot
+// Les deux opérandes étant dans [0; prime[, une seule soustraction conditionnelle suffit à la réduction
+void field_batch_add_mod(field_batch & result, const field_batch & other, mpz_t prime)
+{
+    const mp_limb_t * p = mpz_limbs_read(prime);
+    mp_size_t limbs = result.limbs;
+
+    mp_limb_t * r = result.data.data();
+    const mp_limb_t * a = other.data.data();
+
+    for (size_t i = 0; i < result.count; i++, r += limbs, a += limbs)
+    {
+        mp_limb_t carry = mpn_add_n(r, r, a, limbs);
+
+        // La retenue éventuelle est absorbée par l'emprunt de la soustraction
+        if (carry != 0 || mpn_cmp(r, p, limbs) >= 0) {
+            mpn_sub_n(r, r, p, limbs);
+        }
+    }
+}
+
+// Fonction qui construit la matrice de Vandermonde (rows x cols) des abscisses : V[r][j] = x[r]^j modulo prime
+void field_batch_vandermonde(field_batch & matrix, mpz_t * x, int rows, int cols, mpz_t prime)
+{
+    mpz_t power;
+    mpz_init(power);
+
+    field_batch_init(matrix, (size_t) rows * cols, prime);
+
+    for (int r = 0; r < rows; r++)
+    {
+        mpz_set_ui(power, 1);
+        for (int j = 0; j < cols; j++)
+        {
+            field_batch_set(matrix, (size_t) r * cols + j, power);
+            mpz_mul(power, power, x[r]);
+            mpz_mod(power, power, prime);
+        }
+    }
+
+    mpz_clear(power);
+}
+
+#define MATMUL_BLOCK 64 // Nombre de colonnes du résultat accumulées ensemble
+
+// Fonction qui calcule le produit matriciel result (rows x cols) = a (rows x inner) * b (inner x cols) modulo prime
+// Les matrices sont rangées ligne par ligne. Les produits sont accumulés sans réduction sur 2 * limbs + 1 limbs,
+// puis chaque coefficient du résultat n'est réduit qu'une seule fois modulo prime
+void field_batch_matmul(field_batch & result, const field_batch & a, const field_batch & b, int rows, int inner, size_t cols, mpz_t prime)
+{
+    const mp_limb_t * p = mpz_limbs_read(prime);
+    mp_size_t limbs = mpz_size(prime);
+    mp_size_t wide = 2 * limbs + 1;
+
+    field_batch_init(result, (size_t) rows * cols, prime);
+
+    std::vector<mp_limb_t> accumulators(MATMUL_BLOCK * wide);
+    std::vector<mp_limb_t> product(2 * limbs);
+    std::vector<mp_limb_t> quotient(limbs + 2);
+
+    for (int r = 0; r < rows; r++)
+    {
+        for (size_t first = 0; first < cols; first += MATMUL_BLOCK)
+        {
+            size_t width = cols - first < MATMUL_BLOCK ? cols - first : MATMUL_BLOCK;
+            std::fill(accumulators.begin(), accumulators.begin() + width * wide, 0);
+
+            // On parcourt les lignes de b pour lire ses éléments de façon contiguë
+            for (int t = 0; t < inner; t++)
+            {
+                const mp_limb_t * coefficient = a.data.data() + ((size_t) r * inner + t) * limbs;
+                const mp_limb_t * row = b.data.data() + ((size_t) t * cols + first) * limbs;
+
+                for (size_t s = 0; s < width; s++)
+                {
+                    mp_limb_t * acc = accumulators.data() + s * wide;
+                    mpn_mul_n(product.data(), coefficient, row + s * limbs, limbs);
+                    acc[2 * limbs] += mpn_add_n(acc, acc, product.data(), 2 * limbs);
+                }
+            }
+
+            // Réduction unique de chaque accumulateur
+            for (size_t s = 0; s < width; s++)
+            {
+                mp_limb_t * element = result.data.data() + ((size_t) r * cols + first + s) * limbs;
+                mpn_tdiv_qr(quotient.data(), element, 0, accumulators.data() + s * wide, wide, p, limbs);
+            }
+        }
+    }
+}
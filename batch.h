@@ -0,0 +1,36 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <gmp.h>
+#include <vector>
+
+// Lot d'éléments de Z/pZ stockés à largeur fixe (celle de p) dans un tableau contigu de limbs
+// Les opérations sur un lot travaillent directement sur les limbs (fonctions mpn) sans allocation
+struct field_batch
+{
+    size_t count;                    // Nombre d'éléments du lot
+    mp_size_t limbs;                 // Nombre de limbs d'un élément
+    std::vector<mp_limb_t> data;     // Elément i : data[i * limbs] ... data[(i + 1) * limbs - 1], poids faible en premier
+};
+
+// Fonction qui initialise un lot de count éléments nuls de Z/pZ
+void field_batch_init(field_batch & batch, size_t count, mpz_t prime);
+
+// Fonctions d'accès à un élément du lot (la valeur doit être dans [0; prime[)
+void field_batch_set(field_batch & batch, size_t i, mpz_t value);
+void field_batch_get(mpz_t value, const field_batch & batch, size_t i);
+
+// Fonctions de copie d'une ligne (cols éléments) d'une matrice rangée ligne par ligne
+void field_batch_get_row(field_batch & row, const field_batch & matrix, size_t r, size_t cols);
+void field_batch_set_row(field_batch & matrix, size_t r, const field_batch & row);
+
+// Fonction qui calcule result[i] = result[i] + other[i] modulo prime pour tous les éléments du lot
+void field_batch_add_mod(field_batch & result, const field_batch & other, mpz_t prime);
+
+// Fonction qui construit la matrice de Vandermonde (rows x cols) des abscisses : V[r][j] = x[r]^j modulo prime
+void field_batch_vandermonde(field_batch & matrix, mpz_t * x, int rows, int cols, mpz_t prime);
+
+// Fonction qui calcule le produit matriciel result (rows x cols) = a (rows x inner) * b (inner x cols) modulo prime
+void field_batch_matmul(field_batch & result, const field_batch & a, const field_batch & b, int rows, int inner, size_t cols, mpz_t prime);
+
+#endif
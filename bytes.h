@@ -0,0 +1,21 @@
+#ifndef BYTES_H
+#define BYTES_H
+
+// Fonctions de lecture et d'écriture d'entiers non signés en little-endian sur bytes octets
+inline void store_uint(unsigned char * out, unsigned long long value, int bytes)
+{
+    for (int b = 0; b < bytes; b++) {
+        out[b] = (unsigned char) (value >> (8 * b));
+    }
+}
+
+inline unsigned long long load_uint(const unsigned char * in, int bytes)
+{
+    unsigned long long value = 0;
+    for (int b = 0; b < bytes; b++) {
+        value |= (unsigned long long) in[b] << (8 * b);
+    }
+    return value;
+}
+
+#endif
@@ -0,0 +1,570 @@
+#include "channel.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <openssl/crypto.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+ * Canal en mémoire partagée entre un client et le dealer de la même machine. Pour de gros secrets, la socket coûte
+ * deux copies noyau par sens et le découpage des trames ; ici les octets ne bougent pas.
+ *
+ * Segment (memfd scellé contre la réduction, créé par le client) :
+ *  - en-tête : magic "TP7Q" (propre au canal), version, nombre de cases, taille d'une case, compteurs ;
+ *  - anneau de soumission : un mot par position, 0 si vide, sinon numéro de case + 1 ;
+ *  - descripteurs des cases (channel_slot) ;
+ *  - zones de données des cases.
+ *
+ * Soumission : le client réserve une case (FREE -> CLAIMED), y écrit ses données et son descripteur, la passe à
+ * SUBMITTED, prend une position de l'anneau (plusieurs threads clients, un seul consommateur) et y écrit la case.
+ * Une case n'est dans l'anneau qu'une fois à la fois, l'anneau (autant de positions que de cases) ne déborde pas.
+ * Le thread du canal côté dealer vide l'anneau et confie chaque case au dealer_engine comme requête en place ; le
+ * worker écrit les résultats dans la case, puis son statut et l'état DONE.
+ *
+ * Réveils par futex partagés, seulement quand l'autre côté dort : le dealer s'endort sur doorbell après avoir levé
+ * sleeping, le client s'endort sur l'état de sa case après l'avoir passé à WAITING. Les sommeils sont bornés
+ * (CHANNEL_POLL_MS) pour remarquer un côté parti.
+ *
+ * Le segment appartient aussi au client : le dealer ne lit chaque descripteur qu'une fois, vérifie les zones contre
+ * sa propre copie de la géométrie et refuse une case déjà en calcul ; un client qui écrit dans une case en calcul
+ * n'abîme que ses propres résultats.
+ */
+
+#define CHANNEL_MAGIC "TP7Q"
+#define CHANNEL_VERSION 1
+
+// Fonction qui arrondit au multiple de 64 supérieur
+static size_t channel_align(size_t size)
+{
+    return (size + 63) & ~(size_t) 63;
+}
+
+// Fonctions d'accès aux futex partagés entre processus
+static void channel_futex_wait(std::atomic<uint32_t> * word, uint32_t expected, int milliseconds)
+{
+    struct timespec timeout = { milliseconds / 1000, (milliseconds % 1000) * 1000000L };
+    syscall(SYS_futex, (uint32_t *) word, FUTEX_WAIT, expected, &timeout, NULL, 0);
+}
+
+static void channel_futex_wake(std::atomic<uint32_t> * word)
+{
+    syscall(SYS_futex, (uint32_t *) word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+// Fonction qui indique si le pair d'une socket est parti
+static bool channel_peer_gone(int fd)
+{
+    char byte;
+    ssize_t got = recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    return got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+}
+
+// Décalages des parties du segment
+static size_t channel_ring_offset()
+{
+    return channel_align(sizeof(channel_header));
+}
+
+static size_t channel_slots_offset(uint32_t slots)
+{
+    return channel_ring_offset() + channel_align(slots * sizeof(uint32_t));
+}
+
+static size_t channel_data_offset(uint32_t slots)
+{
+    return channel_slots_offset(slots) + channel_align(slots * sizeof(channel_slot));
+}
+
+// Fonction qui donne la taille d'un segment de slots cases de slotBytes octets
+size_t channel_size(uint32_t slots, uint32_t slotBytes)
+{
+    return channel_data_offset(slots) + (size_t) slots * slotBytes;
+}
+
+// Requête d'une case côté dealer
+struct channel_request : public dealer_request
+{
+    unsigned int slot;
+    std::atomic<bool> busy;                 // En calcul : une case soumise deux fois n'est pas reprise
+};
+
+// Canal attaché : géométrie copiée à l'attachement, jamais relue dans le segment
+struct channel : public dealer_listener
+{
+    unsigned char * base;
+    size_t size;
+    uint32_t slots;
+    uint32_t slotBytes;
+    channel_header * header;
+    std::atomic<uint32_t> * ring;
+    channel_slot * descriptors;
+    unsigned char * data;
+    uint32_t head;                          // Prochaine position de l'anneau à lire
+    std::unique_ptr<channel_request[]> requests;
+    std::atomic<int> inFlight;
+
+    // Fonction qui publie le statut d'une case calculée et réveille son client s'il dort (appelée par un worker)
+    void completed(dealer_request * request)
+    {
+        channel_request * slotRequest = static_cast<channel_request *>(request);
+        channel_slot & descriptor = descriptors[slotRequest->slot];
+        descriptor.status = request->response[0];
+
+        // Requête libérée avant DONE : le client peut aussitôt soumettre de nouveau la case
+        slotRequest->busy.store(false, std::memory_order_release);
+        if (descriptor.state.exchange(CHANNEL_DONE, std::memory_order_acq_rel) == CHANNEL_WAITING) {
+            channel_futex_wake(&descriptor.state);
+        }
+        inFlight--;
+    }
+};
+
+channel_server::channel_server() : listen_(-1), stopping_(false), attached_(0), engine_(NULL), active_(0)
+{
+}
+
+channel_server::~channel_server()
+{
+    close();
+}
+
+// Fonction qui crée la socket d'attachement à path ; les calculs sont confiés à engine
+bool channel_server::open(const std::string & path, dealer_engine & engine)
+{
+    listen_ = dealer_listen(path);
+    if (listen_ < 0) {
+        return false;
+    }
+    path_ = path;
+    engine_ = &engine;
+    stopping_ = false;
+    return true;
+}
+
+// Fonction qui attache les canaux jusqu'à stop()
+void channel_server::run()
+{
+    while (!stopping_)
+    {
+        int fd = accept4(listen_, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EMFILE || errno == ENFILE) {
+                usleep(1000);
+            }
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections_.insert(fd);
+        active_++;
+        std::thread(&channel_server::serve, this, fd).detach();
+    }
+}
+
+// Fonction qui interrompt run() ; utilisable depuis un gestionnaire de signal
+void channel_server::stop()
+{
+    stopping_ = true;
+    if (listen_ >= 0) {
+        shutdown(listen_, SHUT_RDWR);
+    }
+}
+
+// Fonction qui détache les canaux une fois leurs calculs terminés et supprime la socket
+void channel_server::close()
+{
+    if (listen_ < 0) {
+        return;
+    }
+    stop();
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        closed_.wait(lock, [this] { return active_ == 0; });
+    }
+    ::close(listen_);
+    listen_ = -1;
+    unlink(path_.c_str());
+}
+
+// Fonction qui reçoit le segment d'un client et le vérifie ; renvoie NULL s'il n'est pas utilisable
+channel * channel_server::attach(int fd)
+{
+    // Un client qui se connecte sans rien envoyer ne retient pas close()
+    struct timeval timeout = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char byte;
+    struct iovec vector = { &byte, 1 };
+    union {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control.space;
+    message.msg_controllen = sizeof(control.space);
+    if (recvmsg(fd, &message, MSG_CMSG_CLOEXEC) != 1) {
+        return NULL;
+    }
+    struct cmsghdr * header = CMSG_FIRSTHDR(&message);
+    if (header == NULL || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS
+        || header->cmsg_len != CMSG_LEN(sizeof(int))) {
+        return NULL;
+    }
+    int memory;
+    memcpy(&memory, CMSG_DATA(header), sizeof(int));
+
+    // Scellé contre la réduction : le client ne peut pas faire disparaître des pages sous les workers (SIGBUS)
+    struct stat status;
+    int seals = fcntl(memory, F_GET_SEALS);
+    if (fstat(memory, &status) != 0 || seals < 0 || !(seals & F_SEAL_SHRINK) || status.st_size < (off_t) sizeof(channel_header)
+        || (unsigned long long) status.st_size > CHANNEL_MAX_BYTES)
+    {
+        ::close(memory);
+        return NULL;
+    }
+    size_t size = status.st_size;
+    void * base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, memory, 0);
+    ::close(memory);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    channel_header * shared = (channel_header *) base;
+    uint32_t slots = shared->slots, slotBytes = shared->slotBytes;
+    if (memcmp(shared->magic, CHANNEL_MAGIC, 4) != 0 || shared->version != CHANNEL_VERSION || slots == 0 || slots > CHANNEL_MAX_SLOTS
+        || (slots & (slots - 1)) != 0 || slotBytes == 0 || slotBytes % 64 != 0 || channel_size(slots, slotBytes) > size)
+    {
+        munmap(base, size);
+        return NULL;
+    }
+
+    channel * attached = new channel();
+    attached->base = (unsigned char *) base;
+    attached->size = size;
+    attached->slots = slots;
+    attached->slotBytes = slotBytes;
+    attached->header = shared;
+    attached->ring = (std::atomic<uint32_t> *) (attached->base + channel_ring_offset());
+    attached->descriptors = (channel_slot *) (attached->base + channel_slots_offset(slots));
+    attached->data = attached->base + channel_data_offset(slots);
+    attached->head = 0;
+    attached->requests.reset(new channel_request[slots]);
+    attached->inFlight = 0;
+    for (uint32_t i = 0; i < slots; i++)
+    {
+        attached->requests[i].slot = i;
+        attached->requests[i].busy = false;
+        attached->requests[i].listener = attached;
+    }
+    return attached;
+}
+
+// Fonction qui confie au dealer les cases soumises depuis le dernier passage
+void channel_server::drain(channel * channel)
+{
+    while (true)
+    {
+        std::atomic<uint32_t> & position = channel->ring[channel->head & (channel->slots - 1)];
+        uint32_t entry = position.load(std::memory_order_acquire);
+        if (entry == 0) {
+            return;
+        }
+        position.store(0, std::memory_order_relaxed);
+        channel->head++;
+
+        uint32_t slot = entry - 1;
+        if (slot >= channel->slots || channel->requests[slot].busy.exchange(true, std::memory_order_acquire)) {
+            continue;
+        }
+        channel_request & request = channel->requests[slot];
+        channel_slot & descriptor = channel->descriptors[slot];
+
+        // Descripteur lu une seule fois ; les zones sont vérifiées sur cette copie
+        unsigned char op = descriptor.op, k = descriptor.k, n = descriptor.n;
+        unsigned long long length = descriptor.length, input = descriptor.input, output = descriptor.output;
+        unsigned long long inputs = op == DEALER_OP_SPLIT ? 1 : k, outputs = op == DEALER_OP_SPLIT ? n : 1;
+        request.body.assign(DEALER_HEADER_BYTES, 0);
+        request.body[0] = op;
+        request.body[1] = k;
+        request.body[2] = n;
+        if (op == DEALER_OP_COMBINE) {
+            request.body.insert(request.body.end(), descriptor.x, descriptor.x + k);
+        }
+        unsigned char * data = channel->data + (size_t) slot * channel->slotBytes;
+        request.input = data + input;
+        request.output = data + output;
+        request.length = length;
+
+        channel->inFlight++;
+        if (input + inputs * length > channel->slotBytes || output + outputs * length > channel->slotBytes)
+        {
+            request.response.assign(DEALER_HEADER_BYTES, 0);
+            request.response[0] = DEALER_ERROR_RANGE;
+            channel->completed(&request);
+        } else if (!engine_->submit(&request)) {
+            // Délestage, comme pour les requêtes des sockets
+            request.response.assign(DEALER_HEADER_BYTES, 0);
+            request.response[0] = DEALER_ERROR_BUSY;
+            channel->completed(&request);
+        }
+    }
+}
+
+// Thread d'un canal : attache le segment puis confie ses cases au dealer jusqu'au départ du client ou à l'arrêt
+void channel_server::serve(int fd)
+{
+    channel * attached = attach(fd);
+    char ready = attached != NULL ? DEALER_OK : DEALER_ERROR_REQUEST;
+    if (send(fd, &ready, 1, MSG_NOSIGNAL) == 1 && attached != NULL)
+    {
+        attached_++;
+        channel_header * header = attached->header;
+        while (!stopping_)
+        {
+            uint32_t doorbell = header->doorbell.load(std::memory_order_acquire);
+            drain(attached);
+
+            // Barrière : soit le dealer voit la soumission, soit le client le voit endormi
+            header->sleeping.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (attached->ring[attached->head & (attached->slots - 1)].load(std::memory_order_relaxed) == 0)
+            {
+                channel_futex_wait(&header->doorbell, doorbell, CHANNEL_POLL_MS);
+                if (header->doorbell.load(std::memory_order_relaxed) == doorbell && channel_peer_gone(fd))
+                {
+                    header->sleeping.store(0, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            header->sleeping.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Les workers écrivent encore dans le segment tant que des cases sont en calcul
+    if (attached != NULL)
+    {
+        while (attached->inFlight > 0) {
+            usleep(100);
+        }
+        munmap(attached->base, attached->size);
+        delete attached;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_.erase(fd);
+    ::close(fd);
+    active_--;
+    closed_.notify_all();
+}
+
+channel_client::channel_client() : fd_(-1), base_(NULL), size_(0), slots_(0), slotBytes_(0), header_(NULL), ring_(NULL),
+    descriptors_(NULL), data_(NULL), hint_(0)
+{
+}
+
+channel_client::~channel_client()
+{
+    close();
+}
+
+// Fonction qui crée le segment (slots cases de slotBytes octets) et l'attache au dealer à path
+bool channel_client::open(const std::string & path, unsigned int slots, size_t slotBytes)
+{
+    slots_ = 1;
+    while (slots_ < std::max(1u, slots)) {
+        slots_ *= 2;
+    }
+    slotBytes_ = channel_align(std::max((size_t) 1, slotBytes));
+    size_ = channel_size(slots_, slotBytes_);
+    if (slots_ > CHANNEL_MAX_SLOTS || size_ > CHANNEL_MAX_BYTES) {
+        return false;
+    }
+
+    int memory = memfd_create("tp7-channel", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memory < 0) {
+        return false;
+    }
+    void * base = MAP_FAILED;
+    if (ftruncate(memory, size_) == 0 && fcntl(memory, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == 0) {
+        base = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, memory, 0);
+    }
+    if (base == MAP_FAILED)
+    {
+        ::close(memory);
+        return false;
+    }
+    base_ = (unsigned char *) base;
+
+    // Pages neuves d'un memfd : déjà nulles, donc anneau vide et cases libres
+    header_ = new (base_) channel_header();
+    memcpy(header_->magic, CHANNEL_MAGIC, 4);
+    header_->version = CHANNEL_VERSION;
+    header_->slots = slots_;
+    header_->slotBytes = slotBytes_;
+    header_->tail = 0;
+    header_->doorbell = 0;
+    header_->sleeping = 0;
+    ring_ = (std::atomic<uint32_t> *) (base_ + channel_ring_offset());
+    descriptors_ = (channel_slot *) (base_ + channel_slots_offset(slots_));
+    data_ = base_ + channel_data_offset(slots_);
+
+    // Attachement : le memfd part en SCM_RIGHTS, le dealer répond par un octet de statut
+    fd_ = dealer_connect(path);
+    char byte = 0, ready = DEALER_ERROR_IO;
+    struct iovec vector = { &byte, 1 };
+    union {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control.space;
+    message.msg_controllen = sizeof(control.space);
+    struct cmsghdr * header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(header), &memory, sizeof(int));
+
+    bool ok = fd_ >= 0 && sendmsg(fd_, &message, MSG_NOSIGNAL) == 1 && recv(fd_, &ready, 1, 0) == 1 && ready == DEALER_OK;
+    ::close(memory);
+    if (!ok) {
+        close();
+    }
+    return ok;
+}
+
+// Fonction qui réserve une case libre, en attendant qu'une se libère ; renvoie son numéro
+int channel_client::acquire()
+{
+    for (unsigned long long attempt = 0; ; attempt++)
+    {
+        unsigned int slot = hint_.fetch_add(1, std::memory_order_relaxed) & (slots_ - 1);
+        uint32_t expected = CHANNEL_FREE;
+        if (descriptors_[slot].state.compare_exchange_strong(expected, CHANNEL_CLAIMED, std::memory_order_acquire)) {
+            return slot;
+        }
+        if (attempt % slots_ == slots_ - 1) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Fonction qui soumet le partage du secret de length octets à input : les n parts sont écrites bout à bout à output
+bool channel_client::split(int slot, size_t input, size_t length, int k, int n, size_t output)
+{
+    if (k < 1 || n < k || n > 255 || input + length > slotBytes_ || output + n * length > slotBytes_) {
+        return false;
+    }
+    channel_slot & descriptor = descriptors_[slot];
+    descriptor.op = DEALER_OP_SPLIT;
+    descriptor.k = k;
+    descriptor.n = n;
+    descriptor.length = length;
+    descriptor.input = input;
+    descriptor.output = output;
+    submit(slot);
+    return true;
+}
+
+// Fonction qui soumet la reconstruction à partir des k parts de length octets à input, d'abscisses x
+bool channel_client::combine(int slot, const int * x, int k, size_t input, size_t length, size_t output)
+{
+    if (k < 1 || k > 255 || input + k * length > slotBytes_ || output + length > slotBytes_) {
+        return false;
+    }
+    channel_slot & descriptor = descriptors_[slot];
+    descriptor.op = DEALER_OP_COMBINE;
+    descriptor.k = k;
+    descriptor.n = 0;
+    descriptor.length = length;
+    descriptor.input = input;
+    descriptor.output = output;
+    for (int i = 0; i < k; i++) {
+        descriptor.x[i] = x[i];
+    }
+    submit(slot);
+    return true;
+}
+
+// Fonction qui passe une case remplie au dealer : anneau, puis réveil du dealer s'il dort
+void channel_client::submit(int slot)
+{
+    descriptors_[slot].state.store(CHANNEL_SUBMITTED, std::memory_order_relaxed);
+    uint32_t position = header_->tail.fetch_add(1, std::memory_order_relaxed);
+    ring_[position & (slots_ - 1)].store(slot + 1, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    header_->doorbell.fetch_add(1, std::memory_order_release);
+    if (header_->sleeping.load(std::memory_order_relaxed) != 0) {
+        channel_futex_wake(&header_->doorbell);
+    }
+}
+
+// Fonction qui attend le calcul de la case ; renvoie son statut
+int channel_client::wait(int slot)
+{
+    channel_slot & descriptor = descriptors_[slot];
+    for (int spin = 0; spin < CHANNEL_SPIN; spin++)
+    {
+        if (descriptor.state.load(std::memory_order_acquire) == CHANNEL_DONE) {
+            return descriptor.status;
+        }
+    }
+
+    while (true)
+    {
+        uint32_t expected = CHANNEL_SUBMITTED;
+        if (!descriptor.state.compare_exchange_strong(expected, CHANNEL_WAITING, std::memory_order_acquire)
+            && expected == CHANNEL_DONE) {
+            return descriptor.status;
+        }
+        channel_futex_wait(&descriptor.state, CHANNEL_WAITING, CHANNEL_POLL_MS);
+        if (descriptor.state.load(std::memory_order_acquire) == CHANNEL_DONE) {
+            return descriptor.status;
+        }
+        if (channel_peer_gone(fd_)) {
+            return DEALER_ERROR_IO;
+        }
+    }
+}
+
+// Fonction qui rend la case
+void channel_client::release(int slot)
+{
+    descriptors_[slot].state.store(CHANNEL_FREE, std::memory_order_release);
+}
+
+void channel_client::close()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (base_ != NULL)
+    {
+        OPENSSL_cleanse(data_, (size_t) slots_ * slotBytes_);
+        munmap(base_, size_);
+        base_ = NULL;
+    }
+}
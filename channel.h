@@ -0,0 +1,154 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include "dealer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+#define CHANNEL_SLOTS 64                // Cases d'un canal par défaut
+#define CHANNEL_SLOT_BYTES (1 << 20)    // Taille par défaut de la zone de données d'une case
+#define CHANNEL_MAX_SLOTS 4096
+#define CHANNEL_MAX_BYTES (1ULL << 32)  // Taille maximale d'un segment partagé
+#define CHANNEL_SPIN 2000               // Essais avant de s'endormir sur un futex
+#define CHANNEL_POLL_MS 100             // Délai d'un sommeil : vérifie que l'autre côté est toujours là
+
+// Etats d'une case (mot futex)
+#define CHANNEL_FREE 0          // Libre
+#define CHANNEL_CLAIMED 1       // Réservée par un thread client, qui la remplit
+#define CHANNEL_SUBMITTED 2     // Soumise au dealer
+#define CHANNEL_WAITING 3       // Soumise, un client dort sur le futex de la case
+#define CHANNEL_DONE 4          // Calculée : statut et résultats écrits
+
+// En-tête du segment partagé ; les compteurs des producteurs et du consommateur sont sur des lignes de cache distinctes
+struct channel_header
+{
+    char magic[4];                          // "TP7Q"
+    uint32_t version;
+    uint32_t slots;                         // Puissance de 2
+    uint32_t slotBytes;                     // Multiple de 64
+    alignas(64) std::atomic<uint32_t> tail; // Prochaine position de l'anneau de soumission (clients)
+    alignas(64) std::atomic<uint32_t> doorbell; // Futex du dealer : incrémenté à chaque soumission
+    std::atomic<uint32_t> sleeping;         // Dealer endormi sur doorbell
+};
+
+// Descripteur d'une case : écrit par le client avant la soumission, le dealer en prend une copie
+struct channel_slot
+{
+    std::atomic<uint32_t> state;
+    unsigned char op, k, n, status;
+    uint32_t length;                        // Taille d'un secret (et d'une part)
+    uint32_t input;                         // Décalage des entrées dans la zone de données de la case
+    uint32_t output;                        // Décalage des résultats
+    unsigned char x[255];                   // Abscisses d'une reconstruction
+};
+
+// Fonction qui donne la taille d'un segment de slots cases de slotBytes octets
+size_t channel_size(uint32_t slots, uint32_t slotBytes);
+
+struct channel;
+
+// Dealer en mémoire partagée pour les clients de la même machine : un client crée un segment memfd scellé et le
+// confie au dealer par une socket Unix (SCM_RIGHTS). Le client écrit secrets et parts dans les cases du segment et
+// les soumet par un anneau ; les workers du dealer_engine les lisent et écrivent les résultats en place, sans
+// copie ni trame. Un thread par canal attaché, comme dealer_server
+class channel_server
+{
+public:
+    channel_server();
+    ~channel_server();
+
+    // Fonction qui crée la socket d'attachement à path ; les calculs sont confiés à engine
+    bool open(const std::string & path, dealer_engine & engine);
+
+    // Fonction qui attache les canaux jusqu'à stop()
+    void run();
+
+    // Fonction qui interrompt run() ; utilisable depuis un gestionnaire de signal
+    void stop();
+
+    // Fonction qui détache les canaux une fois leurs calculs terminés et supprime la socket ; à appeler avant
+    // l'arrêt de engine
+    void close();
+
+    unsigned long long attached() const { return attached_; }
+
+private:
+    channel_server(const channel_server &);
+    channel_server & operator=(const channel_server &);
+
+    void serve(int fd);
+    channel * attach(int fd);
+    void drain(channel * channel);
+
+    std::string path_;
+    int listen_;
+    std::atomic<bool> stopping_;
+    std::atomic<unsigned long long> attached_;
+    dealer_engine * engine_;
+
+    std::mutex mutex_;                      // Protège les connexions
+    std::condition_variable closed_;
+    std::set<int> connections_;
+    int active_;
+};
+
+// Côté client d'un canal ; ses fonctions peuvent être appelées par plusieurs threads (une case par thread)
+class channel_client
+{
+public:
+    channel_client();
+    ~channel_client();
+
+    // Fonction qui crée le segment (slots cases de slotBytes octets) et l'attache au dealer à path
+    bool open(const std::string & path, unsigned int slots, size_t slotBytes);
+
+    // Fonction qui réserve une case libre, en attendant qu'une se libère ; renvoie son numéro
+    int acquire();
+
+    // Zone de données de la case, de slot_bytes() octets
+    unsigned char * data(int slot) const { return data_ + (size_t) slot * slotBytes_; }
+    size_t slot_bytes() const { return slotBytes_; }
+    unsigned int slots() const { return slots_; }
+
+    // Fonction qui soumet le partage du secret de length octets à input : les n parts sont écrites bout à bout à
+    // output. Renvoie false si les zones sortent de la case
+    bool split(int slot, size_t input, size_t length, int k, int n, size_t output);
+
+    // Fonction qui soumet la reconstruction à partir des k parts de length octets à input, d'abscisses x : le secret
+    // est écrit à output
+    bool combine(int slot, const int * x, int k, size_t input, size_t length, size_t output);
+
+    // Fonction qui attend le calcul de la case ; renvoie son statut (DEALER_ERROR_IO si le dealer est parti)
+    int wait(int slot);
+
+    // Fonction qui rend la case ; ses données ne sont pas effacées (close efface tout le segment)
+    void release(int slot);
+
+    void close();
+
+private:
+    channel_client(const channel_client &);
+    channel_client & operator=(const channel_client &);
+
+    void submit(int slot);
+
+    int fd_;                                // Socket d'attachement, gardée ouverte tant que le canal sert
+    unsigned char * base_;
+    size_t size_;
+    unsigned int slots_;
+    size_t slotBytes_;
+    channel_header * header_;
+    std::atomic<uint32_t> * ring_;
+    channel_slot * descriptors_;
+    unsigned char * data_;
+    std::atomic<unsigned int> hint_;        // Case où commence la recherche d'une case libre
+};
+
+#endif
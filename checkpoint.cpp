@@ -0,0 +1,107 @@
+#include "checkpoint.h"
+#include "bytes.h"
+#include "crc32c.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Format d'un point de reprise : magic, version, k, n, compression, taille des morceaux, options du flux,
+ * nombre de morceaux écrits, positions dans l'entrée (ou la sortie) et dans les fichiers de parts, identifiant
+ * du partage, puis le CRC-32C des octets précédents. La clé des plans aléatoires n'y figure pas : avec elle,
+ * une seule part suffirait à retrouver l'entrée ; un partage repris tire une nouvelle clé.
+ *
+ * L'état est écrit dans un fichier temporaire rendu durable puis renommé : une interruption pendant
+ * l'enregistrement laisse le point de reprise précédent intact.
+ */
+
+#define CHECKPOINT_MAGIC "TP7R"
+#define CHECKPOINT_VERSION 3
+#define CHECKPOINT_BYTES (40 + STREAM_SPLIT_ID_BYTES + 4)
+
+// Fonction qui rend durable le contenu d'un fichier (ou d'un répertoire) désigné par son chemin
+static bool checkpoint_sync_path(const char * path, int flags)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC | flags);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+}
+
+// Fonction qui lit le dernier point de reprise enregistré
+bool file_checkpoint::load(stream_state & state) const
+{
+    unsigned char bytes[CHECKPOINT_BYTES + 1];
+    int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    ssize_t size = read(fd, bytes, sizeof(bytes));
+    close(fd);
+
+    bool ok = size == CHECKPOINT_BYTES && memcmp(bytes, CHECKPOINT_MAGIC, 4) == 0 && load_uint(bytes + 4, 1) == CHECKPOINT_VERSION
+        && load_uint(bytes + CHECKPOINT_BYTES - 4, 4) == crc32c(0, bytes, CHECKPOINT_BYTES - 4);
+    if (ok)
+    {
+        memset(&state, 0, sizeof(state));
+        state.header.k = load_uint(bytes + 5, 1);
+        state.header.n = load_uint(bytes + 6, 1);
+        state.compress = load_uint(bytes + 7, 1) != 0;
+        state.header.chunkSize = load_uint(bytes + 8, 4);
+        state.header.flags = load_uint(bytes + 12, 4);
+        state.chunks = load_uint(bytes + 16, 8);
+        state.plainOffset = load_uint(bytes + 24, 8);
+        state.fileOffset = load_uint(bytes + 32, 8);
+        memcpy(state.header.splitId, bytes + 40, STREAM_SPLIT_ID_BYTES);
+    }
+    return ok;
+}
+
+// Fonction qui enregistre l'état : fichiers de sortie rendus durables, puis fichier temporaire renommé
+bool file_checkpoint::save(const stream_state & state)
+{
+    for (size_t i = 0; i < syncPaths_.size(); i++)
+    {
+        if (!checkpoint_sync_path(syncPaths_[i].c_str(), 0)) {
+            return false;
+        }
+    }
+
+    unsigned char bytes[CHECKPOINT_BYTES];
+    memcpy(bytes, CHECKPOINT_MAGIC, 4);
+    store_uint(bytes + 4, CHECKPOINT_VERSION, 1);
+    store_uint(bytes + 5, state.header.k, 1);
+    store_uint(bytes + 6, state.header.n, 1);
+    store_uint(bytes + 7, state.compress ? 1 : 0, 1);
+    store_uint(bytes + 8, state.header.chunkSize, 4);
+    store_uint(bytes + 12, state.header.flags, 4);
+    store_uint(bytes + 16, state.chunks, 8);
+    store_uint(bytes + 24, state.plainOffset, 8);
+    store_uint(bytes + 32, state.fileOffset, 8);
+    memcpy(bytes + 40, state.header.splitId, STREAM_SPLIT_ID_BYTES);
+    store_uint(bytes + CHECKPOINT_BYTES - 4, crc32c(0, bytes, CHECKPOINT_BYTES - 4), 4);
+
+    std::string temporary = path_ + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    bool ok = fd >= 0 && fchmod(fd, 0600) == 0 && write(fd, bytes, CHECKPOINT_BYTES) == CHECKPOINT_BYTES && fdatasync(fd) == 0;
+    if (fd >= 0 && close(fd) != 0) {
+        ok = false;
+    }
+
+    // Le renommage n'est durable qu'une fois le répertoire synchronisé
+    size_t slash = path_.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path_.substr(0, slash);
+    return ok && rename(temporary.c_str(), path_.c_str()) == 0 && checkpoint_sync_path(directory.c_str(), O_DIRECTORY);
+}
+
+// Fonction qui supprime le point de reprise une fois le travail terminé
+bool file_checkpoint::remove() const
+{
+    return unlink(path_.c_str()) == 0;
+}
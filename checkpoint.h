@@ -0,0 +1,32 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "stream.h"
+
+#include <string>
+#include <vector>
+
+// Point de reprise d'un partage ou d'une reconstruction dans un fichier (mode 0600) ; chaque enregistrement remplace
+// atomiquement le précédent
+class file_checkpoint : public stream_checkpoint
+{
+public:
+    explicit file_checkpoint(const std::string & path) : path_(path) {}
+
+    // Fonction qui lit le dernier point de reprise enregistré
+    bool load(stream_state & state) const;
+
+    bool save(const stream_state & state);
+
+    // Fonction qui ajoute un fichier à rendre durable avant chaque enregistrement (sortie d'une reconstruction)
+    void sync_file(const std::string & path) { syncPaths_.push_back(path); }
+
+    // Fonction qui supprime le point de reprise une fois le travail terminé
+    bool remove() const;
+
+private:
+    std::string path_;
+    std::vector<std::string> syncPaths_;
+};
+
+#endif
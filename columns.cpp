@@ -0,0 +1,521 @@
+#include "columns.h"
+#include "bytes.h"
+#include "crc32c.h"
+#include "queue.h"
+#include "stream.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include <fcntl.h>
+#include <openssl/crypto.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Disposition en colonnes : une colonne par participant, qui contient ses seules parts, à largeur fixe et
+ * rangées dans l'ordre des identifiants de secret ; un index commun donne ces identifiants. Un dépositaire
+ * ne reçoit que sa colonne, et la charger est une lecture séquentielle. La part du secret de rang i est à la
+ * position 32 + i * largeur de chaque colonne, sans table de positions.
+ *
+ * Les poids de Lagrange ne dépendent que des abscisses : les secrets d'un bloc se reconstruisent donc d'un
+ * seul appel à stream_reconstruct_chunk sur les k blocs de colonnes mis bout à bout, comme un seul morceau.
+ *
+ * Index : "TP7I", version, 3 octets nuls, largeur u32, secrets par bloc u32, nombre de secrets u64, CRC-32C
+ * (de l'en-tête puis des identifiants), puis les identifiants u64.
+ * Colonne : "TP7C", version, abscisse, 2 octets nuls, largeur u32, secrets par bloc u32, nombre de secrets u64,
+ * CRC de l'index, CRC-32C de l'en-tête, puis les parts, puis le CRC-32C de chaque bloc de parts.
+ */
+
+#define COLUMN_INDEX_MAGIC "TP7I"
+#define COLUMN_MAGIC "TP7C"
+#define COLUMN_VERSION 1
+#define COLUMN_INDEX_HEADER_BYTES 28
+#define COLUMN_HEADER_BYTES 32
+
+// Bloc de colonne en cours de lecture pour la reconstruction
+struct column_block
+{
+    std::vector<unsigned char> data;
+    int error;
+};
+
+static std::string column_index_path(const std::string & directory)
+{
+    return directory + "/index";
+}
+
+static std::string column_path(const std::string & directory, int x)
+{
+    return directory + "/column." + std::to_string(x);
+}
+
+// Fonction qui écrit entièrement length octets
+static bool column_write(int fd, const unsigned char * data, size_t length)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t written = write(fd, data + done, length - done);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        done += written;
+    }
+    return true;
+}
+
+// Fonction qui lit entièrement length octets à la position offset
+static bool column_read(int fd, unsigned char * data, size_t length, unsigned long long offset)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t got = pread(fd, data + done, length - done, offset + done);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        done += got;
+    }
+    return true;
+}
+
+// Fonction qui rend durable un fichier temporaire et le renomme en path
+static bool column_commit(int fd, const std::string & temporary, const std::string & path)
+{
+    bool ok = fdatasync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Fonction qui rend durable le contenu d'un répertoire (fichiers renommés)
+static bool column_sync_directory(const std::string & directory)
+{
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+}
+
+// Fonction qui construit l'en-tête de l'index et calcule son CRC
+static void column_make_index(unsigned char * header, column_index & index)
+{
+    memcpy(header, COLUMN_INDEX_MAGIC, 4);
+    store_uint(header + 4, COLUMN_VERSION, 1);
+    store_uint(header + 5, 0, 3);
+    store_uint(header + 8, index.width, 4);
+    store_uint(header + 12, index.blockSecrets, 4);
+    store_uint(header + 16, index.ids.size(), 8);
+
+    std::vector<unsigned char> ids(index.ids.size() * 8);
+    for (size_t i = 0; i < index.ids.size(); i++) {
+        store_uint(ids.data() + i * 8, index.ids[i], 8);
+    }
+    index.crc = crc32c(crc32c(0, header, 24), ids.data(), ids.size());
+    store_uint(header + 24, index.crc, 4);
+}
+
+// Fonction qui écrit la colonne du participant x : les parts sont lues dans le coffre dans l'ordre de l'index
+static int column_write_column(share_vault & vault, const std::string & directory, const column_index & index, int x,
+                               unsigned long long & failedId)
+{
+    unsigned char header[COLUMN_HEADER_BYTES];
+    memcpy(header, COLUMN_MAGIC, 4);
+    store_uint(header + 4, COLUMN_VERSION, 1);
+    store_uint(header + 5, x, 1);
+    store_uint(header + 6, 0, 2);
+    store_uint(header + 8, index.width, 4);
+    store_uint(header + 12, index.blockSecrets, 4);
+    store_uint(header + 16, index.ids.size(), 8);
+    store_uint(header + 24, index.crc, 4);
+    store_uint(header + 28, crc32c(0, header, 28), 4);
+
+    std::string path = column_path(directory, x), temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return COLUMN_ERROR_IO;
+    }
+
+    int error = column_write(fd, header, sizeof(header)) ? COLUMN_OK : COLUMN_ERROR_IO;
+    std::vector<unsigned char> block((size_t) index.blockSecrets * index.width), share, table;
+    for (size_t first = 0; first < index.ids.size() && error == COLUMN_OK; first += index.blockSecrets)
+    {
+        size_t count = std::min((size_t) index.blockSecrets, index.ids.size() - first);
+        for (size_t i = 0; i < count && error == COLUMN_OK; i++)
+        {
+            if (vault.get(index.ids[first + i], x, share) != VAULT_OK || share.size() != index.width)
+            {
+                failedId = index.ids[first + i];
+                error = COLUMN_ERROR_MISSING;
+            } else {
+                memcpy(block.data() + i * index.width, share.data(), index.width);
+            }
+        }
+
+        if (error == COLUMN_OK)
+        {
+            size_t length = count * index.width;
+            table.resize(table.size() + 4);
+            store_uint(table.data() + table.size() - 4, crc32c(0, block.data(), length), 4);
+            if (!column_write(fd, block.data(), length)) {
+                error = COLUMN_ERROR_IO;
+            }
+        }
+    }
+    OPENSSL_cleanse(block.data(), block.size());
+    OPENSSL_cleanse(share.data(), share.size());
+
+    if (error == COLUMN_OK && !column_write(fd, table.data(), table.size())) {
+        error = COLUMN_ERROR_IO;
+    }
+    if (error != COLUMN_OK)
+    {
+        close(fd);
+        unlink(temporary.c_str());
+        return error;
+    }
+    return column_commit(fd, temporary, path) ? COLUMN_OK : COLUMN_ERROR_IO;
+}
+
+// Fonction qui exporte les parts des participants 1 ... n du coffre en une colonne par participant dans directory
+// Les colonnes sont écrites avant l'index : un export interrompu laisse l'index précédent, que les nouvelles
+// colonnes ne désignent pas (CRC de l'index différent)
+int column_export(share_vault & vault, const std::string & directory, int n, unsigned long long & failedId)
+{
+    if (n < 1 || n > 255) {
+        return COLUMN_ERROR_FORMAT;
+    }
+    if (mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) {
+        return COLUMN_ERROR_IO;
+    }
+
+    column_index index;
+    vault.ids(1, index.ids);
+    std::vector<unsigned char> share;
+    index.width = 0;
+    if (!index.ids.empty())
+    {
+        if (vault.get(index.ids[0], 1, share) != VAULT_OK) {
+            failedId = index.ids[0];
+            return COLUMN_ERROR_MISSING;
+        }
+        index.width = share.size();
+        OPENSSL_cleanse(share.data(), share.size());
+    }
+    index.blockSecrets = std::max(1U, (unsigned int) (COLUMN_BLOCK_BYTES / std::max(1U, index.width)));
+
+    unsigned char header[COLUMN_INDEX_HEADER_BYTES];
+    column_make_index(header, index);
+
+    // Un secret qui n'a pas ses n parts est signalé à la colonne où sa part manque ; une part d'un secret absent
+    // de la première colonne est signalée ici
+    for (int x = 2; x <= n; x++)
+    {
+        std::vector<unsigned long long> ids;
+        vault.ids(x, ids);
+        std::vector<unsigned long long>::iterator extra = std::find_if(ids.begin(), ids.end(), [&index](unsigned long long id) {
+            return !std::binary_search(index.ids.begin(), index.ids.end(), id);
+        });
+        if (extra != ids.end()) {
+            failedId = *extra;
+            return COLUMN_ERROR_MISSING;
+        }
+    }
+
+    for (int x = 1; x <= n; x++)
+    {
+        int error = column_write_column(vault, directory, index, x, failedId);
+        if (error != COLUMN_OK) {
+            return error;
+        }
+    }
+
+    std::vector<unsigned char> ids(index.ids.size() * 8);
+    for (size_t i = 0; i < index.ids.size(); i++) {
+        store_uint(ids.data() + i * 8, index.ids[i], 8);
+    }
+    std::string path = column_index_path(directory), temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return COLUMN_ERROR_IO;
+    }
+    if (!column_write(fd, header, sizeof(header)) || !column_write(fd, ids.data(), ids.size()))
+    {
+        close(fd);
+        unlink(temporary.c_str());
+        return COLUMN_ERROR_IO;
+    }
+    return column_commit(fd, temporary, path) && column_sync_directory(directory) ? COLUMN_OK : COLUMN_ERROR_IO;
+}
+
+// Fonction qui lit l'index des colonnes de directory
+int column_read_index(column_index & index, const std::string & directory)
+{
+    int fd = open(column_index_path(directory).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return COLUMN_ERROR_IO;
+    }
+
+    unsigned char header[COLUMN_INDEX_HEADER_BYTES];
+    struct stat info;
+    if (!column_read(fd, header, sizeof(header), 0) || fstat(fd, &info) != 0)
+    {
+        close(fd);
+        return COLUMN_ERROR_IO;
+    }
+    unsigned long long count = load_uint(header + 16, 8);
+    if (memcmp(header, COLUMN_INDEX_MAGIC, 4) != 0 || load_uint(header + 4, 1) != COLUMN_VERSION || load_uint(header + 12, 4) == 0
+        || (unsigned long long) info.st_size != COLUMN_INDEX_HEADER_BYTES + count * 8)
+    {
+        close(fd);
+        return COLUMN_ERROR_FORMAT;
+    }
+
+    std::vector<unsigned char> ids(count * 8);
+    bool ok = column_read(fd, ids.data(), ids.size(), COLUMN_INDEX_HEADER_BYTES);
+    close(fd);
+    if (!ok) {
+        return COLUMN_ERROR_IO;
+    }
+
+    index.width = load_uint(header + 8, 4);
+    index.blockSecrets = load_uint(header + 12, 4);
+    index.crc = load_uint(header + 24, 4);
+    if (crc32c(crc32c(0, header, 24), ids.data(), ids.size()) != index.crc) {
+        return COLUMN_ERROR_CHECKSUM;
+    }
+    index.ids.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        index.ids[i] = load_uint(ids.data() + i * 8, 8);
+    }
+    return COLUMN_OK;
+}
+
+// Fonction qui ouvre la colonne du participant x, vérifie qu'elle correspond à l'index et lit sa table de CRC
+static int column_open(int & fd, std::vector<unsigned int> & table, const std::string & directory, const column_index & index, int x)
+{
+    fd = open(column_path(directory, x).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return COLUMN_ERROR_IO;
+    }
+
+    unsigned long long count = index.ids.size(), length = count * index.width;
+    size_t blocks = (count + index.blockSecrets - 1) / index.blockSecrets;
+    unsigned char header[COLUMN_HEADER_BYTES];
+    struct stat info;
+    int error = column_read(fd, header, sizeof(header), 0) && fstat(fd, &info) == 0 ? COLUMN_OK : COLUMN_ERROR_IO;
+    if (error == COLUMN_OK
+        && (memcmp(header, COLUMN_MAGIC, 4) != 0 || load_uint(header + 4, 1) != COLUMN_VERSION || (int) load_uint(header + 5, 1) != x
+            || load_uint(header + 8, 4) != index.width || load_uint(header + 12, 4) != index.blockSecrets || load_uint(header + 16, 8) != count
+            || load_uint(header + 24, 4) != index.crc || load_uint(header + 28, 4) != crc32c(0, header, 28)
+            || (unsigned long long) info.st_size != COLUMN_HEADER_BYTES + length + blocks * 4))
+    {
+        error = COLUMN_ERROR_FORMAT;
+    }
+
+    std::vector<unsigned char> bytes(blocks * 4);
+    if (error == COLUMN_OK && !column_read(fd, bytes.data(), bytes.size(), COLUMN_HEADER_BYTES + length)) {
+        error = COLUMN_ERROR_IO;
+    }
+    if (error != COLUMN_OK)
+    {
+        close(fd);
+        fd = -1;
+        return error;
+    }
+
+    table.resize(blocks);
+    for (size_t b = 0; b < blocks; b++) {
+        table[b] = load_uint(bytes.data() + b * 4, 4);
+    }
+
+    // Les parts sont lues du début à la fin : lecture anticipée large
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return COLUMN_OK;
+}
+
+// Fonction qui lit et vérifie le bloc b d'une colonne ouverte par column_open
+static int column_read_block(std::vector<unsigned char> & data, int fd, const std::vector<unsigned int> & table, const column_index & index,
+                             size_t b)
+{
+    size_t first = b * index.blockSecrets;
+    size_t length = std::min((size_t) index.blockSecrets, index.ids.size() - first) * index.width;
+    data.resize(length);
+    if (!column_read(fd, data.data(), length, COLUMN_HEADER_BYTES + (unsigned long long) first * index.width)) {
+        return COLUMN_ERROR_IO;
+    }
+    return crc32c(0, data.data(), length) == table[b] ? COLUMN_OK : COLUMN_ERROR_CHECKSUM;
+}
+
+// Fonction qui charge entièrement la colonne du participant x (lecture séquentielle)
+int column_load(std::vector<unsigned char> & values, const std::string & directory, const column_index & index, int x)
+{
+    int fd;
+    std::vector<unsigned int> table;
+    int error = column_open(fd, table, directory, index, x);
+    if (error != COLUMN_OK) {
+        return error;
+    }
+
+    values.clear();
+    values.reserve(index.ids.size() * index.width);
+    std::vector<unsigned char> block;
+    for (size_t b = 0; b < table.size() && error == COLUMN_OK; b++)
+    {
+        error = column_read_block(block, fd, table, index, b);
+        values.insert(values.end(), block.begin(), block.end());
+    }
+    OPENSSL_cleanse(block.data(), block.size());
+    close(fd);
+    return error;
+}
+
+// Fonction qui reconstruit tous les secrets de l'index à partir des colonnes des k participants x
+// Un thread par colonne lit ses blocs d'avance (et vérifie leur CRC) pendant que le thread appelant reconstruit
+int column_combine(std::ostream & output, const std::string & directory, const int * x, int k)
+{
+    column_index index;
+    int error = column_read_index(index, directory);
+    if (error != COLUMN_OK) {
+        return error;
+    }
+    if (k < 1) {
+        return COLUMN_ERROR_FORMAT;
+    }
+    for (int i = 0; i < k; i++)
+    {
+        if (x[i] < 1 || x[i] > 255 || std::count(x, x + k, x[i]) != 1) {
+            return COLUMN_ERROR_FORMAT;
+        }
+    }
+
+    std::vector<int> fds(k, -1);
+    std::vector<std::vector<unsigned int> > tables(k);
+    for (int i = 0; i < k && error == COLUMN_OK; i++) {
+        error = column_open(fds[i], tables[i], directory, index, x[i]);
+    }
+
+    std::vector<std::unique_ptr<blocking_queue<column_block *> > > spare, ready;
+    std::vector<column_block> blocks(k * COLUMN_READ_AHEAD);
+    std::vector<std::thread> readers;
+    if (error == COLUMN_OK)
+    {
+        for (int i = 0; i < k; i++)
+        {
+            spare.push_back(std::unique_ptr<blocking_queue<column_block *> >(new blocking_queue<column_block *>(COLUMN_READ_AHEAD)));
+            ready.push_back(std::unique_ptr<blocking_queue<column_block *> >(new blocking_queue<column_block *>(COLUMN_READ_AHEAD)));
+            for (int j = 0; j < COLUMN_READ_AHEAD; j++) {
+                spare[i]->push(&blocks[i * COLUMN_READ_AHEAD + j]);
+            }
+        }
+
+        for (int i = 0; i < k; i++)
+        {
+            readers.push_back(std::thread([&, i]() {
+                for (size_t b = 0; b < tables[i].size(); b++)
+                {
+                    column_block * block;
+                    if (!spare[i]->pop(block)) {
+                        break;
+                    }
+                    block->error = column_read_block(block->data, fds[i], tables[i], index, b);
+                    if (!ready[i]->push(block) || block->error != COLUMN_OK) {
+                        break;
+                    }
+                }
+            }));
+        }
+
+        std::vector<unsigned char> weights(k), data;
+        std::vector<column_block *> current(k);
+        std::vector<const unsigned char *> shares(k);
+        stream_lagrange_weights(weights.data(), x, k, 0);
+
+        size_t blockCount = tables[0].size();
+        for (size_t b = 0; b < blockCount && error == COLUMN_OK; b++)
+        {
+            for (int i = 0; i < k; i++)
+            {
+                if (!ready[i]->pop(current[i])) {
+                    error = COLUMN_ERROR_IO;
+                    break;
+                }
+                if (error == COLUMN_OK) {
+                    error = current[i]->error;
+                }
+                shares[i] = current[i]->data.data();
+            }
+            if (error != COLUMN_OK) {
+                break;
+            }
+
+            // Les blocs de même rang couvrent les mêmes secrets : un seul appel pour tout le bloc
+            size_t length = current[0]->data.size();
+            data.resize(length);
+            stream_reconstruct_chunk(data.data(), shares.data(), weights.data(), length, k, NULL);
+            output.write((const char *) data.data(), length);
+            if (!output) {
+                error = COLUMN_ERROR_IO;
+            }
+
+            for (int i = 0; i < k; i++) {
+                spare[i]->push(current[i]);
+            }
+        }
+        OPENSSL_cleanse(data.data(), data.size());
+
+        for (int i = 0; i < k; i++)
+        {
+            spare[i]->close();
+            ready[i]->close();
+        }
+        for (int i = 0; i < k; i++) {
+            readers[i].join();
+        }
+    }
+
+    for (size_t i = 0; i < blocks.size(); i++) {
+        OPENSSL_cleanse(blocks[i].data.data(), blocks[i].data.size());
+    }
+    for (int i = 0; i < k; i++)
+    {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
+    }
+    if (error == COLUMN_OK && !output.flush()) {
+        error = COLUMN_ERROR_IO;
+    }
+    return error;
+}
+
+// Fonction qui donne le message d'une erreur des colonnes
+const char * column_error_string(int error)
+{
+    switch (error)
+    {
+        case COLUMN_OK: return "ok";
+        case COLUMN_ERROR_IO: return "read or write error";
+        case COLUMN_ERROR_FORMAT: return "invalid column, or column of another index";
+        case COLUMN_ERROR_CHECKSUM: return "corrupted column block";
+        case COLUMN_ERROR_MISSING: return "missing share, or share of another length";
+        default: return "unknown error";
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef COLUMNS_H
+#define COLUMNS_H
+
+#include "vault.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define COLUMN_BLOCK_BYTES (1 << 20)    // Taille visée d'un bloc de colonne (lecture et CRC-32C par bloc)
+#define COLUMN_READ_AHEAD 2             // Blocs lus d'avance par colonne pendant la reconstruction
+
+// Codes de retour des colonnes de parts
+#define COLUMN_OK 0
+#define COLUMN_ERROR_IO 1           // Lecture ou écriture impossible
+#define COLUMN_ERROR_FORMAT 2       // Fichier invalide, ou colonne d'un autre index
+#define COLUMN_ERROR_CHECKSUM 3     // Bloc altéré
+#define COLUMN_ERROR_MISSING 4      // Part absente du coffre ou de taille différente des autres
+
+// Index partagé des colonnes : identifiants des secrets dans l'ordre croissant et largeur commune des parts
+struct column_index
+{
+    unsigned int width;                     // Taille d'une part (octets par secret dans chaque colonne)
+    unsigned int blockSecrets;              // Secrets par bloc
+    unsigned int crc;                       // CRC-32C de l'index, recopié dans chaque colonne pour les lier
+    std::vector<unsigned long long> ids;    // Identifiant du secret de rang i
+};
+
+// Fonction qui exporte les parts des participants 1 ... n du coffre en une colonne par participant dans directory
+// Chaque secret de l'index doit avoir ses n parts, toutes de la même taille ; failedId reçoit sinon l'identifiant fautif
+int column_export(share_vault & vault, const std::string & directory, int n, unsigned long long & failedId);
+
+// Fonction qui lit l'index des colonnes de directory
+int column_read_index(column_index & index, const std::string & directory);
+
+// Fonction qui charge entièrement la colonne du participant x (lecture séquentielle) : values reçoit
+// index.ids.size() parts de index.width octets, dans l'ordre de l'index
+int column_load(std::vector<unsigned char> & values, const std::string & directory, const column_index & index, int x);
+
+// Fonction qui reconstruit tous les secrets de l'index à partir des colonnes des k participants x, lues en parallèle
+// bloc par bloc ; output reçoit les secrets dans l'ordre de l'index, index.width octets chacun
+int column_combine(std::ostream & output, const std::string & directory, const int * x, int k);
+
+// Fonction qui donne le message d'une erreur des colonnes
+const char * column_error_string(int error);
+
+#endif
@@ -0,0 +1,1501 @@
+#include "commands.h"
+#include "async.h"
+#include "channel.h"
+#include "checkpoint.h"
+#include "columns.h"
+#include "dealer.h"
+#include "service.h"
+#include "hybrid.h"
+#include "journal.h"
+#include "quorum.h"
+#include "sink.h"
+#include "stream.h"
+#include "vault.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <gmp.h>
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <unistd.h>
+
+// Fonction qui initialise l'état aléatoire GMP avec une graine de 256 bits tirée par OpenSSL
+static bool seed_random_state(gmp_randstate_t gmpRandState)
+{
+    unsigned char bytes[32];
+    if (RAND_bytes(bytes, sizeof(bytes)) != 1) {
+        return false;
+    }
+
+    mpz_t seed;
+    mpz_init(seed);
+    mpz_import(seed, sizeof(bytes), 1, 1, 1, 0, bytes);
+    gmp_randseed(gmpRandState, seed);
+    mpz_clear(seed);
+    return true;
+}
+
+// Fonction qui retire l'option donnée des arguments et indique si elle était présente
+static bool take_option(int & argc, char ** argv, const char * option)
+{
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], option) == 0)
+        {
+            for (int j = i; j + 1 < argc; j++) {
+                argv[j] = argv[j + 1];
+            }
+            argc--;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Fonction qui retire l'option donnée et sa valeur des arguments et renvoie la valeur, NULL si elle est absente
+static const char * take_option_value(int & argc, char ** argv, const char * option)
+{
+    for (int i = 2; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], option) == 0)
+        {
+            const char * value = argv[i + 1];
+            for (int j = i; j + 2 < argc; j++) {
+                argv[j] = argv[j + 2];
+            }
+            argc -= 2;
+            return value;
+        }
+    }
+    return NULL;
+}
+
+// Fonction qui lit la clé d'authentification des parts ; avec create, un fichier absent est créé (mode 0600) avec une clé neuve
+static bool load_mac_key(const char * path, unsigned char * key, bool create)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 && create)
+    {
+        fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        bool ok = fd >= 0 && RAND_bytes(key, STREAM_MAC_KEY_BYTES) == 1 && write(fd, key, STREAM_MAC_KEY_BYTES) == STREAM_MAC_KEY_BYTES;
+        if (fd >= 0 && close(fd) != 0) {
+            ok = false;
+        }
+        return ok;
+    }
+    if (fd < 0) {
+        return false;
+    }
+
+    // La clé doit faire exactement STREAM_MAC_KEY_BYTES octets
+    unsigned char extra;
+    bool ok = read(fd, key, STREAM_MAC_KEY_BYTES) == STREAM_MAC_KEY_BYTES && read(fd, &extra, 1) == 0;
+    close(fd);
+    return ok;
+}
+
+// Fonction qui lit un fichier entier en mémoire
+static bool read_file(const char * path, std::vector<unsigned char> & data)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+// Fonction qui écrit un fichier entier
+static bool write_file(const char * path, const std::vector<unsigned char> & data)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write((const char *) data.data(), data.size());
+    return out.good();
+}
+
+// tp7 hybrid-split <entrée | -> <préfixe> <k> <n> [chacha20] [taille des morceaux]
+static int command_hybrid_split(int argc, char ** argv)
+{
+    if (argc < 6) {
+        std::cerr << "usage: " << argv[0] << " hybrid-split <input | -> <prefix> <k> <n> [chacha20] [chunk size]" << std::endl;
+        return 2;
+    }
+
+    int k = atoi(argv[4]);
+    int n = atoi(argv[5]);
+    int cipher = argc > 6 && strcmp(argv[6], "chacha20") == 0 ? HYBRID_CHACHA20_POLY1305 : HYBRID_AES_256_GCM;
+    size_t chunkSize = argc > 7 ? strtoull(argv[7], NULL, 10) : HYBRID_DEFAULT_CHUNK;
+
+    std::ifstream file;
+    std::istream * input = &std::cin;
+    if (strcmp(argv[2], "-") != 0)
+    {
+        file.open(argv[2], std::ios::binary);
+        if (!file) {
+            std::cerr << "cannot read " << argv[2] << std::endl;
+            return 1;
+        }
+        input = &file;
+    }
+
+    // Une part par fichier : <préfixe>.1 ... <préfixe>.n, écrites au fil des morceaux
+    std::vector<std::ofstream *> files;
+    bool ok = n >= 1 && n <= 255;
+    for (int i = 0; ok && i < n; i++)
+    {
+        std::string path = std::string(argv[3]) + "." + std::to_string(i + 1);
+        files.push_back(new std::ofstream(path.c_str(), std::ios::binary | std::ios::trunc));
+        if (!*files.back()) {
+            std::cerr << "cannot create " << path << std::endl;
+            ok = false;
+        }
+    }
+
+    gmp_randstate_t gmpRandState;
+    gmp_randinit_default(gmpRandState);
+
+    std::vector<std::ostream *> outputs(files.begin(), files.end());
+    ok = ok && seed_random_state(gmpRandState) && hybrid_split(*input, outputs, k, chunkSize, cipher, gmpRandState);
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        files[i]->close();
+        ok = ok && !files[i]->fail();
+        delete files[i];
+    }
+    if (!ok) {
+        std::cerr << "split failed" << std::endl;
+    }
+
+    gmp_randclear(gmpRandState);
+    return ok ? 0 : 1;
+}
+
+// tp7 hybrid-combine <sortie | -> <part> ... (au moins k parts)
+static int command_hybrid_combine(int argc, char ** argv)
+{
+    if (argc < 4) {
+        std::cerr << "usage: " << argv[0] << " hybrid-combine <output | -> <share> ..." << std::endl;
+        return 2;
+    }
+
+    std::vector<std::ifstream *> files;
+    for (int i = 3; i < argc; i++)
+    {
+        files.push_back(new std::ifstream(argv[i], std::ios::binary));
+        if (!*files.back()) {
+            std::cerr << "cannot read " << argv[i] << std::endl;
+        }
+    }
+
+    std::ofstream file;
+    std::ostream * output = &std::cout;
+    if (strcmp(argv[2], "-") != 0)
+    {
+        file.open(argv[2], std::ios::binary | std::ios::trunc);
+        output = &file;
+    }
+
+    std::vector<std::istream *> inputs(files.begin(), files.end());
+    unsigned long long failedChunk = 0;
+    bool ok = hybrid_combine(inputs, *output, failedChunk);
+    output->flush();
+    ok = ok && output->good();
+    if (!ok) {
+        std::cerr << "combine failed at chunk " << failedChunk << std::endl;
+    }
+
+    for (size_t i = 0; i < files.size(); i++) {
+        delete files[i];
+    }
+    return ok ? 0 : 1;
+}
+
+// tp7 split [--deflate] [--direct] [--mac-key <clé>] [--checkpoint | --resume] <entrée | -> <préfixe> <k> <n> [taille des morceaux] [carte des morceaux]
+// Avec --checkpoint, l'état est enregistré régulièrement dans <préfixe>.checkpoint ; --resume reprend à partir de cet état
+static int command_split(int argc, char ** argv)
+{
+    bool compress = take_option(argc, argv, "--deflate");
+    bool direct = take_option(argc, argv, "--direct");
+    const char * keyPath = take_option_value(argc, argv, "--mac-key");
+    bool resume = take_option(argc, argv, "--resume");
+    bool checkpointing = take_option(argc, argv, "--checkpoint") || resume;
+    if (argc < 6) {
+        std::cerr << "usage: " << argv[0] << " split [--deflate] [--direct] [--mac-key <key file>] [--checkpoint | --resume] <input | -> <prefix> <k> <n>"
+                  << " [chunk size] [chunk map]" << std::endl;
+        return 2;
+    }
+
+    unsigned char macKey[STREAM_MAC_KEY_BYTES];
+    if (keyPath != NULL && !load_mac_key(keyPath, macKey, true)) {
+        std::cerr << "cannot read or create key " << keyPath << std::endl;
+        return 1;
+    }
+
+    int k = atoi(argv[4]);
+    int n = atoi(argv[5]);
+    size_t chunkSize = argc > 6 ? strtoull(argv[6], NULL, 10) : STREAM_DEFAULT_CHUNK;
+    if (chunkSize == 0 || chunkSize > STREAM_MAX_CHUNK || !stream_chunk_fits(chunkSize, n)) {
+        std::cerr << "chunk size must be between 1 and " << STREAM_MAX_CHUNK << " bytes, and two chunks with their n shares must fit in "
+                  << (STREAM_MEMORY_BUDGET >> 20) << " MiB" << std::endl;
+        return 2;
+    }
+
+    std::ifstream file;
+    std::istream * input = &std::cin;
+    if (strcmp(argv[2], "-") != 0)
+    {
+        file.open(argv[2], std::ios::binary);
+        if (!file) {
+            std::cerr << "cannot read " << argv[2] << std::endl;
+            return 1;
+        }
+        input = &file;
+    }
+
+    // Une part par fichier : <préfixe>.1 ... <préfixe>.n
+    std::vector<std::string> paths;
+    for (int i = 0; i < n && n <= 255; i++) {
+        paths.push_back(std::string(argv[3]) + "." + std::to_string(i + 1));
+    }
+
+    // Reprise : mêmes paramètres que le partage interrompu, index des morceaux déjà écrits relu dans la première part
+    file_checkpoint checkpoint(std::string(argv[3]) + ".checkpoint");
+    stream_state state;
+    std::vector<stream_index_entry> index;
+    if (resume)
+    {
+        std::ifstream first(paths.empty() ? "" : paths[0].c_str(), std::ios::binary);
+        if (!checkpoint.load(state)) {
+            std::cerr << "no usable checkpoint for " << argv[3] << std::endl;
+            return 1;
+        }
+        if (state.header.k != k || state.header.n != n || state.header.chunkSize != chunkSize || state.compress != compress
+            || ((state.header.flags & STREAM_FLAG_MAC) != 0) != (keyPath != NULL) || !stream_scan_records(index, first, state)) {
+            std::cerr << "checkpoint does not match the arguments or the share files" << std::endl;
+            return 1;
+        }
+    }
+
+    file_sink sink;
+    bool ok = n >= 1 && n <= 255 && sink.open(paths, direct, resume ? state.fileOffset : 0);
+    if (n >= 1 && !ok) {
+        std::cerr << "cannot create " << argv[3] << ".*" << std::endl;
+    }
+
+    std::vector<unsigned char> digests;
+    ok = ok && stream_split(*input, sink, k, n, chunkSize, compress, argc > 7 ? &digests : NULL, keyPath != NULL ? macKey : NULL,
+                            checkpointing ? &checkpoint : NULL, resume ? &state : NULL, resume ? &index : NULL);
+    OPENSSL_cleanse(macKey, STREAM_MAC_KEY_BYTES);
+    if (!ok) {
+        std::cerr << "split failed" << std::endl;
+    }
+
+    if (ok && argc > 7)
+    {
+        std::ofstream map(argv[7], std::ios::binary | std::ios::trunc);
+        if (!stream_write_map(map, digests)) {
+            std::cerr << "cannot write " << argv[7] << std::endl;
+            ok = false;
+        }
+    }
+
+    // Le point de reprise est gardé après un échec
+    if (ok && checkpointing) {
+        checkpoint.remove();
+    }
+    return ok ? 0 : 1;
+}
+
+// tp7 combine [--mac-key <clé>] [--checkpoint | --resume] <sortie | -> <part> ... (au moins k parts, les suivantes servent à la vérification)
+// Avec --checkpoint, l'état est enregistré régulièrement dans <sortie>.checkpoint ; --resume reprend à partir de cet état
+static int command_combine(int argc, char ** argv)
+{
+    const char * keyPath = take_option_value(argc, argv, "--mac-key");
+    bool resume = take_option(argc, argv, "--resume");
+    bool checkpointing = take_option(argc, argv, "--checkpoint") || resume;
+    if (argc < 4 || (checkpointing && strcmp(argv[2], "-") == 0)) {
+        std::cerr << "usage: " << argv[0] << " combine [--mac-key <key file>] [--checkpoint | --resume] <output | -> <share> ..." << std::endl;
+        return 2;
+    }
+
+    unsigned char macKey[STREAM_MAC_KEY_BYTES];
+    if (keyPath != NULL && !load_mac_key(keyPath, macKey, false)) {
+        std::cerr << "cannot read key " << keyPath << std::endl;
+        return 1;
+    }
+
+    std::vector<std::ifstream *> files;
+    for (int i = 3; i < argc; i++)
+    {
+        files.push_back(new std::ifstream(argv[i], std::ios::binary));
+        if (!*files.back()) {
+            std::cerr << "cannot read " << argv[i] << std::endl;
+        }
+    }
+
+    // Reprise : la sortie est tronquée au point de reprise et complétée
+    file_checkpoint checkpoint(std::string(argv[2]) + ".checkpoint");
+    checkpoint.sync_file(argv[2]);
+    stream_state state;
+    if (resume && (!checkpoint.load(state) || truncate(argv[2], state.plainOffset) != 0)) {
+        std::cerr << "no usable checkpoint for " << argv[2] << std::endl;
+        for (size_t i = 0; i < files.size(); i++) {
+            delete files[i];
+        }
+        return 1;
+    }
+
+    std::ofstream file;
+    std::ostream * output = &std::cout;
+    if (strcmp(argv[2], "-") != 0)
+    {
+        file.open(argv[2], std::ios::binary | (resume ? std::ios::app : std::ios::trunc));
+        output = &file;
+    }
+
+    std::vector<std::istream *> inputs(files.begin(), files.end());
+    unsigned long long failedChunk = 0;
+    int error = stream_combine(inputs, *output, failedChunk, keyPath != NULL ? macKey : NULL, checkpointing ? &checkpoint : NULL,
+                               resume ? &state : NULL);
+    OPENSSL_cleanse(macKey, STREAM_MAC_KEY_BYTES);
+    if (error != STREAM_OK) {
+        std::cerr << "combine failed at chunk " << failedChunk << ": " << stream_error_string(error) << std::endl;
+    }
+
+    for (size_t i = 0; i < files.size(); i++) {
+        delete files[i];
+    }
+    if (error == STREAM_OK && checkpointing) {
+        checkpoint.remove();
+    }
+    return error == STREAM_OK ? 0 : 1;
+}
+
+// tp7 update [--deflate] [--mac-key <clé>] <entrée | -> <préfixe> <carte des morceaux> : met à jour les n parts <préfixe>.i sur place
+static int command_update(int argc, char ** argv)
+{
+    bool compress = take_option(argc, argv, "--deflate");
+    const char * keyPath = take_option_value(argc, argv, "--mac-key");
+    if (argc < 5) {
+        std::cerr << "usage: " << argv[0] << " update [--deflate] [--mac-key <key file>] <input | -> <prefix> <chunk map>" << std::endl;
+        return 2;
+    }
+
+    unsigned char macKey[STREAM_MAC_KEY_BYTES];
+    if (keyPath != NULL && !load_mac_key(keyPath, macKey, false)) {
+        std::cerr << "cannot read key " << keyPath << std::endl;
+        return 1;
+    }
+
+    std::vector<unsigned char> digests;
+    std::ifstream mapIn(argv[4], std::ios::binary);
+    if (!stream_read_map(digests, mapIn)) {
+        std::cerr << "invalid chunk map " << argv[4] << std::endl;
+        return 1;
+    }
+    mapIn.close();
+
+    std::ifstream file;
+    std::istream * input = &std::cin;
+    if (strcmp(argv[2], "-") != 0)
+    {
+        file.open(argv[2], std::ios::binary);
+        if (!file) {
+            std::cerr << "cannot read " << argv[2] << std::endl;
+            return 1;
+        }
+        input = &file;
+    }
+
+    // Les fichiers <préfixe>.1, <préfixe>.2 ... existants, tous nécessaires
+    std::vector<std::string> paths;
+    std::vector<std::fstream *> files;
+    for (int i = 1; i <= 255; i++)
+    {
+        std::string path = std::string(argv[3]) + "." + std::to_string(i);
+        std::fstream * share = new std::fstream(path.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+        if (!*share) {
+            delete share;
+            break;
+        }
+        paths.push_back(path);
+        files.push_back(share);
+    }
+
+    std::vector<std::iostream *> shares(files.begin(), files.end());
+    unsigned long long fileSize = 0, changedChunks = 0;
+    int error = stream_update(*input, shares, compress, digests, fileSize, changedChunks, keyPath != NULL ? macKey : NULL);
+    OPENSSL_cleanse(macKey, STREAM_MAC_KEY_BYTES);
+    for (size_t i = 0; i < files.size(); i++) {
+        delete files[i];
+    }
+
+    if (error != STREAM_OK) {
+        std::cerr << "update failed: " << stream_error_string(error) << std::endl;
+        return 1;
+    }
+
+    // Les fichiers raccourcissent si la nouvelle version est plus courte
+    bool ok = true;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        if (truncate(paths[i].c_str(), fileSize) != 0) {
+            std::cerr << "cannot truncate " << paths[i] << std::endl;
+            ok = false;
+        }
+    }
+
+    std::ofstream mapOut(argv[4], std::ios::binary | std::ios::trunc);
+    if (!stream_write_map(mapOut, digests)) {
+        std::cerr << "cannot write " << argv[4] << std::endl;
+        ok = false;
+    }
+
+    std::cerr << changedChunks << " chunk(s) shared again" << std::endl;
+    return ok ? 0 : 1;
+}
+
+// tp7 extract [--mac-key <clé>] <sortie | -> <position> <taille> <part> ... (au moins k parts, les suivantes servent à la vérification)
+static int command_extract(int argc, char ** argv)
+{
+    const char * keyPath = take_option_value(argc, argv, "--mac-key");
+    if (argc < 6) {
+        std::cerr << "usage: " << argv[0] << " extract [--mac-key <key file>] <output | -> <offset> <length> <share> ..." << std::endl;
+        return 2;
+    }
+
+    unsigned char macKey[STREAM_MAC_KEY_BYTES];
+    if (keyPath != NULL && !load_mac_key(keyPath, macKey, false)) {
+        std::cerr << "cannot read key " << keyPath << std::endl;
+        return 1;
+    }
+
+    unsigned long long offset = strtoull(argv[3], NULL, 10);
+    unsigned long long length = strtoull(argv[4], NULL, 10);
+
+    std::vector<std::ifstream *> files;
+    for (int i = 5; i < argc; i++)
+    {
+        files.push_back(new std::ifstream(argv[i], std::ios::binary));
+        if (!*files.back()) {
+            std::cerr << "cannot read " << argv[i] << std::endl;
+        }
+    }
+
+    std::ofstream file;
+    std::ostream * output = &std::cout;
+    if (strcmp(argv[2], "-") != 0)
+    {
+        file.open(argv[2], std::ios::binary | std::ios::trunc);
+        output = &file;
+    }
+
+    std::vector<std::istream *> inputs(files.begin(), files.end());
+    unsigned long long failedChunk = 0;
+    int error = stream_extract(inputs, *output, offset, length, failedChunk, keyPath != NULL ? macKey : NULL);
+    OPENSSL_cleanse(macKey, STREAM_MAC_KEY_BYTES);
+    if (error != STREAM_OK) {
+        std::cerr << "extract failed at chunk " << failedChunk << ": " << stream_error_string(error) << std::endl;
+    }
+
+    for (size_t i = 0; i < files.size(); i++) {
+        delete files[i];
+    }
+    return error == STREAM_OK ? 0 : 1;
+}
+
+// tp7 journal-bench <journal> <threads> <secrets par thread> [délai en µs] [seuil en octets]
+// Chaque thread partage des secrets de 32 octets (k = 3, n = 5) et écrit leurs parts dans le journal, puis attend
+// leur durabilité avant le secret suivant, comme un dealer qui ne répond qu'une fois les parts durables
+static int command_journal_bench(int argc, char ** argv)
+{
+    if (argc < 5) {
+        std::cerr << "usage: " << argv[0] << " journal-bench <journal> <threads> <secrets per thread> [interval us] [batch bytes]" << std::endl;
+        return 2;
+    }
+
+    int threads = atoi(argv[3]);
+    long secrets = atol(argv[4]);
+    unsigned int interval = argc > 5 ? strtoul(argv[5], NULL, 10) : JOURNAL_DEFAULT_INTERVAL;
+    size_t batch = argc > 6 ? strtoull(argv[6], NULL, 10) : JOURNAL_DEFAULT_BATCH;
+    const int k = 3, n = 5, length = 32;
+
+    group_journal journal;
+    if (threads < 1 || secrets < 1 || !journal.open(argv[2], interval, batch)) {
+        std::cerr << "cannot open " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    std::vector<char> failed(threads, 0);
+    for (int t = 0; t < threads; t++)
+    {
+        pool.push_back(std::thread([&, t]() {
+            unsigned char secret[length], planes[(k - 1) * length], shareData[n * length], record[9 + length];
+            unsigned char * shares[n];
+            for (int i = 0; i < n; i++) {
+                shares[i] = shareData + i * length;
+            }
+
+            for (long s = 0; s < secrets && !failed[t]; s++)
+            {
+                if (RAND_bytes(secret, length) != 1 || RAND_bytes(planes, sizeof(planes)) != 1) {
+                    failed[t] = 1;
+                    break;
+                }
+                stream_compute_shares(shares, secret, planes, length, k, n, NULL);
+
+                // Une écriture par part : identifiant du secret, abscisse, part ; la dernière attend la validation du lot
+                for (int i = 0; i < n && !failed[t]; i++)
+                {
+                    unsigned long long id = (unsigned long long) t * secrets + s;
+                    for (int b = 0; b < 8; b++) {
+                        record[b] = (unsigned char) (id >> (8 * b));
+                    }
+                    record[8] = i + 1;
+                    memcpy(record + 9, shares[i], length);
+                    bool ok = i + 1 < n ? journal.append(record, sizeof(record), NULL, NULL) : journal.append_sync(record, sizeof(record), NULL);
+                    failed[t] = !ok;
+                }
+            }
+            OPENSSL_cleanse(secret, sizeof(secret));
+            OPENSSL_cleanse(planes, sizeof(planes));
+        }));
+    }
+    for (int t = 0; t < threads; t++) {
+        pool[t].join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unsigned long long commits = journal.commits();
+    bool ok = journal.close();
+    for (int t = 0; t < threads; t++) {
+        ok = ok && !failed[t];
+    }
+    if (!ok) {
+        std::cerr << "journal write failed" << std::endl;
+        return 1;
+    }
+
+    long total = threads * secrets;
+    std::cout << total << " secrets in " << seconds << " s: " << (long) (total / seconds) << " secrets/s, " << commits << " fdatasync, "
+              << (double) total / (commits == 0 ? 1 : commits) << " secrets per fdatasync" << std::endl;
+    return 0;
+}
+
+// tp7 vault-split <coffre> <identifiant> <k> <n> <entrée>
+// Le secret (au plus VAULT_MAX_SHARE_BYTES octets) est partagé dans GF(2^8) et chaque part rangée sous (identifiant, i)
+static int command_vault_split(int argc, char ** argv)
+{
+    if (argc < 7) {
+        std::cerr << "usage: " << argv[0] << " vault-split <vault> <id> <k> <n> <input>" << std::endl;
+        return 2;
+    }
+
+    unsigned long long id = strtoull(argv[3], NULL, 10);
+    int k = atoi(argv[4]);
+    int n = atoi(argv[5]);
+    if (k < 2 || n < k || n > 255) {
+        std::cerr << "invalid k or n" << std::endl;
+        return 2;
+    }
+
+    std::vector<unsigned char> data;
+    if (!read_file(argv[6], data) || data.empty() || data.size() > VAULT_MAX_SHARE_BYTES) {
+        std::cerr << "cannot read " << argv[6] << " (1 to " << VAULT_MAX_SHARE_BYTES << " bytes)" << std::endl;
+        return 1;
+    }
+
+    size_t length = data.size();
+    std::vector<unsigned char> planes((k - 1) * length), shareData(n * length);
+    std::vector<unsigned char *> shares(n);
+    for (int i = 0; i < n; i++) {
+        shares[i] = shareData.data() + i * length;
+    }
+    bool ok = RAND_bytes(planes.data(), planes.size()) == 1;
+    if (ok) {
+        stream_compute_shares(shares.data(), data.data(), planes.data(), length, k, n, NULL);
+    }
+    OPENSSL_cleanse(data.data(), data.size());
+    OPENSSL_cleanse(planes.data(), planes.size());
+
+    share_vault vault;
+    ok = ok && vault.open(argv[2], JOURNAL_DEFAULT_INTERVAL, JOURNAL_DEFAULT_BATCH);
+    int error = ok ? vault.put_shares(id, shares.data(), n, length) : VAULT_OK;
+    if (error != VAULT_OK) {
+        std::cerr << "cannot store the shares (error " << error << ")" << std::endl;
+        ok = false;
+    }
+    OPENSSL_cleanse(shareData.data(), shareData.size());
+    ok = vault.close() && ok;
+
+    if (!ok) {
+        std::cerr << "vault split failed" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
+
+// tp7 vault-combine <coffre> <identifiant> <sortie | -> <abscisse> ... (k abscisses)
+static int command_vault_combine(int argc, char ** argv)
+{
+    if (argc < 6) {
+        std::cerr << "usage: " << argv[0] << " vault-combine <vault> <id> <output | -> <x> ..." << std::endl;
+        return 2;
+    }
+
+    unsigned long long id = strtoull(argv[3], NULL, 10);
+    int k = argc - 5;
+    std::vector<int> x(k);
+    for (int i = 0; i < k; i++) {
+        x[i] = atoi(argv[5 + i]);
+    }
+    for (int i = 0; i < k; i++)
+    {
+        if (x[i] < 1 || x[i] > 255 || std::count(x.begin(), x.end(), x[i]) != 1) {
+            std::cerr << "abscissas must be distinct and in [1;255]" << std::endl;
+            return 2;
+        }
+    }
+
+    share_vault vault;
+    if (!vault.open(argv[2], JOURNAL_DEFAULT_INTERVAL, JOURNAL_DEFAULT_BATCH)) {
+        std::cerr << "cannot open " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::vector<std::vector<unsigned char> > shares(k);
+    bool ok = true;
+    for (int i = 0; i < k && ok; i++)
+    {
+        int error = vault.get(id, x[i], shares[i]);
+        if (error != VAULT_OK) {
+            std::cerr << "cannot read share " << x[i] << " (error " << error << ")" << std::endl;
+            ok = false;
+        } else if (shares[i].size() != shares[0].size()) {
+            std::cerr << "share " << x[i] << " has a different length" << std::endl;
+            ok = false;
+        }
+    }
+    vault.close();
+
+    std::vector<unsigned char> data;
+    if (ok)
+    {
+        std::vector<unsigned char> weights(k);
+        std::vector<const unsigned char *> pointers(k);
+        for (int i = 0; i < k; i++) {
+            pointers[i] = shares[i].data();
+        }
+        stream_lagrange_weights(weights.data(), x.data(), k, 0);
+        data.resize(shares[0].size());
+        stream_reconstruct_chunk(data.data(), pointers.data(), weights.data(), data.size(), k, NULL);
+
+        if (strcmp(argv[4], "-") == 0)
+        {
+            std::cout.write((const char *) data.data(), data.size());
+            ok = std::cout.good();
+        } else {
+            ok = write_file(argv[4], data);
+        }
+    }
+
+    OPENSSL_cleanse(data.data(), data.size());
+    for (int i = 0; i < k; i++) {
+        OPENSSL_cleanse(shares[i].data(), shares[i].size());
+    }
+    return ok ? 0 : 1;
+}
+
+// tp7 vault-bench <coffre> <secrets> [threads]
+// Remplit le coffre (secrets de 32 octets, k = 3, n = 5), le rouvre en mesurant la reconstruction de l'index, puis
+// reconstruit des secrets tirés au hasard à partir de 3 parts lues dans le coffre
+static int command_vault_bench(int argc, char ** argv)
+{
+    if (argc < 4) {
+        std::cerr << "usage: " << argv[0] << " vault-bench <vault> <secrets> [threads]" << std::endl;
+        return 2;
+    }
+
+    long secrets = atol(argv[3]);
+    int threads = argc > 4 ? atoi(argv[4]) : 64;
+    const int k = 3, n = 5, length = 32;
+    if (secrets < 1 || threads < 1) {
+        std::cerr << "invalid arguments" << std::endl;
+        return 2;
+    }
+
+    share_vault vault;
+    if (!vault.open(argv[2], JOURNAL_DEFAULT_INTERVAL, JOURNAL_DEFAULT_BATCH)) {
+        std::cerr << "cannot open " << argv[2] << std::endl;
+        return 1;
+    }
+
+    // Remplissage : chaque thread prend les secrets t, t + threads, ...
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    std::vector<char> failed(threads, 0);
+    for (int t = 0; t < threads; t++)
+    {
+        pool.push_back(std::thread([&, t]() {
+            unsigned char secret[length], planes[(k - 1) * length], shareData[n * length];
+            unsigned char * shares[n];
+            for (int i = 0; i < n; i++) {
+                shares[i] = shareData + i * length;
+            }
+            for (long s = t; s < secrets && !failed[t]; s += threads)
+            {
+                if (RAND_bytes(secret, length) != 1 || RAND_bytes(planes, sizeof(planes)) != 1) {
+                    failed[t] = 1;
+                    break;
+                }
+                stream_compute_shares(shares, secret, planes, length, k, n, NULL);
+                failed[t] = vault.put_shares(s, shares, n, length) != VAULT_OK;
+            }
+        }));
+    }
+    for (int t = 0; t < threads; t++) {
+        pool[t].join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    bool ok = vault.close();
+    for (int t = 0; t < threads; t++) {
+        ok = ok && !failed[t];
+    }
+    if (!ok) {
+        std::cerr << "vault write failed" << std::endl;
+        return 1;
+    }
+    std::cout << secrets * n << " shares stored in " << seconds << " s: " << (long) (secrets * n / seconds) << " shares/s" << std::endl;
+
+    // Réouverture : l'index est reconstruit en relisant les segments
+    start = std::chrono::steady_clock::now();
+    if (!vault.open(argv[2], JOURNAL_DEFAULT_INTERVAL, JOURNAL_DEFAULT_BATCH)) {
+        std::cerr << "cannot reopen " << argv[2] << std::endl;
+        return 1;
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "index of " << vault.count() << " shares in " << vault.segments() << " segment(s) rebuilt in " << seconds << " s" << std::endl;
+
+    // Reconstructions aléatoires : 3 parts distinctes parmi 5 par secret
+    long reads = std::min(secrets, 1000000L);
+    std::mt19937_64 generator(12345);
+    std::vector<unsigned char> weights(k), data(length);
+    std::vector<std::vector<unsigned char> > shares(k);
+    std::vector<const unsigned char *> pointers(k);
+    start = std::chrono::steady_clock::now();
+    for (long r = 0; r < reads && ok; r++)
+    {
+        unsigned long long id = generator() % secrets;
+        int first = generator() % n;
+        int x[k];
+        for (int i = 0; i < k && ok; i++)
+        {
+            x[i] = (first + i) % n + 1;
+            ok = vault.get(id, x[i], shares[i]) == VAULT_OK && shares[i].size() == (size_t) length;
+            pointers[i] = shares[i].data();
+        }
+        if (ok)
+        {
+            stream_lagrange_weights(weights.data(), x, k, 0);
+            stream_reconstruct_chunk(data.data(), pointers.data(), weights.data(), length, k, NULL);
+        }
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ok = vault.close() && ok;
+    if (!ok) {
+        std::cerr << "vault read failed" << std::endl;
+        return 1;
+    }
+    std::cout << reads << " random reconstructions in " << seconds << " s: " << (long) (reads / seconds) << " secrets/s" << std::endl;
+    return 0;
+}
+
+// tp7 vault-export <coffre> <répertoire> <n>
+// Ecrit une colonne par participant 1 ... n (ses parts, dans l'ordre des identifiants) et l'index commun
+static int command_vault_export(int argc, char ** argv)
+{
+    if (argc < 5) {
+        std::cerr << "usage: " << argv[0] << " vault-export <vault> <directory> <n>" << std::endl;
+        return 2;
+    }
+
+    share_vault vault;
+    if (!vault.open(argv[2], JOURNAL_DEFAULT_INTERVAL, JOURNAL_DEFAULT_BATCH)) {
+        std::cerr << "cannot open " << argv[2] << std::endl;
+        return 1;
+    }
+
+    unsigned long long failedId = 0;
+    int error = column_export(vault, argv[3], atoi(argv[4]), failedId);
+    vault.close();
+    if (error == COLUMN_ERROR_MISSING) {
+        std::cerr << "export failed at secret " << failedId << ": " << column_error_string(error) << std::endl;
+    } else if (error != COLUMN_OK) {
+        std::cerr << "export failed: " << column_error_string(error) << std::endl;
+    }
+    return error == COLUMN_OK ? 0 : 1;
+}
+
+// tp7 columns-combine <répertoire> <sortie | -> <abscisse> ... (k abscisses)
+// Reconstruit tous les secrets de l'index, écrits bout à bout dans l'ordre des identifiants
+static int command_columns_combine(int argc, char ** argv)
+{
+    if (argc < 5) {
+        std::cerr << "usage: " << argv[0] << " columns-combine <directory> <output | -> <x> ..." << std::endl;
+        return 2;
+    }
+
+    std::vector<int> x;
+    for (int i = 4; i < argc; i++) {
+        x.push_back(atoi(argv[i]));
+    }
+
+    std::ofstream file;
+    std::ostream * output = &std::cout;
+    if (strcmp(argv[3], "-") != 0)
+    {
+        file.open(argv[3], std::ios::binary | std::ios::trunc);
+        output = &file;
+    }
+
+    int error = column_combine(*output, argv[2], x.data(), x.size());
+    if (error != COLUMN_OK) {
+        std::cerr << "combine failed: " << column_error_string(error) << std::endl;
+    }
+    return error == COLUMN_OK ? 0 : 1;
+}
+
+// Dealer arrêté par SIGINT ou SIGTERM
+static dealer_server * running_dealer = NULL;
+static dealer_service * running_service = NULL;
+static channel_server * running_channels = NULL;
+
+static void stop_dealer(int)
+{
+    if (running_channels != NULL) {
+        running_channels->stop();
+    }
+    if (running_dealer != NULL) {
+        running_dealer->stop();
+    }
+    if (running_service != NULL) {
+        running_service->stop();
+    }
+}
+
+// tp7 dealer [--threaded] [--io-threads <n>] [--queue <requêtes>] [--channels <socket>] <socket> [workers]
+// Sert les requêtes de partage et de reconstruction jusqu'à SIGINT ou SIGTERM : boucle epoll par défaut, un thread
+// par connexion avec --threaded. Avec --channels, les clients de la machine peuvent aussi attacher un canal en
+// mémoire partagée
+static int command_dealer(int argc, char ** argv)
+{
+    bool threaded = take_option(argc, argv, "--threaded");
+    const char * ioThreads = take_option_value(argc, argv, "--io-threads");
+    const char * queue = take_option_value(argc, argv, "--queue");
+    const char * channels = take_option_value(argc, argv, "--channels");
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " dealer [--threaded] [--io-threads <n>] [--queue <requests>] [--channels <socket>] <socket> [workers]" << std::endl;
+        return 2;
+    }
+    int workers = argc > 3 ? atoi(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+
+    dealer_server server;
+    dealer_service service;
+    bool ok = threaded ? server.open(argv[2], workers)
+                       : service.open(argv[2], ioThreads != NULL ? atoi(ioThreads) : SERVICE_IO_THREADS, workers,
+                                      queue != NULL ? strtoul(queue, NULL, 10) : DEALER_QUEUE_CAPACITY);
+    if (!ok) {
+        std::cerr << "cannot listen on " << argv[2] << " (path too long, not a socket, or a dealer is already running)" << std::endl;
+        return 1;
+    }
+
+    channel_server channelServer;
+    if (channels != NULL && !channelServer.open(channels, threaded ? server.engine() : service.engine())) {
+        std::cerr << "cannot listen on " << channels << " (path too long, not a socket, or a dealer is already running)" << std::endl;
+        return 1;
+    }
+
+    if (threaded) {
+        running_dealer = &server;
+    } else {
+        running_service = &service;
+    }
+    running_channels = channels != NULL ? &channelServer : NULL;
+    signal(SIGINT, stop_dealer);
+    signal(SIGTERM, stop_dealer);
+    std::thread channelThread;
+    if (channels != NULL) {
+        channelThread = std::thread(&channel_server::run, &channelServer);
+    }
+    if (threaded) {
+        server.run();
+    } else {
+        service.run();
+    }
+
+    // Les canaux rendent leurs calculs en cours avant l'arrêt des workers
+    if (channels != NULL)
+    {
+        channelServer.stop();
+        channelThread.join();
+        channelServer.close();
+        std::cerr << channelServer.attached() << " channels attached" << std::endl;
+    }
+    if (threaded)
+    {
+        server.close();
+        std::cerr << server.engine().requests() << " requests in " << server.engine().batches() << " kernel calls" << std::endl;
+    } else {
+        service.close();
+        std::cerr << service.engine().requests() << " requests in " << service.engine().batches() << " kernel calls, "
+                  << service.accepted() << " connections, " << service.shed() << " requests or connections shed" << std::endl;
+    }
+    running_dealer = NULL;
+    running_service = NULL;
+    running_channels = NULL;
+    return 0;
+}
+
+// tp7 dealer-split <socket> <k> <n> <entrée> <préfixe>
+// Les parts (octets bruts) sont écrites dans <préfixe>.1 ... <préfixe>.n
+static int command_dealer_split(int argc, char ** argv)
+{
+    if (argc < 7) {
+        std::cerr << "usage: " << argv[0] << " dealer-split <socket> <k> <n> <input> <prefix>" << std::endl;
+        return 2;
+    }
+
+    int k = atoi(argv[3]);
+    int n = atoi(argv[4]);
+    std::vector<unsigned char> data, shares;
+    if (!read_file(argv[5], data)) {
+        std::cerr << "cannot read " << argv[5] << std::endl;
+        return 1;
+    }
+
+    int fd = dealer_connect(argv[2]);
+    int status = fd < 0 ? DEALER_ERROR_IO : dealer_split(fd, data.data(), data.size(), k, n, shares);
+    OPENSSL_cleanse(data.data(), data.size());
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (status != DEALER_OK) {
+        std::cerr << "split failed: " << dealer_error_string(status) << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+    size_t length = shares.size() / n;
+    for (int i = 0; i < n; i++)
+    {
+        std::string path = std::string(argv[6]) + "." + std::to_string(i + 1);
+        std::vector<unsigned char> share(shares.begin() + i * length, shares.begin() + (i + 1) * length);
+        if (!write_file(path.c_str(), share)) {
+            std::cerr << "cannot write " << path << std::endl;
+            ok = false;
+        }
+    }
+    OPENSSL_cleanse(shares.data(), shares.size());
+    return ok ? 0 : 1;
+}
+
+// tp7 dealer-combine <socket> <préfixe> <sortie | -> <abscisse> ... (k abscisses, parts lues dans <préfixe>.<abscisse>)
+static int command_dealer_combine(int argc, char ** argv)
+{
+    if (argc < 6) {
+        std::cerr << "usage: " << argv[0] << " dealer-combine <socket> <prefix> <output | -> <x> ..." << std::endl;
+        return 2;
+    }
+
+    int k = argc - 5;
+    std::vector<int> x(k);
+    std::vector<std::vector<unsigned char> > shares(k);
+    std::vector<const unsigned char *> pointers(k);
+    for (int i = 0; i < k; i++) {
+        x[i] = atoi(argv[5 + i]);
+    }
+    for (int i = 0; i < k; i++)
+    {
+        if (x[i] < 1 || x[i] > 255 || std::count(x.begin(), x.end(), x[i]) != 1) {
+            std::cerr << "abscissas must be distinct and in [1;255]" << std::endl;
+            return 2;
+        }
+    }
+    for (int i = 0; i < k; i++)
+    {
+        std::string path = std::string(argv[3]) + "." + std::to_string(x[i]);
+        if (!read_file(path.c_str(), shares[i]) || shares[i].size() != shares[0].size()) {
+            std::cerr << "cannot read " << path << " (or different length)" << std::endl;
+            return 1;
+        }
+        pointers[i] = shares[i].data();
+    }
+
+    std::vector<unsigned char> data;
+    int fd = dealer_connect(argv[2]);
+    int status = fd < 0 ? DEALER_ERROR_IO : dealer_combine(fd, x.data(), pointers.data(), k, shares[0].size(), data);
+    if (fd >= 0) {
+        close(fd);
+    }
+    for (int i = 0; i < k; i++) {
+        OPENSSL_cleanse(shares[i].data(), shares[i].size());
+    }
+    if (status != DEALER_OK) {
+        std::cerr << "combine failed: " << dealer_error_string(status) << std::endl;
+        return 1;
+    }
+
+    bool ok;
+    if (strcmp(argv[4], "-") == 0)
+    {
+        std::cout.write((const char *) data.data(), data.size());
+        ok = std::cout.good();
+    } else {
+        ok = write_file(argv[4], data);
+    }
+    OPENSSL_cleanse(data.data(), data.size());
+    return ok ? 0 : 1;
+}
+
+// tp7 dealer-bench <socket> <clients> <requêtes par client> [octets]
+// Chaque client partage un secret aléatoire (k = 3, n = 5) puis le reconstruit à partir de 3 parts, en boucle ;
+// la latence de chaque requête acceptée est mesurée, les requêtes refusées (dealer saturé) sont comptées
+static int command_dealer_bench(int argc, char ** argv)
+{
+    if (argc < 5) {
+        std::cerr << "usage: " << argv[0] << " dealer-bench <socket> <clients> <requests per client> [bytes]" << std::endl;
+        return 2;
+    }
+
+    int clients = atoi(argv[3]);
+    long requests = atol(argv[4]);
+    size_t length = argc > 5 ? strtoul(argv[5], NULL, 10) : 32;
+    const int k = 3, n = 5;
+    if (clients < 1 || requests < 1 || length < 1 || length > DEALER_MAX_SECRET) {
+        std::cerr << "invalid arguments" << std::endl;
+        return 2;
+    }
+
+    std::vector<std::vector<double> > latencies(clients);
+    std::vector<char> failed(clients, 0);
+    std::atomic<long> shed(0);
+    std::vector<std::thread> pool;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int c = 0; c < clients; c++)
+    {
+        pool.push_back(std::thread([&, c]() {
+            int fd = dealer_connect(argv[2]);
+            std::vector<unsigned char> secret(length), shares, result;
+            int x[k] = { 2, 4, 5 };
+            for (long r = 0; r < requests && fd >= 0 && !failed[c]; r++)
+            {
+                RAND_bytes(secret.data(), length);
+                std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+                int status = dealer_split(fd, secret.data(), length, k, n, shares);
+                std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+                if (status == DEALER_ERROR_BUSY) {
+                    shed++;
+                    continue;
+                }
+                failed[c] = status != DEALER_OK;
+                latencies[c].push_back(std::chrono::duration<double, std::micro>(middle - begin).count());
+
+                const unsigned char * pointers[k];
+                for (int i = 0; i < k && !failed[c]; i++) {
+                    pointers[i] = shares.data() + (x[i] - 1) * length;
+                }
+                status = failed[c] ? DEALER_OK : dealer_combine(fd, x, pointers, k, length, result);
+                std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                if (status == DEALER_ERROR_BUSY) {
+                    shed++;
+                    continue;
+                }
+                failed[c] = failed[c] || status != DEALER_OK || result != secret;
+                latencies[c].push_back(std::chrono::duration<double, std::micro>(end - middle).count());
+            }
+            failed[c] = failed[c] || fd < 0;
+            if (fd >= 0) {
+                close(fd);
+            }
+        }));
+    }
+    for (int c = 0; c < clients; c++) {
+        pool[c].join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    bool ok = true;
+    for (int c = 0; c < clients; c++)
+    {
+        ok = ok && !failed[c];
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+    }
+    if (!ok || all.empty()) {
+        std::cerr << "dealer request failed" << std::endl;
+        return 1;
+    }
+
+    std::sort(all.begin(), all.end());
+    std::cout << all.size() << " requests in " << seconds << " s: " << (long) (all.size() / seconds) << " requests/s, latency p50 "
+              << all[all.size() / 2] << " us, p99 " << all[all.size() * 99 / 100] << " us, max " << all.back() << " us, " << shed << " shed" << std::endl;
+    return 0;
+}
+
+// tp7 channel-bench <socket des canaux> <clients> <requêtes par client> [octets]
+// Comme dealer-bench, par un canal en mémoire partagée commun aux clients : chaque client écrit son secret dans sa
+// case, le partage en place puis le reconstruit à partir des parts 1, 2, 3 restées dans la case
+static int command_channel_bench(int argc, char ** argv)
+{
+    if (argc < 5) {
+        std::cerr << "usage: " << argv[0] << " channel-bench <channel socket> <clients> <requests per client> [bytes]" << std::endl;
+        return 2;
+    }
+
+    int clients = atoi(argv[3]);
+    long requests = atol(argv[4]);
+    size_t length = argc > 5 ? strtoul(argv[5], NULL, 10) : 32;
+    const int k = 3, n = 5;
+    if (clients < 1 || requests < 1 || length < 1 || (n + 2) * length > CHANNEL_MAX_BYTES / CHANNEL_SLOTS) {
+        std::cerr << "invalid arguments" << std::endl;
+        return 2;
+    }
+
+    // Case : secret, n parts, secret reconstruit
+    channel_client channel;
+    if (!channel.open(argv[2], std::max(clients, CHANNEL_SLOTS), (n + 2) * length)) {
+        std::cerr << "cannot attach a channel to " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::vector<std::vector<double> > latencies(clients);
+    std::vector<char> failed(clients, 0);
+    std::atomic<long> shed(0);
+    std::vector<std::thread> pool;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int c = 0; c < clients; c++)
+    {
+        pool.push_back(std::thread([&, c]() {
+            int x[k] = { 1, 2, 3 };
+            for (long r = 0; r < requests && !failed[c]; r++)
+            {
+                int slot = channel.acquire();
+                unsigned char * data = channel.data(slot);
+                RAND_bytes(data, length);
+                std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+                channel.split(slot, 0, length, k, n, length);
+                int status = channel.wait(slot);
+                std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+                if (status == DEALER_ERROR_BUSY)
+                {
+                    shed++;
+                    channel.release(slot);
+                    continue;
+                }
+                failed[c] = status != DEALER_OK;
+                latencies[c].push_back(std::chrono::duration<double, std::micro>(middle - begin).count());
+
+                if (!failed[c])
+                {
+                    channel.combine(slot, x, k, length, length, (n + 1) * length);
+                    status = channel.wait(slot);
+                }
+                std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                if (status == DEALER_ERROR_BUSY) {
+                    shed++;
+                } else if (!failed[c]) {
+                    failed[c] = status != DEALER_OK || memcmp(data, data + (n + 1) * length, length) != 0;
+                    latencies[c].push_back(std::chrono::duration<double, std::micro>(end - middle).count());
+                }
+                channel.release(slot);
+            }
+        }));
+    }
+    for (int c = 0; c < clients; c++) {
+        pool[c].join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    channel.close();
+
+    std::vector<double> all;
+    bool ok = true;
+    for (int c = 0; c < clients; c++)
+    {
+        ok = ok && !failed[c];
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+    }
+    if (!ok || all.empty()) {
+        std::cerr << "channel request failed" << std::endl;
+        return 1;
+    }
+
+    std::sort(all.begin(), all.end());
+    std::cout << all.size() << " requests in " << seconds << " s: " << (long) (all.size() / seconds) << " requests/s, "
+              << (long) (all.size() / 2 * length / seconds / 1e6) << " MB/s of secrets, latency p50 " << all[all.size() / 2]
+              << " us, p99 " << all[all.size() * 99 / 100] << " us, max " << all.back() << " us, " << shed << " shed" << std::endl;
+    return 0;
+}
+
+// Etat partagé des tâches de async-bench, touché seulement par le thread de la boucle (et par main avant run)
+struct async_bench
+{
+    dealer_engine engine;
+    async_loop loop;
+    size_t length;
+    int remaining;
+    bool failed;
+    std::vector<double> latencies;
+    int statuses[DEALER_ERROR_CANCELLED + 1];
+};
+
+// Tâche de async-bench : partage un secret aléatoire (k = 3, n = 5) puis le reconstruit à partir des parts 1, 2, 3
+static async_task async_bench_round_trips(async_bench & bench, long requests)
+{
+    const int k = 3, n = 5;
+    const int x[k] = { 1, 2, 3 };
+    std::vector<unsigned char> secret(bench.length), shares(n * bench.length), result(bench.length);
+    for (long r = 0; r < requests && !bench.failed; r++)
+    {
+        RAND_bytes(secret.data(), bench.length);
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        int status = co_await async_split(bench.engine, secret.data(), bench.length, k, n, shares.data(), std::stop_token(), &bench.loop);
+        std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+        if (status == DEALER_OK) {
+            status = co_await async_combine(bench.engine, x, k, shares.data(), bench.length, result.data(), std::stop_token(), &bench.loop);
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        bench.failed = bench.failed || status != DEALER_OK || result != secret;
+        bench.latencies.push_back(std::chrono::duration<double, std::micro>(middle - begin).count());
+        bench.latencies.push_back(std::chrono::duration<double, std::micro>(end - middle).count());
+    }
+    if (--bench.remaining == 0) {
+        bench.loop.stop();
+    }
+}
+
+// Tâche de async-bench : un partage que main annule pendant qu'il est en file ou en calcul
+static async_task async_bench_cancelled(async_bench & bench, std::stop_token stop)
+{
+    std::vector<unsigned char> secret(bench.length, 0x5a), shares(5 * bench.length);
+    int status = co_await async_split(bench.engine, secret.data(), bench.length, 3, 5, shares.data(), stop, &bench.loop);
+    bench.statuses[status]++;
+    if (--bench.remaining == 0) {
+        bench.loop.stop();
+    }
+}
+
+// tp7 async-bench <tâches> <requêtes par tâche> [octets] [workers]
+// Les tâches sont des coroutines reprises par un seul thread : toutes leurs requêtes sont en vol en même temps sur
+// les workers. Ensuite, autant de partages sont lancés puis annulés aussitôt
+static int command_async_bench(int argc, char ** argv)
+{
+    if (argc < 4) {
+        std::cerr << "usage: " << argv[0] << " async-bench <tasks> <requests per task> [bytes] [workers]" << std::endl;
+        return 2;
+    }
+
+    int tasks = atoi(argv[2]);
+    long requests = atol(argv[3]);
+    async_bench bench;
+    bench.length = argc > 4 ? strtoul(argv[4], NULL, 10) : 32;
+    int workers = argc > 5 ? atoi(argv[5]) : std::max(1u, std::thread::hardware_concurrency());
+    if (tasks < 1 || requests < 1 || bench.length < 1) {
+        std::cerr << "invalid arguments" << std::endl;
+        return 2;
+    }
+    bench.engine.start(workers, tasks);
+    bench.failed = false;
+    std::fill(bench.statuses, bench.statuses + DEALER_ERROR_CANCELLED + 1, 0);
+
+    bench.remaining = tasks;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int t = 0; t < tasks; t++) {
+        async_bench_round_trips(bench, requests);
+    }
+    bench.loop.run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (bench.failed) {
+        std::cerr << "async request failed" << std::endl;
+        return 1;
+    }
+
+    std::vector<double> & all = bench.latencies;
+    std::sort(all.begin(), all.end());
+    std::cout << all.size() << " requests from " << tasks << " tasks on one thread in " << seconds << " s: " << (long) (all.size() / seconds)
+              << " requests/s, latency p50 " << all[all.size() / 2] << " us, p99 " << all[all.size() * 99 / 100] << " us" << std::endl;
+
+    std::stop_source cancel;
+    bench.remaining = tasks;
+    for (int t = 0; t < tasks; t++) {
+        async_bench_cancelled(bench, cancel.get_token());
+    }
+    cancel.request_stop();
+    bench.loop.run();
+    bench.engine.stop();
+    std::cout << tasks << " splits cancelled: " << bench.statuses[DEALER_ERROR_CANCELLED] << " before computing, "
+              << bench.statuses[DEALER_OK] << " computed (started before the cancel), " << bench.statuses[DEALER_ERROR_BUSY] << " busy" << std::endl;
+    return bench.statuses[DEALER_ERROR_CANCELLED] + bench.statuses[DEALER_OK] + bench.statuses[DEALER_ERROR_BUSY] == tasks ? 0 : 1;
+}
+
+// tp7 quorum-bench <préfixe> <k> <n> <reconstructions> [délai ms] [probabilité lente] [lenteur ms] [probabilité d'erreur]
+// Ecrit les n parts d'un secret aléatoire dans <préfixe>.<x>, puis les reconstruit à travers n sources simulées à
+// délais et pannes injectés : d'abord en attendant un sous-ensemble fixe de k sources, puis en interrogeant les n
+// sources et en gardant les k premières réponses
+static int command_quorum_bench(int argc, char ** argv)
+{
+    if (argc < 6) {
+        std::cerr << "usage: " << argv[0] << " quorum-bench <prefix> <k> <n> <combines> [delay ms] [slow probability] [slow ms] [failure probability]" << std::endl;
+        return 2;
+    }
+
+    int k = atoi(argv[3]), n = atoi(argv[4]);
+    long combines = atol(argv[5]);
+    quorum_faults faults;
+    faults.delayMs = argc > 6 ? atof(argv[6]) : 2;
+    faults.slowProbability = argc > 7 ? atof(argv[7]) : 0.05;
+    faults.slowMs = argc > 8 ? atof(argv[8]) : 50;
+    faults.failProbability = argc > 9 ? atof(argv[9]) : 0.01;
+    if (k < 1 || n < k || n > 255 || combines < 1) {
+        std::cerr << "invalid arguments" << std::endl;
+        return 2;
+    }
+
+    // Parts d'un secret aléatoire, comme les écrit dealer-split
+    const size_t length = 1024;
+    std::vector<unsigned char> secret(length), planes((k - 1) * length), shareData(n * length);
+    std::vector<unsigned char *> shares(n);
+    for (int i = 0; i < n; i++) {
+        shares[i] = shareData.data() + i * length;
+    }
+    if (RAND_bytes(secret.data(), length) != 1 || RAND_bytes(planes.data(), planes.size()) != 1) {
+        std::cerr << "random generation failed" << std::endl;
+        return 1;
+    }
+    stream_compute_shares(shares.data(), secret.data(), planes.data(), length, k, n, NULL);
+    for (int i = 0; i < n; i++)
+    {
+        std::string path = std::string(argv[2]) + "." + std::to_string(i + 1);
+        if (!write_file(path.c_str(), std::vector<unsigned char>(shares[i], shares[i] + length))) {
+            std::cerr << "cannot write " << path << std::endl;
+            return 1;
+        }
+    }
+    OPENSSL_cleanse(planes.data(), planes.size());
+    OPENSSL_cleanse(shareData.data(), shareData.size());
+
+    std::random_device seeds;
+    std::vector<std::unique_ptr<quorum_file_source> > owned;
+    std::vector<quorum_source *> sources;
+    for (int i = 0; i < n; i++)
+    {
+        owned.push_back(std::unique_ptr<quorum_file_source>(new quorum_file_source(argv[2], i + 1, faults, seeds())));
+        sources.push_back(owned.back().get());
+    }
+    quorum_combiner combiner(sources);
+
+    const char * names[2] = { "fixed subset", "hedged" };
+    for (int mode = 0; mode < 2; mode++)
+    {
+        std::vector<double> latencies;
+        long failures = 0;
+        unsigned long long cancelled = combiner.cancelled(), failed = combiner.failed();
+        for (long c = 0; c < combines; c++)
+        {
+            std::vector<unsigned char> result;
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            int status = combiner.combine(k, mode == 0 ? k : n, result);
+            latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+            if (status == QUORUM_OK && result != secret)
+            {
+                std::cerr << "wrong secret reconstructed" << std::endl;
+                return 1;
+            }
+            failures += status != QUORUM_OK;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << names[mode] << ": p50 " << latencies[latencies.size() / 2] << " ms, p99 " << latencies[latencies.size() * 99 / 100]
+                  << " ms, max " << latencies.back() << " ms, " << failures << " combines failed, " << combiner.failed() - failed
+                  << " source errors, " << combiner.cancelled() - cancelled << " late requests cancelled" << std::endl;
+    }
+    return 0;
+}
+
+// Fonction qui exécute la commande donnée sur la ligne de commande (tp7 <commande> <arguments>)
+int run_command(int argc, char ** argv)
+{
+    std::string command = argv[1];
+
+    if (command == "split") {
+        return command_split(argc, argv);
+    }
+    if (command == "combine") {
+        return command_combine(argc, argv);
+    }
+    if (command == "update") {
+        return command_update(argc, argv);
+    }
+    if (command == "extract") {
+        return command_extract(argc, argv);
+    }
+    if (command == "hybrid-split") {
+        return command_hybrid_split(argc, argv);
+    }
+    if (command == "hybrid-combine") {
+        return command_hybrid_combine(argc, argv);
+    }
+    if (command == "journal-bench") {
+        return command_journal_bench(argc, argv);
+    }
+    if (command == "vault-split") {
+        return command_vault_split(argc, argv);
+    }
+    if (command == "vault-combine") {
+        return command_vault_combine(argc, argv);
+    }
+    if (command == "vault-bench") {
+        return command_vault_bench(argc, argv);
+    }
+    if (command == "vault-export") {
+        return command_vault_export(argc, argv);
+    }
+    if (command == "columns-combine") {
+        return command_columns_combine(argc, argv);
+    }
+    if (command == "dealer") {
+        return command_dealer(argc, argv);
+    }
+    if (command == "dealer-split") {
+        return command_dealer_split(argc, argv);
+    }
+    if (command == "dealer-combine") {
+        return command_dealer_combine(argc, argv);
+    }
+    if (command == "dealer-bench") {
+        return command_dealer_bench(argc, argv);
+    }
+    if (command == "channel-bench") {
+        return command_channel_bench(argc, argv);
+    }
+    if (command == "async-bench") {
+        return command_async_bench(argc, argv);
+    }
+    if (command == "quorum-bench") {
+        return command_quorum_bench(argc, argv);
+    }
+
+    std::cerr << "usage: " << argv[0] << " [split | combine | update | extract | hybrid-split | hybrid-combine | journal-bench | vault-split | vault-combine | vault-bench | vault-export | columns-combine | dealer | dealer-split | dealer-combine | dealer-bench | channel-bench | async-bench | quorum-bench] ..." << std::endl;
+    return 2;
+}
@@ -0,0 +1,7 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+// Fonction qui exécute la commande donnée sur la ligne de commande (tp7 <commande> <arguments>)
+int run_command(int argc, char ** argv);
+
+#endif
@@ -0,0 +1,131 @@
+#include "crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define CRC32C_X86 1
+#endif
+
+/*
+ * CRC-32C (polynome de Castagnoli 0x1EDC6F41, forme réfléchie 0x82F63B78) des enregistrements de parts.
+ * Sur x86-64 l'instruction crc32 de SSE4.2 traite 8 octets par instruction, avec une latence de 3 cycles
+ * pour un débit d'une instruction par cycle : crc32c_multi entrelace donc trois flux indépendants (les parts
+ * d'un même morceau) pour occuper l'unité à chaque cycle. Ailleurs, une table de 256 entrées sert de repli.
+ */
+
+static unsigned int crc32c_table[256];
+
+// Table construite à l'initialisation statique
+static bool crc32c_init()
+{
+    for (unsigned int i = 0; i < 256; i++)
+    {
+        unsigned int value = i;
+        for (int b = 0; b < 8; b++) {
+            value = (value >> 1) ^ (value & 1 ? 0x82F63B78 : 0);
+        }
+        crc32c_table[i] = value;
+    }
+    return true;
+}
+
+static bool crc32c_initialized = crc32c_init();
+
+// Noyau portable, sur l'état interne (complément du CRC)
+static unsigned int crc32c_scalar(unsigned int state, const unsigned char * data, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        state = (state >> 8) ^ crc32c_table[(state ^ data[i]) & 0xff];
+    }
+    return state;
+}
+
+#ifdef CRC32C_X86
+// Lecture de 8 octets sans contrainte d'alignement
+static inline unsigned long long crc32c_load(const unsigned char * data)
+{
+    unsigned long long value;
+    memcpy(&value, data, 8);
+    return value;
+}
+
+__attribute__((target("sse4.2")))
+static unsigned int crc32c_sse42(unsigned int state, const unsigned char * data, size_t length)
+{
+    unsigned long long value = state;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        value = _mm_crc32_u64(value, crc32c_load(data + i));
+    }
+    for (; i < length; i++) {
+        value = _mm_crc32_u8(value, data[i]);
+    }
+    return value;
+}
+
+// Trois flux de même longueur en parallèle
+__attribute__((target("sse4.2")))
+static void crc32c_sse42_x3(unsigned int * states, const unsigned char * const * data, size_t length)
+{
+    unsigned long long a = states[0], b = states[1], c = states[2];
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        a = _mm_crc32_u64(a, crc32c_load(data[0] + i));
+        b = _mm_crc32_u64(b, crc32c_load(data[1] + i));
+        c = _mm_crc32_u64(c, crc32c_load(data[2] + i));
+    }
+    for (; i < length; i++)
+    {
+        a = _mm_crc32_u8(a, data[0][i]);
+        b = _mm_crc32_u8(b, data[1][i]);
+        c = _mm_crc32_u8(c, data[2][i]);
+    }
+    states[0] = a;
+    states[1] = b;
+    states[2] = c;
+}
+
+// Détection du processeur, __builtin_cpu_init est nécessaire car elle a lieu pendant l'initialisation statique
+static bool crc32c_cpu_supports()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+
+static const bool crc32c_has_sse42 = crc32c_cpu_supports();
+#endif
+
+// Fonction qui prolonge le CRC-32C (Castagnoli) crc avec length octets : crc32c(crc32c(0, a), b) = crc32c(0, a || b)
+unsigned int crc32c(unsigned int crc, const unsigned char * data, size_t length)
+{
+#ifdef CRC32C_X86
+    if (crc32c_has_sse42) {
+        return ~crc32c_sse42(~crc, data, length);
+    }
+#endif
+    return ~crc32c_scalar(~crc, data, length);
+}
+
+// Fonction qui prolonge count CRC-32C indépendants, crcs[i] avec les length octets de data[i]
+void crc32c_multi(unsigned int * crcs, const unsigned char * const * data, int count, size_t length)
+{
+    int i = 0;
+#ifdef CRC32C_X86
+    if (crc32c_has_sse42)
+    {
+        for (; i + 3 <= count; i += 3)
+        {
+            unsigned int states[3] = { ~crcs[i], ~crcs[i + 1], ~crcs[i + 2] };
+            crc32c_sse42_x3(states, data + i, length);
+            crcs[i] = ~states[0];
+            crcs[i + 1] = ~states[1];
+            crcs[i + 2] = ~states[2];
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        crcs[i] = crc32c(crcs[i], data[i], length);
+    }
+}
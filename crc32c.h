@@ -0,0 +1,12 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <cstddef>
+
+// Fonction qui prolonge le CRC-32C (Castagnoli) crc avec length octets : crc32c(crc32c(0, a), b) = crc32c(0, a || b)
+unsigned int crc32c(unsigned int crc, const unsigned char * data, size_t length);
+
+// Fonction qui prolonge count CRC-32C indépendants, crcs[i] avec les length octets de data[i] (SSE4.2 si disponible)
+void crc32c_multi(unsigned int * crcs, const unsigned char * const * data, int count, size_t length);
+
+#endif
@@ -0,0 +1,702 @@
+#include "dealer.h"
+#include "bytes.h"
+#include "stream.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ * Dealer de longue durée : un processus tp7 par partage paie à chaque fois le démarrage, l'initialisation
+ * d'OpenSSL et de son générateur, et la création des threads. Le dealer garde tout cela entre les requêtes.
+ *
+ * Protocole (socket Unix, flux) : chaque trame est une taille u32 suivie du corps.
+ * Requête : opération, k, n, 0, puis
+ *  - partage : le secret ;
+ *  - reconstruction (n = 0) : les k abscisses, puis les k parts de même taille bout à bout.
+ * Réponse : statut, 3 octets nuls, puis les n parts (abscisses 1 ... n) bout à bout ou le secret.
+ *
+ * Regroupement : dans GF(2^8) le calcul est octet par octet, donc les parts de secrets mis bout à bout sont les
+ * parts mises bout à bout. Un worker prend toutes les requêtes en file à son réveil, les groupe par paramètres
+ * (k et n pour un partage, abscisses pour une reconstruction) et fait un seul appel aux noyaux par groupe. Sans
+ * charge, une requête part seule et sans délai ; sous charge, les lots grossissent d'eux-mêmes.
+ *
+ * Les requêtes en place (canaux en mémoire partagée, voir channel.cpp) ne sont pas regroupées : leurs données sont
+ * déjà bout à bout et sont calculées directement dans la mémoire du client.
+ */
+
+// Fonction qui vérifie que les k abscisses sont non nulles et distinctes
+static bool dealer_abscissas(const unsigned char * x, int k)
+{
+    for (int i = 0; i < k; i++)
+    {
+        if (x[i] == 0 || std::count(x, x + k, x[i]) != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Fonction qui vérifie une requête et donne ses paramètres : taille d'un secret et clé de regroupement
+static int dealer_parse(const std::vector<unsigned char> & body, size_t & length, std::string & key)
+{
+    if (body.size() < DEALER_HEADER_BYTES) {
+        return DEALER_ERROR_REQUEST;
+    }
+    int op = body[0], k = body[1], n = body[2];
+    size_t payload = body.size() - DEALER_HEADER_BYTES;
+
+    if (op == DEALER_OP_SPLIT)
+    {
+        if (k < 2 || n < k || payload < 1 || payload > DEALER_MAX_SECRET) {
+            return DEALER_ERROR_RANGE;
+        }
+        length = payload;
+        key.assign((const char *) body.data(), 3);
+        return DEALER_OK;
+    }
+
+    if (op == DEALER_OP_COMBINE)
+    {
+        if (k < 1 || n != 0 || payload <= (size_t) k || (payload - k) % k != 0 || (payload - k) / k > DEALER_MAX_SECRET) {
+            return DEALER_ERROR_RANGE;
+        }
+        const unsigned char * x = body.data() + DEALER_HEADER_BYTES;
+        if (!dealer_abscissas(x, k)) {
+            return DEALER_ERROR_RANGE;
+        }
+        length = (payload - k) / k;
+        key.assign(1, (char) op);
+        key.append((const char *) x, k);
+        return DEALER_OK;
+    }
+    return DEALER_ERROR_REQUEST;
+}
+
+// Fonction qui écrit une réponse sans données
+static void dealer_status(dealer_request * request, int status)
+{
+    request->response.assign(DEALER_HEADER_BYTES, 0);
+    request->response[0] = status;
+}
+
+dealer_engine::dealer_engine() : requests_(0), batches_(0), stopping_(false), sleeping_(0)
+{
+}
+
+dealer_engine::~dealer_engine()
+{
+    stop();
+}
+
+// Fonction qui démarre workers threads de calcul, avec une file de capacity requêtes
+bool dealer_engine::start(int workers, size_t capacity)
+{
+    queue_.reset(new ring_queue<dealer_request *>(capacity));
+    stopping_ = false;
+    for (int i = 0; i < std::max(1, workers); i++) {
+        workers_.push_back(std::thread(&dealer_engine::work, this));
+    }
+    return true;
+}
+
+// Fonction qui met une requête en file ; son listener sera averti de la fin du calcul
+bool dealer_engine::submit(dealer_request * request)
+{
+    if (stopping_ || !queue_ || !queue_->try_push(request)) {
+        return false;
+    }
+
+    // Barrière : soit le worker qui s'endort voit la requête, soit submit le voit endormi (voir work)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.notify_one();
+    }
+    return true;
+}
+
+// Fonction qui arrête les workers une fois la file vide
+void dealer_engine::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        pending_.notify_all();
+    }
+    for (size_t i = 0; i < workers_.size(); i++) {
+        workers_[i].join();
+    }
+    workers_.clear();
+}
+
+// Thread de calcul : toutes les requêtes en file (jusqu'à DEALER_BATCH_BYTES) forment un lot
+void dealer_engine::work()
+{
+    std::vector<dealer_request *> batch;
+    while (true)
+    {
+        size_t bytes = 0;
+        dealer_request * request;
+        while (bytes < DEALER_BATCH_BYTES && queue_->try_pop(request))
+        {
+            bytes += request->body.size() + request->length;
+            batch.push_back(request);
+        }
+
+        if (batch.empty())
+        {
+            // File vide : le worker s'endort, sauf arrêt demandé
+            std::unique_lock<std::mutex> lock(mutex_);
+            sleeping_++;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            pending_.wait(lock, [this] { return stopping_ || queue_->size() != 0; });
+            sleeping_--;
+            if (stopping_ && queue_->size() == 0) {
+                break;
+            }
+            continue;
+        }
+
+        // Il reste du travail : un autre worker le prend pendant ce lot
+        if (queue_->size() != 0 && sleeping_.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.notify_one();
+        }
+
+        process(batch);
+        requests_ += batch.size();
+        for (size_t i = 0; i < batch.size(); i++) {
+            batch[i]->listener->completed(batch[i]);
+        }
+        batch.clear();
+    }
+}
+
+// Fonction qui donne les poids de Lagrange des abscisses x (dans l'ordre), calculés une fois par jeu d'abscisses
+bool dealer_engine::weights(unsigned char * weights, const unsigned char * x, int k)
+{
+    std::string key((const char *) x, k);
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    std::map<std::string, std::vector<unsigned char> >::iterator it = cache_.find(key);
+    if (it == cache_.end())
+    {
+        if (cache_.size() >= DEALER_WEIGHT_CACHE) {
+            cache_.clear();
+        }
+        std::vector<int> abscissas(x, x + k);
+        std::vector<unsigned char> computed(k);
+        stream_lagrange_weights(computed.data(), abscissas.data(), k, 0);
+        it = cache_.insert(std::make_pair(key, computed)).first;
+    }
+    memcpy(weights, it->second.data(), k);
+    return true;
+}
+
+// Fonction qui calcule les réponses d'un lot : un appel aux noyaux GF(2^8) par groupe de requêtes de mêmes paramètres
+void dealer_engine::process(std::vector<dealer_request *> & batch)
+{
+    std::map<std::string, std::vector<dealer_request *> > groups;
+    for (size_t r = 0; r < batch.size(); r++)
+    {
+        if (!batch[r]->listener->starting(batch[r]))
+        {
+            dealer_status(batch[r], DEALER_ERROR_CANCELLED);
+            continue;
+        }
+        if (batch[r]->input != NULL)
+        {
+            compute(batch[r]);
+            continue;
+        }
+        std::string key;
+        size_t length;
+        int status = dealer_parse(batch[r]->body, length, key);
+        if (status != DEALER_OK) {
+            dealer_status(batch[r], status);
+        } else {
+            groups[key].push_back(batch[r]);
+        }
+    }
+
+    std::vector<unsigned char> data, planes, shareData, weightData;
+    std::vector<unsigned char *> shares;
+    std::vector<const unsigned char *> inputs;
+    for (std::map<std::string, std::vector<dealer_request *> >::iterator it = groups.begin(); it != groups.end(); ++it)
+    {
+        std::vector<dealer_request *> & group = it->second;
+        const unsigned char * first = group[0]->body.data();
+        int k = first[1], n = first[2];
+        bool split = first[0] == DEALER_OP_SPLIT;
+        int count = split ? n : k;
+        size_t skip = split ? 0 : k;
+
+        // Secrets (ou parts de même abscisse) des requêtes du groupe mis bout à bout
+        size_t total = 0;
+        for (size_t r = 0; r < group.size(); r++) {
+            total += (group[r]->body.size() - DEALER_HEADER_BYTES - skip) / (split ? 1 : k);
+        }
+
+        shareData.resize(count * total);
+        shares.resize(count);
+        inputs.resize(count);
+        for (int i = 0; i < count; i++)
+        {
+            shares[i] = shareData.data() + i * total;
+            inputs[i] = shares[i];
+        }
+        data.resize(total);
+
+        if (split)
+        {
+            size_t offset = 0;
+            for (size_t r = 0; r < group.size(); r++)
+            {
+                size_t length = group[r]->body.size() - DEALER_HEADER_BYTES;
+                memcpy(data.data() + offset, group[r]->body.data() + DEALER_HEADER_BYTES, length);
+                offset += length;
+            }
+            planes.resize((k - 1) * total);
+            if (RAND_bytes(planes.data(), planes.size()) != 1)
+            {
+                for (size_t r = 0; r < group.size(); r++) {
+                    dealer_status(group[r], DEALER_ERROR_INTERNAL);
+                }
+                continue;
+            }
+            stream_compute_shares(shares.data(), data.data(), planes.data(), total, k, n, NULL);
+        } else {
+            size_t offset = 0;
+            for (size_t r = 0; r < group.size(); r++)
+            {
+                size_t length = (group[r]->body.size() - DEALER_HEADER_BYTES - k) / k;
+                const unsigned char * source = group[r]->body.data() + DEALER_HEADER_BYTES + k;
+                for (int i = 0; i < k; i++) {
+                    memcpy(shares[i] + offset, source + i * length, length);
+                }
+                offset += length;
+            }
+            weightData.resize(k);
+            weights(weightData.data(), first + DEALER_HEADER_BYTES, k);
+            stream_reconstruct_chunk(data.data(), inputs.data(), weightData.data(), total, k, NULL);
+        }
+        batches_++;
+
+        // Réponses : chaque requête reprend sa tranche
+        size_t offset = 0;
+        for (size_t r = 0; r < group.size(); r++)
+        {
+            size_t length = (group[r]->body.size() - DEALER_HEADER_BYTES - skip) / (split ? 1 : k);
+            std::vector<unsigned char> & response = group[r]->response;
+            response.assign(DEALER_HEADER_BYTES + (split ? n * length : length), 0);
+            response[0] = DEALER_OK;
+            if (split)
+            {
+                for (int i = 0; i < n; i++) {
+                    memcpy(response.data() + DEALER_HEADER_BYTES + i * length, shares[i] + offset, length);
+                }
+            } else {
+                memcpy(response.data() + DEALER_HEADER_BYTES, data.data() + offset, length);
+            }
+            OPENSSL_cleanse(group[r]->body.data(), group[r]->body.size());
+            offset += length;
+        }
+    }
+
+    OPENSSL_cleanse(data.data(), data.size());
+    OPENSSL_cleanse(planes.data(), planes.size());
+    OPENSSL_cleanse(shareData.data(), shareData.size());
+}
+
+// Fonction qui calcule une requête en place : ses données sont déjà bout à bout, elle n'est pas regroupée
+void dealer_engine::compute(dealer_request * request)
+{
+    const std::vector<unsigned char> & body = request->body;
+    if (body.size() < DEALER_HEADER_BYTES)
+    {
+        dealer_status(request, DEALER_ERROR_REQUEST);
+        return;
+    }
+    int op = body[0], k = body[1], n = body[2];
+    size_t length = request->length;
+    std::vector<unsigned char *> pointers(std::max(k, n));
+    for (size_t i = 0; i < pointers.size(); i++) {
+        pointers[i] = (unsigned char *) (op == DEALER_OP_SPLIT ? request->output : request->input) + i * length;
+    }
+
+    if (op == DEALER_OP_SPLIT && body.size() == DEALER_HEADER_BYTES)
+    {
+        if (k < 2 || n < k || length < 1)
+        {
+            dealer_status(request, DEALER_ERROR_RANGE);
+            return;
+        }
+        std::vector<unsigned char> planes((k - 1) * length);
+        if (RAND_bytes(planes.data(), planes.size()) != 1)
+        {
+            dealer_status(request, DEALER_ERROR_INTERNAL);
+            return;
+        }
+        stream_compute_shares(pointers.data(), request->input, planes.data(), length, k, n, NULL);
+        OPENSSL_cleanse(planes.data(), planes.size());
+    } else if (op == DEALER_OP_COMBINE && body.size() == DEALER_HEADER_BYTES + (size_t) k) {
+        if (k < 1 || n != 0 || length < 1 || !dealer_abscissas(body.data() + DEALER_HEADER_BYTES, k))
+        {
+            dealer_status(request, DEALER_ERROR_RANGE);
+            return;
+        }
+        unsigned char weightData[255];
+        weights(weightData, body.data() + DEALER_HEADER_BYTES, k);
+        stream_reconstruct_chunk(request->output, pointers.data(), weightData, length, k, NULL);
+    } else {
+        dealer_status(request, DEALER_ERROR_REQUEST);
+        return;
+    }
+    batches_++;
+    dealer_status(request, DEALER_OK);
+}
+
+// Fonction qui écrit entièrement length octets sur une socket (sans SIGPIPE si le pair est parti)
+static bool dealer_send(int fd, const unsigned char * data, size_t length)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t sent = send(fd, data + done, length - done, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        done += sent;
+    }
+    return true;
+}
+
+// Fonction qui lit entièrement length octets sur une socket
+static bool dealer_receive(int fd, unsigned char * data, size_t length)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t got = recv(fd, data + done, length - done, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        done += got;
+    }
+    return true;
+}
+
+// Fonction qui lit une trame (taille u32 puis corps) sur une socket bloquante
+bool dealer_read_frame(int fd, std::vector<unsigned char> & body)
+{
+    unsigned char size[4];
+    if (!dealer_receive(fd, size, 4)) {
+        return false;
+    }
+    unsigned long long length = load_uint(size, 4);
+    if (length > DEALER_MAX_BODY) {
+        return false;
+    }
+    body.resize(length);
+    return dealer_receive(fd, body.data(), length);
+}
+
+// Fonction qui écrit une trame (taille u32 puis corps) sur une socket bloquante
+bool dealer_write_frame(int fd, const std::vector<unsigned char> & body)
+{
+    unsigned char size[4];
+    store_uint(size, body.size(), 4);
+    return dealer_send(fd, size, 4) && dealer_send(fd, body.data(), body.size());
+}
+
+// Fonction qui remplit l'adresse d'une socket Unix
+static bool dealer_address(struct sockaddr_un & address, const std::string & path)
+{
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    memcpy(address.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+// Fonction qui se connecte au dealer, renvoie la socket ou -1
+int dealer_connect(const std::string & path)
+{
+    struct sockaddr_un address;
+    if (!dealer_address(address, path)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+// Fonction qui crée une socket Unix d'écoute à path (mode 0600) ; échoue si un dealer y répond déjà
+int dealer_listen(const std::string & path)
+{
+    struct sockaddr_un address;
+    if (!dealer_address(address, path)) {
+        return -1;
+    }
+
+    // Une socket qui ne répond plus est celle d'un dealer arrêté brutalement : elle est remplacée. Tout autre
+    // fichier à path est laissé intact et l'ouverture échoue
+    struct stat status;
+    if (lstat(path.c_str(), &status) == 0)
+    {
+        if (!S_ISSOCK(status.st_mode)) {
+            return -1;
+        }
+        int existing = dealer_connect(path);
+        if (existing >= 0)
+        {
+            ::close(existing);
+            return -1;
+        }
+        unlink(path.c_str());
+    } else if (errno != ENOENT) {
+        return -1;
+    }
+
+    // Les connexions sont refusées jusqu'à listen : les droits sont restreints avant
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0 || chmod(path.c_str(), 0600) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+dealer_server::dealer_server() : listen_(-1), stopping_(false), active_(0)
+{
+}
+
+dealer_server::~dealer_server()
+{
+    close();
+}
+
+// Fonction qui crée la socket d'écoute à path et démarre workers threads de calcul
+bool dealer_server::open(const std::string & path, int workers)
+{
+    listen_ = dealer_listen(path);
+    if (listen_ < 0) {
+        return false;
+    }
+    path_ = path;
+    stopping_ = false;
+    return engine_.start(workers, DEALER_QUEUE_CAPACITY);
+}
+
+// Fonction qui accepte les connexions jusqu'à stop()
+void dealer_server::run()
+{
+    while (!stopping_)
+    {
+        int fd = accept4(listen_, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            // Trop de descripteurs ouverts : la connexion attend dans la file d'écoute
+            if (errno == EMFILE || errno == ENFILE) {
+                usleep(1000);
+            }
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections_.insert(fd);
+        active_++;
+        std::thread(&dealer_server::serve, this, fd).detach();
+    }
+}
+
+// Fonction qui interrompt run() ; utilisable depuis un gestionnaire de signal
+void dealer_server::stop()
+{
+    stopping_ = true;
+    if (listen_ >= 0) {
+        shutdown(listen_, SHUT_RDWR);
+    }
+}
+
+// Fonction qui ferme les connexions, arrête les workers une fois la file vide et supprime la socket
+void dealer_server::close()
+{
+    if (listen_ < 0) {
+        return;
+    }
+    stop();
+
+    // Les connexions en attente de lecture sont réveillées ; une requête en calcul reçoit encore sa réponse
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (std::set<int>::iterator it = connections_.begin(); it != connections_.end(); ++it) {
+            shutdown(*it, SHUT_RD);
+        }
+        closed_.wait(lock, [this] { return active_ == 0; });
+    }
+    engine_.stop();
+
+    ::close(listen_);
+    listen_ = -1;
+    unlink(path_.c_str());
+}
+
+// Attente d'une connexion : chaque connexion a sa variable de condition, un calcul terminé ne réveille que la sienne
+struct dealer_waiter : public dealer_listener
+{
+    std::mutex mutex;
+    std::condition_variable ready;
+
+    void completed(dealer_request * request)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        request->done = true;
+        ready.notify_one();
+    }
+};
+
+// Thread d'une connexion : une requête à la fois, réponse écrite dès son calcul terminé
+void dealer_server::serve(int fd)
+{
+    dealer_waiter waiter;
+    dealer_request request;
+    request.listener = &waiter;
+    while (dealer_read_frame(fd, request.body))
+    {
+        request.done = false;
+        if (!engine_.submit(&request)) {
+            dealer_status(&request, DEALER_ERROR_BUSY);
+        } else {
+            std::unique_lock<std::mutex> lock(waiter.mutex);
+            waiter.ready.wait(lock, [&request] { return request.done; });
+        }
+
+        bool ok = dealer_write_frame(fd, request.response);
+        OPENSSL_cleanse(request.response.data(), request.response.size());
+        if (!ok) {
+            break;
+        }
+    }
+    OPENSSL_cleanse(request.body.data(), request.body.size());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_.erase(fd);
+    ::close(fd);
+    active_--;
+    closed_.notify_all();
+}
+
+// Fonction qui échange une requête contre sa réponse sur la socket fd
+int dealer_call(int fd, const std::vector<unsigned char> & body, std::vector<unsigned char> & response)
+{
+    if (!dealer_write_frame(fd, body) || !dealer_read_frame(fd, response) || response.size() < DEALER_HEADER_BYTES) {
+        return DEALER_ERROR_IO;
+    }
+    return response[0];
+}
+
+// Fonction qui demande le partage d'un secret : shares reçoit les n parts (abscisses 1 ... n) de length octets bout à bout
+int dealer_split(int fd, const unsigned char * secret, size_t length, int k, int n, std::vector<unsigned char> & shares)
+{
+    // k et n tiennent chacun sur un octet de l'en-tête : hors limites, ils seraient tronqués
+    if (k < 2 || n < k || n > 255) {
+        return DEALER_ERROR_RANGE;
+    }
+
+    std::vector<unsigned char> body(DEALER_HEADER_BYTES + length), response;
+    body[0] = DEALER_OP_SPLIT;
+    body[1] = k;
+    body[2] = n;
+    body[3] = 0;
+    memcpy(body.data() + DEALER_HEADER_BYTES, secret, length);
+
+    int status = dealer_call(fd, body, response);
+    OPENSSL_cleanse(body.data(), body.size());
+    if (status == DEALER_OK && response.size() != DEALER_HEADER_BYTES + n * length) {
+        status = DEALER_ERROR_IO;
+    }
+    if (status == DEALER_OK) {
+        shares.assign(response.begin() + DEALER_HEADER_BYTES, response.end());
+    }
+    OPENSSL_cleanse(response.data(), response.size());
+    return status;
+}
+
+// Fonction qui demande la reconstruction d'un secret à partir de k parts de length octets et de leurs abscisses
+int dealer_combine(int fd, const int * x, const unsigned char * const * shares, int k, size_t length, std::vector<unsigned char> & secret)
+{
+    // Une abscisse tient sur un octet : 257 deviendrait 1 et donnerait un faux secret
+    if (k < 1 || k > 255) {
+        return DEALER_ERROR_RANGE;
+    }
+    for (int i = 0; i < k; i++)
+    {
+        if (x[i] < 1 || x[i] > 255) {
+            return DEALER_ERROR_RANGE;
+        }
+    }
+
+    std::vector<unsigned char> body(DEALER_HEADER_BYTES + k + k * length), response;
+    body[0] = DEALER_OP_COMBINE;
+    body[1] = k;
+    body[2] = 0;
+    body[3] = 0;
+    for (int i = 0; i < k; i++)
+    {
+        body[DEALER_HEADER_BYTES + i] = x[i];
+        memcpy(body.data() + DEALER_HEADER_BYTES + k + i * length, shares[i], length);
+    }
+
+    int status = dealer_call(fd, body, response);
+    OPENSSL_cleanse(body.data(), body.size());
+    if (status == DEALER_OK && response.size() != DEALER_HEADER_BYTES + length) {
+        status = DEALER_ERROR_IO;
+    }
+    if (status == DEALER_OK) {
+        secret.assign(response.begin() + DEALER_HEADER_BYTES, response.end());
+    }
+    OPENSSL_cleanse(response.data(), response.size());
+    return status;
+}
+
+// Fonction qui donne le message d'un statut du dealer
+const char * dealer_error_string(int error)
+{
+    switch (error)
+    {
+        case DEALER_OK: return "ok";
+        case DEALER_ERROR_REQUEST: return "malformed request";
+        case DEALER_ERROR_RANGE: return "k, n, abscissas or size out of range";
+        case DEALER_ERROR_BUSY: return "dealer busy, request rejected";
+        case DEALER_ERROR_INTERNAL: return "random generation failed";
+        case DEALER_ERROR_IO: return "connection to the dealer lost";
+        case DEALER_ERROR_CANCELLED: return "request cancelled";
+        default: return "unknown error";
+    }
+}
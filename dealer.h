@@ -0,0 +1,179 @@
+#ifndef DEALER_H
+#define DEALER_H
+
+#include "queue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define DEALER_HEADER_BYTES 4           // En-tête du corps d'une requête (opération, k, n, 0) ou d'une réponse (statut, 0, 0, 0)
+#define DEALER_MAX_SECRET 65536         // Taille maximale d'un secret (et d'une part)
+#define DEALER_MAX_BODY (4 + 255 + 255 * DEALER_MAX_SECRET) // Taille maximale du corps d'une requête ou d'une réponse
+#define DEALER_BATCH_BYTES (1 << 20)    // Octets de secrets au-delà desquels un worker ne prend plus de requête dans son lot
+#define DEALER_WEIGHT_CACHE 4096        // Jeux de poids de Lagrange gardés en cache
+#define DEALER_QUEUE_CAPACITY 1024      // Requêtes en attente de calcul au-delà desquelles le dealer refuse (DEALER_ERROR_BUSY)
+
+// Opérations du dealer
+#define DEALER_OP_SPLIT 1               // Seuil k >= 2 : avec k = 1, chaque part serait le secret en clair
+#define DEALER_OP_COMBINE 2
+
+// Codes de retour du dealer (statut des réponses)
+#define DEALER_OK 0
+#define DEALER_ERROR_REQUEST 1      // Requête mal formée
+#define DEALER_ERROR_RANGE 2        // k, n, abscisses ou taille hors des limites
+#define DEALER_ERROR_BUSY 3         // Requête refusée, service saturé
+#define DEALER_ERROR_INTERNAL 4     // Tirage aléatoire impossible
+#define DEALER_ERROR_IO 5           // Connexion au dealer perdue (côté client)
+#define DEALER_ERROR_CANCELLED 6    // Requête annulée avant son calcul
+
+struct dealer_request;
+
+// Avis de début et de fin de calcul d'une requête, appelés par le worker qui la calcule
+struct dealer_listener
+{
+    virtual ~dealer_listener() {}
+
+    // Renvoie false pour abandonner la requête sans la calculer (elle reçoit DEALER_ERROR_CANCELLED) ; completed est
+    // tout de même appelé
+    virtual bool starting(dealer_request *) { return true; }
+
+    virtual void completed(dealer_request * request) = 0;
+};
+
+// Requête en attente de calcul : le corps reçu, puis la réponse écrite par un worker
+// Une requête en place (input non nul) n'a dans body que l'en-tête et les abscisses : le worker lit le secret ou les
+// k parts à input et écrit les parts ou le secret à output, response ne reçoit que le statut
+struct dealer_request
+{
+    dealer_request() : listener(NULL), done(false), input(NULL), output(NULL), length(0) {}
+
+    std::vector<unsigned char> body;        // Opération, k, n, 0, puis le secret ou les abscisses et les parts
+    std::vector<unsigned char> response;    // Statut, 3 octets nuls, puis les parts ou le secret
+    dealer_listener * listener;             // Averti une fois response écrite
+    bool done;
+    const unsigned char * input;            // Requête en place : secret, ou k parts bout à bout
+    unsigned char * output;                 // Requête en place : n parts bout à bout, ou secret
+    size_t length;                          // Requête en place : taille d'un secret (et d'une part)
+};
+
+// Calcul des requêtes du dealer : des workers gardés chauds prennent toutes les requêtes en file à leur réveil et
+// calculent ensemble celles de mêmes paramètres (un seul appel aux noyaux GF(2^8) par groupe). La file est sans
+// verrou et bornée : une requête qui la trouve pleine est refusée plutôt que d'allonger l'attente de toutes
+class dealer_engine
+{
+public:
+    dealer_engine();
+    ~dealer_engine();
+
+    // Fonction qui démarre workers threads de calcul, avec une file de capacity requêtes
+    bool start(int workers, size_t capacity);
+
+    // Fonction qui met une requête en file ; son listener sera averti de la fin du calcul
+    // Renvoie false si la file est pleine (ou le calcul arrêté) : la requête n'est pas prise
+    bool submit(dealer_request * request);
+
+    // Nombre approché de requêtes en attente
+    size_t queued() const { return queue_ ? queue_->size() : 0; }
+
+    // Fonction qui arrête les workers une fois la file vide
+    void stop();
+
+    // Requêtes et groupes calculés depuis le démarrage
+    unsigned long long requests() const { return requests_; }
+    unsigned long long batches() const { return batches_; }
+
+private:
+    dealer_engine(const dealer_engine &);
+    dealer_engine & operator=(const dealer_engine &);
+
+    void work();
+    void process(std::vector<dealer_request *> & batch);
+    void compute(dealer_request * request);
+    bool weights(unsigned char * weights, const unsigned char * x, int k);
+
+    std::atomic<unsigned long long> requests_;
+    std::atomic<unsigned long long> batches_;
+
+    std::unique_ptr<ring_queue<dealer_request *> > queue_;
+    std::atomic<bool> stopping_;
+    std::atomic<int> sleeping_;             // Workers endormis : submit ne prend le verrou que pour les réveiller
+    std::mutex mutex_;
+    std::condition_variable pending_;       // Réveille les workers
+    std::vector<std::thread> workers_;
+
+    std::mutex cacheMutex_;
+    std::map<std::string, std::vector<unsigned char> > cache_;  // Abscisses (dans l'ordre) -> poids de Lagrange
+};
+
+// Dealer de longue durée derrière une socket Unix, un thread par connexion : l'état (workers, générateur aléatoire,
+// poids de Lagrange) reste chaud entre les requêtes
+class dealer_server
+{
+public:
+    dealer_server();
+    ~dealer_server();
+
+    // Fonction qui crée la socket d'écoute à path et démarre workers threads de calcul
+    bool open(const std::string & path, int workers);
+
+    // Fonction qui accepte les connexions jusqu'à stop()
+    void run();
+
+    // Fonction qui interrompt run() ; utilisable depuis un gestionnaire de signal
+    void stop();
+
+    // Fonction qui ferme les connexions, arrête les workers une fois la file vide et supprime la socket
+    void close();
+
+    const dealer_engine & engine() const { return engine_; }
+    dealer_engine & engine() { return engine_; }
+
+private:
+    dealer_server(const dealer_server &);
+    dealer_server & operator=(const dealer_server &);
+
+    void serve(int fd);
+
+    std::string path_;
+    int listen_;
+    std::atomic<bool> stopping_;
+    dealer_engine engine_;
+
+    std::mutex mutex_;                      // Protège les connexions
+    std::condition_variable closed_;        // Réveille close() à la fin d'une connexion
+    std::set<int> connections_;
+    int active_;                            // Threads de connexion en cours
+};
+
+// Fonction qui crée une socket Unix d'écoute à path (mode 0600) ; échoue si un dealer y répond déjà ou si path existe
+// sans être une socket (seule une socket abandonnée est remplacée)
+int dealer_listen(const std::string & path);
+
+// Fonctions qui lisent et écrivent une trame (taille u32 puis corps) sur une socket bloquante
+bool dealer_read_frame(int fd, std::vector<unsigned char> & body);
+bool dealer_write_frame(int fd, const std::vector<unsigned char> & body);
+
+// Fonction qui se connecte au dealer, renvoie la socket ou -1
+int dealer_connect(const std::string & path);
+
+// Fonction qui échange une requête contre sa réponse sur la socket fd
+int dealer_call(int fd, const std::vector<unsigned char> & body, std::vector<unsigned char> & response);
+
+// Fonction qui demande le partage d'un secret : shares reçoit les n parts (abscisses 1 ... n) de length octets bout à bout
+int dealer_split(int fd, const unsigned char * secret, size_t length, int k, int n, std::vector<unsigned char> & shares);
+
+// Fonction qui demande la reconstruction d'un secret à partir de k parts de length octets et de leurs abscisses
+int dealer_combine(int fd, const int * x, const unsigned char * const * shares, int k, size_t length, std::vector<unsigned char> & secret);
+
+// Fonction qui donne le message d'un statut du dealer
+const char * dealer_error_string(int error);
+
+#endif
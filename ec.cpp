@@ -0,0 +1,556 @@
+#include "ec.h"
+
+void ec_point_init(ec_point & P)
+{
+    mpz_init_set_ui(P.X, 1);
+    mpz_init_set_ui(P.Y, 1);
+    mpz_init_set_ui(P.Z, 0);
+}
+
+void ec_point_clear(ec_point & P)
+{
+    mpz_clear(P.X);
+    mpz_clear(P.Y);
+    mpz_clear(P.Z);
+}
+
+void ec_point_set(ec_point & R, const ec_point & P)
+{
+    mpz_set(R.X, P.X);
+    mpz_set(R.Y, P.Y);
+    mpz_set(R.Z, P.Z);
+}
+
+void ec_point_set_infinity(ec_point & P)
+{
+    mpz_set_ui(P.X, 1);
+    mpz_set_ui(P.Y, 1);
+    mpz_set_ui(P.Z, 0);
+}
+
+bool ec_point_is_infinity(const ec_point & P)
+{
+    return mpz_sgn(P.Z) == 0;
+}
+
+// Fonction qui initialise le groupe NIST P-256 (FIPS 186-4, D.1.2.3) et précalcule la table du générateur
+void ec_group_init_p256(ec_group & g)
+{
+    mpz_init_set_str(g.p, "ffffffff00000001000000000000000000000000ffffffffffffffffffffffff", 16);
+    mpz_init_set_str(g.b, "5ac635d8aa3a93e7b3ebbd55769886bc651d06b0cc53b0f63bce3c3e27d2604b", 16);
+    mpz_init_set_str(g.n, "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551", 16);
+
+    ec_point_init(g.G);
+    mpz_set_str(g.G.X, "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296", 16);
+    mpz_set_str(g.G.Y, "4fe342e2fe1a7f9b8ee7eb4a7c0f9e162bce33576b315ececbb6406837bf51f5", 16);
+    mpz_set_ui(g.G.Z, 1);
+
+    // Table à base fixe avec une fenêtre de 4 bits : 64 fenêtres de 16 multiples
+    // Une multiplication par G ne coûte alors plus que 64 additions et aucun doublement
+    g.table.resize(64 * 16);
+    for (int i = 0; i < 64 * 16; i++) {
+        ec_point_init(g.table[i]);
+    }
+
+    ec_point base;
+    ec_point_init(base);
+    ec_point_set(base, g.G);
+
+    for (int i = 0; i < 64; i++)
+    {
+        // table[16 * i + j] = j * base avec base = 16^i * G
+        for (int j = 1; j < 16; j++) {
+            ec_point_add(g.table[16 * i + j], g.table[16 * i + j - 1], base, g);
+        }
+
+        // base = 16 * base
+        for (int j = 0; j < 4; j++) {
+            ec_point_double(base, base, g);
+        }
+    }
+
+    ec_point_clear(base);
+}
+
+void ec_group_clear(ec_group & g)
+{
+    for (size_t i = 0; i < g.table.size(); i++) {
+        ec_point_clear(g.table[i]);
+    }
+    g.table.clear();
+
+    ec_point_clear(g.G);
+    mpz_clear(g.p);
+    mpz_clear(g.b);
+    mpz_clear(g.n);
+}
+
+// Fonction qui double un point (formules "dbl-2001-b" pour a = -3)
+void ec_point_double(ec_point & R, const ec_point & P, ec_group & g)
+{
+    if (ec_point_is_infinity(P) || mpz_sgn(P.Y) == 0) {
+        ec_point_set_infinity(R);
+        return;
+    }
+
+    mpz_t delta, gamma, beta, alpha, temp;
+    mpz_inits(delta, gamma, beta, alpha, temp, NULL);
+
+    mpz_mul(delta, P.Z, P.Z);               // delta = Z^2
+    mpz_mod(delta, delta, g.p);
+    mpz_mul(gamma, P.Y, P.Y);               // gamma = Y^2
+    mpz_mod(gamma, gamma, g.p);
+    mpz_mul(beta, P.X, gamma);              // beta = X * gamma
+    mpz_mod(beta, beta, g.p);
+
+    mpz_sub(alpha, P.X, delta);             // alpha = 3 * (X - delta) * (X + delta)
+    mpz_add(temp, P.X, delta);
+    mpz_mul(alpha, alpha, temp);
+    mpz_mul_ui(alpha, alpha, 3);
+    mpz_mod(alpha, alpha, g.p);
+
+    // Z3 = (Y + Z)^2 - gamma - delta (calculé avant d'écraser Y si R et P sont le même point)
+    mpz_add(temp, P.Y, P.Z);
+    mpz_mul(temp, temp, temp);
+    mpz_sub(temp, temp, gamma);
+    mpz_sub(temp, temp, delta);
+    mpz_mod(R.Z, temp, g.p);
+
+    // X3 = alpha^2 - 8 * beta
+    mpz_mul(R.X, alpha, alpha);
+    mpz_submul_ui(R.X, beta, 8);
+    mpz_mod(R.X, R.X, g.p);
+
+    // Y3 = alpha * (4 * beta - X3) - 8 * gamma^2
+    mpz_mul_ui(temp, beta, 4);
+    mpz_sub(temp, temp, R.X);
+    mpz_mul(temp, temp, alpha);
+    mpz_mul(gamma, gamma, gamma);
+    mpz_submul_ui(temp, gamma, 8);
+    mpz_mod(R.Y, temp, g.p);
+
+    mpz_clears(delta, gamma, beta, alpha, temp, NULL);
+}
+
+// Fonction qui additionne deux points (formules "add-2007-bl")
+void ec_point_add(ec_point & R, const ec_point & P, const ec_point & Q, ec_group & g)
+{
+    if (ec_point_is_infinity(P)) {
+        ec_point_set(R, Q);
+        return;
+    }
+    if (ec_point_is_infinity(Q)) {
+        ec_point_set(R, P);
+        return;
+    }
+
+    mpz_t z1z1, z2z2, u1, u2, s1, s2, h, i, j, r, v;
+    mpz_inits(z1z1, z2z2, u1, u2, s1, s2, h, i, j, r, v, NULL);
+
+    mpz_mul(z1z1, P.Z, P.Z);                // Z1Z1 = Z1^2
+    mpz_mod(z1z1, z1z1, g.p);
+    mpz_mul(z2z2, Q.Z, Q.Z);                // Z2Z2 = Z2^2
+    mpz_mod(z2z2, z2z2, g.p);
+    mpz_mul(u1, P.X, z2z2);                 // U1 = X1 * Z2Z2
+    mpz_mod(u1, u1, g.p);
+    mpz_mul(u2, Q.X, z1z1);                 // U2 = X2 * Z1Z1
+    mpz_mod(u2, u2, g.p);
+    mpz_mul(s1, P.Y, Q.Z);                  // S1 = Y1 * Z2 * Z2Z2
+    mpz_mul(s1, s1, z2z2);
+    mpz_mod(s1, s1, g.p);
+    mpz_mul(s2, Q.Y, P.Z);                  // S2 = Y2 * Z1 * Z1Z1
+    mpz_mul(s2, s2, z1z1);
+    mpz_mod(s2, s2, g.p);
+
+    mpz_sub(h, u2, u1);                     // H = U2 - U1
+    mpz_mod(h, h, g.p);
+    mpz_sub(r, s2, s1);                     // r = 2 * (S2 - S1)
+    mpz_mul_2exp(r, r, 1);
+    mpz_mod(r, r, g.p);
+
+    if (mpz_sgn(h) == 0)
+    {
+        // Même abscisse : soit P = Q (doublement), soit P = -Q (infini)
+        if (mpz_sgn(r) == 0) {
+            ec_point_double(R, P, g);
+        } else {
+            ec_point_set_infinity(R);
+        }
+        mpz_clears(z1z1, z2z2, u1, u2, s1, s2, h, i, j, r, v, NULL);
+        return;
+    }
+
+    mpz_mul_2exp(i, h, 1);                  // I = (2 * H)^2
+    mpz_mul(i, i, i);
+    mpz_mod(i, i, g.p);
+    mpz_mul(j, h, i);                       // J = H * I
+    mpz_mod(j, j, g.p);
+    mpz_mul(v, u1, i);                      // V = U1 * I
+    mpz_mod(v, v, g.p);
+
+    // Z3 = ((Z1 + Z2)^2 - Z1Z1 - Z2Z2) * H (calculé avant d'écraser les coordonnées de P ou Q)
+    mpz_add(u2, P.Z, Q.Z);
+    mpz_mul(u2, u2, u2);
+    mpz_sub(u2, u2, z1z1);
+    mpz_sub(u2, u2, z2z2);
+    mpz_mul(u2, u2, h);
+    mpz_mod(R.Z, u2, g.p);
+
+    // X3 = r^2 - J - 2 * V
+    mpz_mul(R.X, r, r);
+    mpz_sub(R.X, R.X, j);
+    mpz_submul_ui(R.X, v, 2);
+    mpz_mod(R.X, R.X, g.p);
+
+    // Y3 = r * (V - X3) - 2 * S1 * J
+    mpz_sub(v, v, R.X);
+    mpz_mul(v, v, r);
+    mpz_mul(s1, s1, j);
+    mpz_submul_ui(v, s1, 2);
+    mpz_mod(R.Y, v, g.p);
+
+    mpz_clears(z1z1, z2z2, u1, u2, s1, s2, h, i, j, r, v, NULL);
+}
+
+// Fonction qui renvoie 1 si a == b, 0 sinon, sans branchement (a, b < 2^31)
+static mp_limb_t ec_ct_equal(unsigned int a, unsigned int b)
+{
+    return (((a ^ b) - 1u) >> 31) & 1u;
+}
+
+// Fonction qui ajoute à buffer les limbs de value masqués par mask (0 ou tous les bits à 1)
+static void ec_limbs_accumulate(mp_limb_t * buffer, const mpz_t value, mp_limb_t mask, int limbs)
+{
+    for (int l = 0; l < limbs; l++) {
+        buffer[l] |= mask & mpz_getlimbn(value, l);
+    }
+}
+
+// Fonction qui recopie les limbs de buffer dans value
+static void ec_limbs_store(mpz_t value, const mp_limb_t * buffer, int limbs)
+{
+    mp_limb_t * out = mpz_limbs_write(value, limbs);
+    for (int l = 0; l < limbs; l++) {
+        out[l] = buffer[l];
+    }
+    mpz_limbs_finish(value, limbs);
+}
+
+// Fonction qui copie dans R l'entrée index des 16 points de table en les lisant tous : l'adresse lue ne dépend pas
+// de index (les coordonnées sont réduites modulo p, donc tiennent sur la taille de p)
+static void ec_point_lookup(ec_point & R, const ec_point * table, unsigned int index, ec_group & g)
+{
+    int limbs = mpz_size(g.p);
+    std::vector<mp_limb_t> x(limbs, 0), y(limbs, 0), z(limbs, 0);
+    for (unsigned int j = 0; j < 16; j++)
+    {
+        mp_limb_t mask = (mp_limb_t) 0 - ec_ct_equal(j, index);
+        ec_limbs_accumulate(x.data(), table[j].X, mask, limbs);
+        ec_limbs_accumulate(y.data(), table[j].Y, mask, limbs);
+        ec_limbs_accumulate(z.data(), table[j].Z, mask, limbs);
+    }
+    ec_limbs_store(R.X, x.data(), limbs);
+    ec_limbs_store(R.Y, y.data(), limbs);
+    ec_limbs_store(R.Z, z.data(), limbs);
+}
+
+// Fonction qui copie Q dans R si choose vaut 1, laisse R inchangé s'il vaut 0, sans branchement
+static void ec_point_choose(ec_point & R, const ec_point & Q, mp_limb_t choose, ec_group & g)
+{
+    int limbs = mpz_size(g.p);
+    mp_limb_t mask = (mp_limb_t) 0 - choose;
+    std::vector<mp_limb_t> x(limbs, 0), y(limbs, 0), z(limbs, 0);
+    ec_limbs_accumulate(x.data(), R.X, ~mask, limbs);
+    ec_limbs_accumulate(y.data(), R.Y, ~mask, limbs);
+    ec_limbs_accumulate(z.data(), R.Z, ~mask, limbs);
+    ec_limbs_accumulate(x.data(), Q.X, mask, limbs);
+    ec_limbs_accumulate(y.data(), Q.Y, mask, limbs);
+    ec_limbs_accumulate(z.data(), Q.Z, mask, limbs);
+    ec_limbs_store(R.X, x.data(), limbs);
+    ec_limbs_store(R.Y, y.data(), limbs);
+    ec_limbs_store(R.Z, z.data(), limbs);
+}
+
+// Fonction qui ajoute à acc l'entrée digit de table (16 multiples, table[0] = infini) sans que la suite des
+// opérations ne dépende de digit : l'entrée est lue par un balayage de toute la table et l'addition a toujours lieu,
+// avec table[1] comme valeur factice pour un chiffre nul, son résultat étant alors écarté par une sélection
+static void ec_point_add_digit(ec_point & acc, const ec_point * table, unsigned int digit, ec_point & entry, ec_point & sum, ec_group & g)
+{
+    mp_limb_t nonzero = 1 - ec_ct_equal(digit, 0);
+    ec_point_lookup(entry, table, digit | (nonzero ^ 1), g);
+    ec_point_add(sum, acc, entry, g);
+    ec_point_choose(acc, sum, nonzero, g);
+}
+
+/*
+ * Les deux multiplications scalaires suivent la même suite d'opérations quel que soit le scalaire : nombre de chiffres
+ * fixé par l'ordre n, une addition par chiffre, lecture de la table par balayage. Les opérations de GMP sur les mpz_t
+ * et les cas particuliers de ec_point_add (accumulateur encore à l'infini) ne sont en revanche pas à temps constant.
+ */
+
+// Fonction qui calcule k * P avec une fenêtre fixe de 4 bits
+void ec_point_mul(ec_point & R, mpz_t k, const ec_point & P, ec_group & g)
+{
+    mpz_t scalar;
+    mpz_init(scalar);
+    mpz_mod(scalar, k, g.n);
+
+    // Multiples 0 * P ... 15 * P
+    std::vector<ec_point> window(16);
+    for (int j = 0; j < 16; j++) {
+        ec_point_init(window[j]);
+    }
+    for (int j = 1; j < 16; j++) {
+        ec_point_add(window[j], window[j - 1], P, g);
+    }
+
+    ec_point acc, entry, sum;
+    ec_point_init(acc);
+    ec_point_init(entry);
+    ec_point_init(sum);
+
+    // On parcourt le scalaire par paquets de 4 bits, du poids fort au poids faible, sur toute la taille de n
+    int digits = (mpz_sizeinbase(g.n, 2) + 3) / 4;
+    for (int i = digits - 1; i >= 0; i--)
+    {
+        for (int j = 0; j < 4; j++) {
+            ec_point_double(acc, acc, g);
+        }
+
+        unsigned int digit = 0;
+        for (int j = 3; j >= 0; j--) {
+            digit = (digit << 1) | mpz_tstbit(scalar, 4 * i + j);
+        }
+        ec_point_add_digit(acc, window.data(), digit, entry, sum, g);
+    }
+
+    ec_point_set(R, acc);
+
+    ec_point_clear(sum);
+    ec_point_clear(entry);
+    ec_point_clear(acc);
+    for (int j = 0; j < 16; j++) {
+        ec_point_clear(window[j]);
+    }
+    mpz_clear(scalar);
+}
+
+// Fonction qui calcule k * P pour un scalaire public (une abscisse par exemple), en temps variable : doublement et
+// addition sur les seuls bits de k, soit quelques opérations pour un petit scalaire au lieu des 64 chiffres de ec_point_mul
+void ec_point_mul_public(ec_point & R, mpz_t k, const ec_point & P, ec_group & g)
+{
+    mpz_t scalar;
+    mpz_init(scalar);
+    mpz_mod(scalar, k, g.n);
+
+    // P est copié : R peut désigner le même point
+    ec_point base, acc;
+    ec_point_init(base);
+    ec_point_init(acc);
+    ec_point_set(base, P);
+
+    for (int i = (int) mpz_sizeinbase(scalar, 2) - 1; i >= 0 && mpz_sgn(scalar) != 0; i--)
+    {
+        ec_point_double(acc, acc, g);
+        if (mpz_tstbit(scalar, i)) {
+            ec_point_add(acc, acc, base, g);
+        }
+    }
+
+    ec_point_set(R, acc);
+
+    ec_point_clear(acc);
+    ec_point_clear(base);
+    mpz_clear(scalar);
+}
+
+// Fonction qui calcule k * G à partir de la table précalculée du générateur
+void ec_point_mul_base(ec_point & R, mpz_t k, ec_group & g)
+{
+    mpz_t scalar;
+    mpz_init(scalar);
+    mpz_mod(scalar, k, g.n);
+
+    ec_point acc, entry, sum;
+    ec_point_init(acc);
+    ec_point_init(entry);
+    ec_point_init(sum);
+
+    for (int i = 0; i < 64; i++)
+    {
+        unsigned int digit = 0;
+        for (int j = 3; j >= 0; j--) {
+            digit = (digit << 1) | mpz_tstbit(scalar, 4 * i + j);
+        }
+        ec_point_add_digit(acc, &g.table[16 * i], digit, entry, sum, g);
+    }
+
+    ec_point_set(R, acc);
+
+    ec_point_clear(sum);
+    ec_point_clear(entry);
+    ec_point_clear(acc);
+    mpz_clear(scalar);
+}
+
+// Fonction qui compare deux points sans repasser en coordonnées affines
+bool ec_point_equal(const ec_point & P, const ec_point & Q, ec_group & g)
+{
+    if (ec_point_is_infinity(P) || ec_point_is_infinity(Q)) {
+        return ec_point_is_infinity(P) && ec_point_is_infinity(Q);
+    }
+
+    mpz_t z1z1, z2z2, left, right;
+    mpz_inits(z1z1, z2z2, left, right, NULL);
+
+    mpz_mul(z1z1, P.Z, P.Z);
+    mpz_mul(z2z2, Q.Z, Q.Z);
+
+    // X1 * Z2^2 == X2 * Z1^2
+    mpz_mul(left, P.X, z2z2);
+    mpz_mul(right, Q.X, z1z1);
+    mpz_sub(left, left, right);
+    mpz_mod(left, left, g.p);
+    bool equal = mpz_sgn(left) == 0;
+
+    // Y1 * Z2^3 == Y2 * Z1^3
+    if (equal)
+    {
+        mpz_mul(left, P.Y, z2z2);
+        mpz_mul(left, left, Q.Z);
+        mpz_mul(right, Q.Y, z1z1);
+        mpz_mul(right, right, P.Z);
+        mpz_sub(left, left, right);
+        mpz_mod(left, left, g.p);
+        equal = mpz_sgn(left) == 0;
+    }
+
+    mpz_clears(z1z1, z2z2, left, right, NULL);
+    return equal;
+}
+
+// Fonction qui ramène un point en coordonnées affines (Z = 1)
+static void ec_point_to_affine(mpz_t x, mpz_t y, const ec_point & P, ec_group & g)
+{
+    mpz_t zinv, zinv2;
+    mpz_inits(zinv, zinv2, NULL);
+
+    mpz_invert(zinv, P.Z, g.p);
+    mpz_mul(zinv2, zinv, zinv);
+    mpz_mod(zinv2, zinv2, g.p);
+
+    mpz_mul(x, P.X, zinv2);                 // x = X / Z^2
+    mpz_mod(x, x, g.p);
+    mpz_mul(y, P.Y, zinv2);                 // y = Y / Z^3
+    mpz_mul(y, y, zinv);
+    mpz_mod(y, y, g.p);
+
+    mpz_clears(zinv, zinv2, NULL);
+}
+
+// Fonction qui calcule x^3 - 3x + b modulo p
+static void ec_curve_rhs(mpz_t rhs, mpz_t x, ec_group & g)
+{
+    mpz_mul(rhs, x, x);
+    mpz_sub_ui(rhs, rhs, 3);
+    mpz_mul(rhs, rhs, x);
+    mpz_add(rhs, rhs, g.b);
+    mpz_mod(rhs, rhs, g.p);
+}
+
+// Fonction qui vérifie qu'un point appartient à la courbe
+bool ec_point_on_curve(const ec_point & P, ec_group & g)
+{
+    if (ec_point_is_infinity(P)) {
+        return true;
+    }
+
+    mpz_t x, y, rhs;
+    mpz_inits(x, y, rhs, NULL);
+
+    ec_point_to_affine(x, y, P, g);
+    ec_curve_rhs(rhs, x, g);
+    mpz_mul(y, y, y);
+    mpz_mod(y, y, g.p);
+    bool on_curve = mpz_cmp(y, rhs) == 0;
+
+    mpz_clears(x, y, rhs, NULL);
+    return on_curve;
+}
+
+// Fonction qui encode un point sous forme compressée : 0x02/0x03 selon la parité de y, puis x sur 32 octets
+// Le point à l'infini est encodé par 33 octets nuls
+void ec_point_encode(unsigned char * out, const ec_point & P, ec_group & g)
+{
+    for (int i = 0; i < EC_POINT_BYTES; i++) {
+        out[i] = 0;
+    }
+    if (ec_point_is_infinity(P)) {
+        return;
+    }
+
+    mpz_t x, y;
+    mpz_inits(x, y, NULL);
+    ec_point_to_affine(x, y, P, g);
+
+    out[0] = mpz_odd_p(y) ? 0x03 : 0x02;
+
+    // Export big-endian, aligné à droite sur 32 octets
+    size_t count = 0;
+    unsigned char buffer[32];
+    mpz_export(buffer, &count, 1, 1, 1, 0, x);
+    for (size_t i = 0; i < count; i++) {
+        out[1 + 32 - count + i] = buffer[i];
+    }
+
+    mpz_clears(x, y, NULL);
+}
+
+// Fonction qui décode un point compressé, renvoie false si l'encodage n'est pas un point de la courbe
+bool ec_point_decode(ec_point & P, const unsigned char * in, ec_group & g)
+{
+    if (in[0] == 0x00)
+    {
+        for (int i = 1; i < EC_POINT_BYTES; i++) {
+            if (in[i] != 0) {
+                return false;
+            }
+        }
+        ec_point_set_infinity(P);
+        return true;
+    }
+    if (in[0] != 0x02 && in[0] != 0x03) {
+        return false;
+    }
+
+    mpz_t x, y, rhs, e;
+    mpz_inits(x, y, rhs, e, NULL);
+    mpz_import(x, 32, 1, 1, 1, 0, in + 1);
+
+    bool valid = mpz_cmp(x, g.p) < 0;
+    if (valid)
+    {
+        // p = 3 mod 4 : la racine carrée est rhs^((p + 1) / 4)
+        ec_curve_rhs(rhs, x, g);
+        mpz_add_ui(e, g.p, 1);
+        mpz_fdiv_q_2exp(e, e, 2);
+        mpz_powm(y, rhs, e, g.p);
+
+        mpz_mul(e, y, y);
+        mpz_mod(e, e, g.p);
+        valid = mpz_cmp(e, rhs) == 0;
+    }
+
+    if (valid)
+    {
+        if ((mpz_odd_p(y) ? 0x03 : 0x02) != in[0]) {
+            mpz_sub(y, g.p, y);
+        }
+        mpz_set(P.X, x);
+        mpz_set(P.Y, y);
+        mpz_set_ui(P.Z, 1);
+    }
+
+    mpz_clears(x, y, rhs, e, NULL);
+    return valid;
+}
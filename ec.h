@@ -0,0 +1,53 @@
+#ifndef EC_H
+#define EC_H
+
+#include <gmp.h>
+#include <vector>
+
+#define EC_POINT_BYTES 33 // Taille d'un point compressé (SEC1) : 1 octet de signe + 32 octets d'abscisse
+
+// Point d'une courbe en coordonnées jacobiennes (X/Z^2, Y/Z^3), Z = 0 pour le point à l'infini
+struct ec_point
+{
+    mpz_t X;
+    mpz_t Y;
+    mpz_t Z;
+};
+
+// Groupe d'ordre premier n d'une courbe y^2 = x^3 - 3x + b sur Z/pZ
+struct ec_group
+{
+    mpz_t p;                        // Corps de base de la courbe
+    mpz_t b;                        // Coefficient b de l'équation (a = -3)
+    mpz_t n;                        // Ordre premier du groupe : c'est le corps de compute_shares
+    ec_point G;                     // Générateur
+    std::vector<ec_point> table;    // Multiples précalculés de G : table[16 * i + j] = j * 16^i * G
+};
+
+// Fonctions de gestion des points
+void ec_point_init(ec_point & P);
+void ec_point_clear(ec_point & P);
+void ec_point_set(ec_point & R, const ec_point & P);
+void ec_point_set_infinity(ec_point & P);
+bool ec_point_is_infinity(const ec_point & P);
+
+// Fonction qui initialise le groupe NIST P-256 et précalcule la table du générateur
+void ec_group_init_p256(ec_group & g);
+
+// Fonction qui libère le groupe
+void ec_group_clear(ec_group & g);
+
+// Opérations du groupe
+void ec_point_double(ec_point & R, const ec_point & P, ec_group & g);
+void ec_point_add(ec_point & R, const ec_point & P, const ec_point & Q, ec_group & g);
+void ec_point_mul(ec_point & R, mpz_t k, const ec_point & P, ec_group & g);
+void ec_point_mul_base(ec_point & R, mpz_t k, ec_group & g);
+void ec_point_mul_public(ec_point & R, mpz_t k, const ec_point & P, ec_group & g);
+bool ec_point_equal(const ec_point & P, const ec_point & Q, ec_group & g);
+bool ec_point_on_curve(const ec_point & P, ec_group & g);
+
+// Fonctions d'encodage compressé des points (33 octets)
+void ec_point_encode(unsigned char * out, const ec_point & P, ec_group & g);
+bool ec_point_decode(ec_point & P, const unsigned char * in, ec_group & g);
+
+#endif
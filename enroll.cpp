@@ -0,0 +1,99 @@
+#include "enroll.h"
+#include "refresh.h"
+
+/*
+ * Enrôlement d'un nouveau participant sans reconstruire le secret.
+ * La part du nouveau participant est P(xNew) = somme des L_i(xNew) * y_i sur k détenteurs.
+ * Chaque détenteur i n'envoie au nouveau participant que L_i(xNew) * y_i + r_i, où les masques r_i
+ * se compensent (somme nulle) : le nouveau participant n'apprend que P(xNew), ni les y_i ni le secret.
+ * Les masques viennent des graines que chaque paire de détenteurs (i, j) a convenues par un canal privé :
+ * le détenteur de plus petit indice ajoute la valeur dérivée de la graine, l'autre la soustrait. La valeur est
+ * dérivée par la PRF AES-256-CTR du rafraîchissement (refresh_derive_deltas) : un générateur statistique comme
+ * Mersenne Twister laisserait retrouver les masques, donc les y_i.
+ */
+
+// Fonction qui calcule le poids de Lagrange L_i(xNew) = alphas[i] * produit des (xNew - x[j]) pour j != i
+// Les alphas sont les poids barycentriques de compute_lagrange_coefficients, calculés une fois pour l'ensemble des xi :
+// chaque détenteur n'a plus que k multiplications à faire quel que soit le nouveau participant
+void enroll_lagrange_weight(mpz_t weight, std::vector<mpz_t> & alphas, mpz_t * x, int k, int i, mpz_t xNew, mpz_t prime)
+{
+    mpz_t temp;
+    mpz_init(temp);
+
+    mpz_set(weight, alphas[i]);
+
+    for (int j = 0; j < k; j++)
+    {
+        if (j != i) {
+            mpz_sub(temp, xNew, x[j]);          // xNew - x[j]
+            mpz_mul(weight, weight, temp);
+            mpz_mod(weight, weight, prime);
+        }
+    }
+
+    mpz_clear(temp);
+}
+
+// Fonction qui calcule le masque du détenteur i à partir des graines partagées avec chacun des autres détenteurs
+bool enroll_mask(mpz_t mask, const unsigned char * const * pairSeeds, int i, int k, mpz_t prime)
+{
+    field_batch derived;
+    mpz_t value;
+    mpz_init(value);
+    bool ok = true;
+
+    mpz_set_ui(mask, 0);
+
+    for (int j = 0; j < k && ok; j++)
+    {
+        if (j == i) {
+            continue;
+        }
+
+        // La graine de la paire (i, j) donne la même valeur aux deux détenteurs
+        ok = refresh_derive_deltas(derived, pairSeeds[j], 1, prime);
+        field_batch_get(value, derived, 0);
+
+        if (i < j) {
+            mpz_add(mask, mask, value);
+        } else {
+            mpz_sub(mask, mask, value);
+        }
+    }
+
+    mpz_mod(mask, mask, prime);
+    mpz_clear(value);
+    return ok;
+}
+
+// Fonction qui calcule la contribution masquée du détenteur i pour la part du nouveau participant d'abscisse xNew
+// pairSeeds[j] est la graine que le détenteur i partage avec le détenteur j (pairSeeds[i] n'est pas utilisée)
+bool enroll_partial(mpz_t partial, std::vector<mpz_t> & alphas, mpz_t * x, int k, int i, mpz_t share, mpz_t xNew,
+                    const unsigned char * const * pairSeeds, mpz_t prime)
+{
+    mpz_t mask;
+    mpz_init(mask);
+
+    enroll_lagrange_weight(partial, alphas, x, k, i, xNew, prime);
+    mpz_mul(partial, partial, share);                   // L_i(xNew) * y_i
+
+    bool ok = enroll_mask(mask, pairSeeds, i, k, prime);
+    mpz_add(partial, partial, mask);                    // L_i(xNew) * y_i + r_i
+    mpz_mod(partial, partial, prime);
+
+    mpz_clear(mask);
+    return ok;
+}
+
+// Fonction qui combine les k contributions pour obtenir la part du nouveau participant
+void enroll_combine(mpz_t newShare, mpz_t * partials, int k, mpz_t prime)
+{
+    mpz_set_ui(newShare, 0);
+
+    // Les masques s'annulent dans la somme
+    for (int i = 0; i < k; i++) {
+        mpz_add(newShare, newShare, partials[i]);
+    }
+
+    mpz_mod(newShare, newShare, prime);
+}
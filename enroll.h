@@ -0,0 +1,21 @@
+#ifndef ENROLL_H
+#define ENROLL_H
+
+#include <gmp.h>
+#include <vector>
+
+// Fonction qui calcule le poids de Lagrange L_i(xNew) du détenteur i à partir des poids barycentriques en cache
+void enroll_lagrange_weight(mpz_t weight, std::vector<mpz_t> & alphas, mpz_t * x, int k, int i, mpz_t xNew, mpz_t prime);
+
+// Fonction qui calcule le masque du détenteur i à partir des graines (REFRESH_SEED_BYTES octets, voir refresh_generate_seed)
+// partagées avec chacun des autres détenteurs
+bool enroll_mask(mpz_t mask, const unsigned char * const * pairSeeds, int i, int k, mpz_t prime);
+
+// Fonction qui calcule la contribution masquée du détenteur i pour la part du nouveau participant d'abscisse xNew
+bool enroll_partial(mpz_t partial, std::vector<mpz_t> & alphas, mpz_t * x, int k, int i, mpz_t share, mpz_t xNew,
+                    const unsigned char * const * pairSeeds, mpz_t prime);
+
+// Fonction qui combine les k contributions pour obtenir la part du nouveau participant
+void enroll_combine(mpz_t newShare, mpz_t * partials, int k, mpz_t prime);
+
+#endif
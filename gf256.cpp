@@ -0,0 +1,220 @@
+#include "gf256.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GF256_X86 1
+#endif
+
+/*
+ * Arithmétique de GF(2^8) pour la dispersion et le partage des données en masse.
+ * Les produits d'une zone par un coefficient c utilisent deux tables de 16 octets : c * v = low[v & 15] ^ high[v >> 4].
+ * Sur x86 ces tables tiennent dans un registre et pshufb fait 16 (SSSE3) ou 32 (AVX2) recherches par instruction ;
+ * le jeu d'instructions est choisi à l'exécution, le binaire reste donc portable.
+ */
+
+static unsigned char gf256_exp[512];
+static unsigned char gf256_log[256];
+
+// Tables construites à l'initialisation statique (avant tout appel, y compris depuis d'autres threads)
+static bool gf256_init()
+{
+    unsigned int value = 1;
+    for (int i = 0; i < 255; i++)
+    {
+        gf256_exp[i] = value;
+        gf256_log[value] = i;
+
+        value <<= 1;
+        if (value & 0x100) {
+            value ^= 0x11d;
+        }
+    }
+    for (int i = 255; i < 512; i++) {
+        gf256_exp[i] = gf256_exp[i - 255];
+    }
+    return true;
+}
+
+static bool gf256_initialized = gf256_init();
+
+unsigned char gf256_mul(unsigned char a, unsigned char b)
+{
+    if (a == 0 || b == 0) {
+        return 0;
+    }
+    return gf256_exp[gf256_log[a] + gf256_log[b]];
+}
+
+unsigned char gf256_inv(unsigned char a)
+{
+    return gf256_exp[255 - gf256_log[a]];
+}
+
+// Fonction qui calcule les tables des produits par le coefficient des quartets de poids faible et de poids fort
+static void gf256_nibble_tables(unsigned char coefficient, unsigned char * low, unsigned char * high)
+{
+    for (int v = 0; v < 16; v++) {
+        low[v] = gf256_mul(coefficient, v);
+        high[v] = gf256_mul(coefficient, v << 4);
+    }
+}
+
+// Noyau portable : traite les octets restants ou toute la zone sans SIMD
+static void gf256_region_scalar(unsigned char * dst, const unsigned char * src, const unsigned char * low, const unsigned char * high, size_t length, bool accumulate)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char product = low[src[i] & 0x0f] ^ high[src[i] >> 4];
+        dst[i] = accumulate ? dst[i] ^ product : product;
+    }
+}
+
+#ifdef GF256_X86
+__attribute__((target("ssse3")))
+static size_t gf256_region_ssse3(unsigned char * dst, const unsigned char * src, const unsigned char * low, const unsigned char * high, size_t length, bool accumulate)
+{
+    __m128i tableLow = _mm_loadu_si128((const __m128i *) low);
+    __m128i tableHigh = _mm_loadu_si128((const __m128i *) high);
+    __m128i mask = _mm_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i product = _mm_xor_si128(_mm_shuffle_epi8(tableLow, _mm_and_si128(v, mask)),
+                                        _mm_shuffle_epi8(tableHigh, _mm_and_si128(_mm_srli_epi64(v, 4), mask)));
+        if (accumulate) {
+            product = _mm_xor_si128(product, _mm_loadu_si128((const __m128i *) (dst + i)));
+        }
+        _mm_storeu_si128((__m128i *) (dst + i), product);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t gf256_region_avx2(unsigned char * dst, const unsigned char * src, const unsigned char * low, const unsigned char * high, size_t length, bool accumulate)
+{
+    __m256i tableLow = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) low));
+    __m256i tableHigh = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) high));
+    __m256i mask = _mm256_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i product = _mm256_xor_si256(_mm256_shuffle_epi8(tableLow, _mm256_and_si256(v, mask)),
+                                           _mm256_shuffle_epi8(tableHigh, _mm256_and_si256(_mm256_srli_epi64(v, 4), mask)));
+        if (accumulate) {
+            product = _mm256_xor_si256(product, _mm256_loadu_si256((const __m256i *) (dst + i)));
+        }
+        _mm256_storeu_si256((__m256i *) (dst + i), product);
+    }
+    return i;
+}
+
+// Détection du processeur, __builtin_cpu_init est nécessaire car elle a lieu pendant l'initialisation statique
+static bool gf256_cpu_supports(int feature)
+{
+    __builtin_cpu_init();
+    return feature == 2 ? __builtin_cpu_supports("avx2") : __builtin_cpu_supports("ssse3");
+}
+
+static const bool gf256_has_avx2 = gf256_cpu_supports(2);
+static const bool gf256_has_ssse3 = gf256_cpu_supports(1);
+#endif
+
+// Fonction qui choisit le meilleur noyau disponible pour la zone
+static void gf256_region(unsigned char * dst, const unsigned char * src, unsigned char coefficient, size_t length, bool accumulate)
+{
+    unsigned char low[16], high[16];
+    gf256_nibble_tables(coefficient, low, high);
+
+    size_t done = 0;
+#ifdef GF256_X86
+    if (gf256_has_avx2) {
+        done = gf256_region_avx2(dst, src, low, high, length, accumulate);
+    } else if (gf256_has_ssse3) {
+        done = gf256_region_ssse3(dst, src, low, high, length, accumulate);
+    }
+#endif
+    gf256_region_scalar(dst + done, src + done, low, high, length - done, accumulate);
+}
+
+// Fonction qui calcule dst = dst + coefficient * src sur une zone de length octets
+void gf256_region_muladd(unsigned char * dst, const unsigned char * src, unsigned char coefficient, size_t length)
+{
+    if (coefficient == 0) {
+        return;
+    }
+    if (coefficient == 1)
+    {
+        for (size_t i = 0; i < length; i++) {
+            dst[i] ^= src[i];
+        }
+        return;
+    }
+    gf256_region(dst, src, coefficient, length, true);
+}
+
+// Fonction qui calcule dst = coefficient * src sur une zone de length octets
+void gf256_region_mul(unsigned char * dst, const unsigned char * src, unsigned char coefficient, size_t length)
+{
+    if (coefficient == 0) {
+        memset(dst, 0, length);
+        return;
+    }
+    if (coefficient == 1) {
+        memmove(dst, src, length);
+        return;
+    }
+    gf256_region(dst, src, coefficient, length, false);
+}
+
+// Fonction qui inverse une matrice k x k par la méthode de Gauss-Jordan, renvoie false si elle est singulière
+bool gf256_invert_matrix(std::vector<unsigned char> & matrix, std::vector<unsigned char> & inverse, int k)
+{
+    inverse.assign(k * k, 0);
+    for (int i = 0; i < k; i++) {
+        inverse[i * k + i] = 1;
+    }
+
+    for (int c = 0; c < k; c++)
+    {
+        // Recherche d'un pivot non nul dans la colonne c
+        int pivot = c;
+        while (pivot < k && matrix[pivot * k + c] == 0) {
+            pivot++;
+        }
+        if (pivot == k) {
+            return false;
+        }
+        for (int j = 0; j < k; j++) {
+            std::swap(matrix[c * k + j], matrix[pivot * k + j]);
+            std::swap(inverse[c * k + j], inverse[pivot * k + j]);
+        }
+
+        // Normalisation de la ligne du pivot
+        unsigned char factor = gf256_inv(matrix[c * k + c]);
+        for (int j = 0; j < k; j++) {
+            matrix[c * k + j] = gf256_mul(matrix[c * k + j], factor);
+            inverse[c * k + j] = gf256_mul(inverse[c * k + j], factor);
+        }
+
+        // Elimination de la colonne c dans les autres lignes
+        for (int r = 0; r < k; r++)
+        {
+            unsigned char coefficient = matrix[r * k + c];
+            if (r == c || coefficient == 0) {
+                continue;
+            }
+            for (int j = 0; j < k; j++) {
+                matrix[r * k + j] ^= gf256_mul(coefficient, matrix[c * k + j]);
+                inverse[r * k + j] ^= gf256_mul(coefficient, inverse[c * k + j]);
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,20 @@
+#ifndef GF256_H
+#define GF256_H
+
+#include <cstddef>
+#include <vector>
+
+// Fonctions de calcul dans GF(2^8) (polynome x^8 + x^4 + x^3 + x^2 + 1), l'addition est le ou exclusif
+unsigned char gf256_mul(unsigned char a, unsigned char b);
+unsigned char gf256_inv(unsigned char a);
+
+// Fonction qui calcule dst = dst + coefficient * src sur une zone de length octets (SSSE3 / AVX2 si disponibles)
+void gf256_region_muladd(unsigned char * dst, const unsigned char * src, unsigned char coefficient, size_t length);
+
+// Fonction qui calcule dst = coefficient * src sur une zone de length octets
+void gf256_region_mul(unsigned char * dst, const unsigned char * src, unsigned char coefficient, size_t length);
+
+// Fonction qui inverse une matrice k x k par la méthode de Gauss-Jordan, renvoie false si elle est singulière
+bool gf256_invert_matrix(std::vector<unsigned char> & matrix, std::vector<unsigned char> & inverse, int k);
+
+#endif
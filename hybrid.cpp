@@ -0,0 +1,381 @@
+#include "hybrid.h"
+#include "shamir.h"
+#include "ida.h"
+
+#include <algorithm>
+#include <string>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+/*
+ * Mode hybride de Krawczyk ("secret sharing made short") pour les gros fichiers :
+ * 1. les données sont chiffrées avec une clé aléatoire de 256 bits (AES-256-GCM ou ChaCha20-Poly1305),
+ * 2. le chiffré est dispersé en n fragments dont k suffisent (code systématique de ida.h), chacun de 1 / k de sa taille,
+ * 3. seule la clé est partagée par Shamir, dans le corps Z/pZ avec p le premier nombre premier au-delà de 2^256.
+ * Le stockage total passe de n fois la taille des données à n / k fois, et le débit est celui du chiffrement.
+ * Moins de k parts ne révèlent ni la clé ni donc les données ; la taille des données reste publique.
+ *
+ * Comme pour le partage en flux, l'entrée est traitée par morceaux de taille fixe avec une mémoire bornée : chaque
+ * morceau est chiffré avec sa propre étiquette, puis le morceau chiffré et son étiquette sont dispersés et leurs
+ * fragments écrits aussitôt. Le nonce d'un morceau est le nonce de base combiné à son indice, et les données
+ * associées lient l'indice, la taille et le drapeau de dernier morceau : un morceau déplacé, modifié ou supprimé,
+ * ou une part tronquée, fait échouer l'authentification.
+ *
+ * Format d'une part : en-tête (hybrid_write_header) puis, pour chaque morceau de L octets en clair,
+ * L sur 4 octets, le drapeau HYBRID_LAST_CHUNK sur 1 octet et le fragment de ceil((L + HYBRID_TAG_BYTES) / k) octets.
+ */
+
+#define HYBRID_MAGIC "TP7H"
+#define HYBRID_VERSION 3
+#define HYBRID_LAST_CHUNK 1 // Drapeau du dernier morceau
+
+void hybrid_share_init(hybrid_share & share)
+{
+    share.cipher = HYBRID_AES_256_GCM;
+    share.k = 0;
+    share.n = 0;
+    share.index = 0;
+    share.chunkSize = 0;
+    mpz_init(share.keyShare);
+}
+
+void hybrid_share_clear(hybrid_share & share)
+{
+    mpz_clear(share.keyShare);
+}
+
+// Fonction qui donne l'algorithme OpenSSL correspondant
+static const EVP_CIPHER * hybrid_evp_cipher(int cipher)
+{
+    switch (cipher)
+    {
+        case HYBRID_AES_256_GCM: return EVP_aes_256_gcm();
+        case HYBRID_CHACHA20_POLY1305: return EVP_chacha20_poly1305();
+        default: return NULL;
+    }
+}
+
+// Fonction qui crée le contexte de chiffrement (ou de déchiffrement) d'un partage, réutilisé pour tous ses morceaux
+static EVP_CIPHER_CTX * hybrid_cipher_ctx(int cipher, bool encrypt)
+{
+    const EVP_CIPHER * evpCipher = hybrid_evp_cipher(cipher);
+    EVP_CIPHER_CTX * ctx = evpCipher != NULL ? EVP_CIPHER_CTX_new() : NULL;
+    if (ctx != NULL && (EVP_CipherInit_ex(ctx, evpCipher, NULL, NULL, NULL, encrypt ? 1 : 0) != 1
+                        || EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, HYBRID_IV_BYTES, NULL) != 1))
+    {
+        EVP_CIPHER_CTX_free(ctx);
+        ctx = NULL;
+    }
+    return ctx;
+}
+
+// Fonction qui chiffre ou déchiffre le morceau chunk avec authentification (indice, taille et drapeau de fin liés au chiffré)
+// En chiffrement l'étiquette est produite, en déchiffrement elle est vérifiée
+static bool hybrid_crypt(EVP_CIPHER_CTX * ctx, unsigned char * out, const unsigned char * in, size_t length, const unsigned char * key,
+                         const unsigned char * iv, unsigned long long chunk, bool last, unsigned char * tag, bool encrypt)
+{
+    // Nonce du morceau : nonce de base dont les 8 derniers octets sont combinés à l'indice
+    unsigned char nonce[HYBRID_IV_BYTES];
+    std::copy(iv, iv + HYBRID_IV_BYTES, nonce);
+    for (int b = 0; b < 8; b++) {
+        nonce[HYBRID_IV_BYTES - 1 - b] ^= (unsigned char) (chunk >> (8 * b));
+    }
+
+    // Données associées : l'indice sur 8 octets, la taille en clair sur 4 octets et le drapeau de fin
+    unsigned char aad[13];
+    for (int b = 0; b < 8; b++) {
+        aad[b] = chunk >> (8 * b);
+    }
+    for (int b = 0; b < 4; b++) {
+        aad[8 + b] = (unsigned long long) length >> (8 * b);
+    }
+    aad[12] = last ? HYBRID_LAST_CHUNK : 0;
+
+    int written = 0;
+    bool ok = EVP_CipherInit_ex(ctx, NULL, NULL, key, nonce, encrypt ? 1 : 0) == 1
+        && EVP_CipherUpdate(ctx, NULL, &written, aad, sizeof(aad)) == 1
+        && (length == 0 || (EVP_CipherUpdate(ctx, out, &written, in, length) == 1 && written == (int) length));
+
+    if (ok && !encrypt) {
+        ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, HYBRID_TAG_BYTES, tag) == 1;
+    }
+    unsigned char final[32];
+    ok = ok && EVP_CipherFinal_ex(ctx, final, &written) == 1;
+    if (ok && encrypt) {
+        ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, HYBRID_TAG_BYTES, tag) == 1;
+    }
+    return ok;
+}
+
+// Fonctions d'écriture et de lecture d'entiers en little-endian
+static void write_uint(std::ostream & out, unsigned long long value, int bytes)
+{
+    for (int b = 0; b < bytes; b++) {
+        out.put((char) (value >> (8 * b)));
+    }
+}
+
+static unsigned long long read_uint(std::istream & in, int bytes)
+{
+    unsigned long long value = 0;
+    for (int b = 0; b < bytes; b++) {
+        value |= (unsigned long long) (unsigned char) in.get() << (8 * b);
+    }
+    return value;
+}
+
+// Fonction qui chiffre l'entrée morceau par morceau, disperse chaque morceau chiffré en n = outputs.size() fragments et
+// partage la clé avec un seuil k : outputs[i] reçoit la part d'indice i, écrite au fil des morceaux
+// gmpRandState sert aux coefficients du polynome de la clé : il doit avoir été initialisé avec une graine imprévisible
+bool hybrid_split(std::istream & input, std::vector<std::ostream *> & outputs, int k, size_t chunkSize, int cipher, gmp_randstate_t gmpRandState)
+{
+    int n = outputs.size();
+    if (k < 1 || k > n || n > 255 || chunkSize == 0 || chunkSize > HYBRID_MAX_CHUNK || hybrid_evp_cipher(cipher) == NULL) {
+        return false;
+    }
+
+    // Clé et nonce de base aléatoires
+    unsigned char key[HYBRID_KEY_BYTES], iv[HYBRID_IV_BYTES];
+    if (RAND_bytes(key, HYBRID_KEY_BYTES) != 1 || RAND_bytes(iv, HYBRID_IV_BYTES) != 1) {
+        return false;
+    }
+
+    // Partage de Shamir de la clé, écrit dans l'en-tête de chaque part
+    mpz_t prime, secret, x;
+    mpz_inits(prime, secret, x, NULL);
+    generate_field_prime(prime, HYBRID_KEY_BYTES);
+    mpz_import(secret, HYBRID_KEY_BYTES, 1, 1, 1, 0, key);
+
+    std::vector<mpz_t> coefficients(k);
+    generate_coefficients(coefficients, prime, k, secret, gmpRandState);
+
+    bool ok = true;
+    hybrid_share share;
+    hybrid_share_init(share);
+    share.cipher = cipher;
+    share.k = k;
+    share.n = n;
+    share.chunkSize = chunkSize;
+    std::copy(iv, iv + HYBRID_IV_BYTES, share.iv);
+    for (int i = 0; i < n; i++)
+    {
+        share.index = i;
+        mpz_set_ui(x, i + 1);
+        evaluate_polynomial(share.keyShare, coefficients.data(), k, x, prime);
+        ok = hybrid_write_header(*outputs[i], share) && ok;
+    }
+    hybrid_share_clear(share);
+
+    for (int j = 0; j < k; j++) {
+        mpz_clear(coefficients[j]);
+    }
+    mpz_clears(prime, secret, x, NULL);
+
+    // Morceau chiffré suivi de son étiquette, complété par des zéros : ses k blocs sont les fragments systématiques
+    size_t maxBlock = (chunkSize + HYBRID_TAG_BYTES + k - 1) / k;
+    std::vector<unsigned char> plain(chunkSize), sealed((size_t) k * maxBlock), parity((size_t) (n - k) * maxBlock);
+    std::vector<unsigned char *> fragments(n);
+    std::vector<const unsigned char *> blocks(k);
+
+    EVP_CIPHER_CTX * ctx = hybrid_cipher_ctx(cipher, true);
+    ok = ok && ctx != NULL;
+
+    bool last = false;
+    for (unsigned long long chunk = 0; ok && !last; chunk++)
+    {
+        input.read((char *) plain.data(), chunkSize);
+        size_t length = input.gcount();
+        ok = !input.bad();
+        last = length < chunkSize || input.peek() == std::char_traits<char>::eof();
+
+        size_t block = (length + HYBRID_TAG_BYTES + k - 1) / k;
+        std::fill(sealed.begin(), sealed.begin() + (size_t) k * block, 0);
+        ok = ok && hybrid_crypt(ctx, sealed.data(), plain.data(), length, key, iv, chunk, last, sealed.data() + length, true);
+
+        for (int j = 0; j < k; j++) {
+            blocks[j] = fragments[j] = sealed.data() + (size_t) j * block;
+        }
+        for (int r = k; r < n; r++) {
+            fragments[r] = parity.data() + (size_t) (r - k) * block;
+        }
+        if (ok) {
+            ida_encode_blocks(fragments.data(), blocks.data(), block, k, n);
+        }
+
+        for (int i = 0; ok && i < n; i++)
+        {
+            write_uint(*outputs[i], length, 4);
+            write_uint(*outputs[i], last ? HYBRID_LAST_CHUNK : 0, 1);
+            outputs[i]->write((const char *) fragments[i], block);
+            ok = outputs[i]->good();
+        }
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+    OPENSSL_cleanse(plain.data(), plain.size());
+    OPENSSL_cleanse(key, HYBRID_KEY_BYTES);
+    return ok;
+}
+
+// Fonction qui reconstruit la clé à partir des k premières parts puis déchiffre morceau par morceau
+bool hybrid_combine(std::vector<std::istream *> & inputs, std::ostream & output, unsigned long long & failedChunk)
+{
+    failedChunk = 0;
+
+    // En-têtes : la première part donne k, les k - 1 suivantes doivent avoir les mêmes paramètres publics
+    std::vector<hybrid_share> shares(inputs.size());
+    for (size_t i = 0; i < shares.size(); i++) {
+        hybrid_share_init(shares[i]);
+    }
+    bool ok = !inputs.empty() && hybrid_read_header(shares[0], *inputs[0]);
+    int k = ok ? shares[0].k : 0;
+    ok = ok && (int) inputs.size() >= k;
+    for (int i = 1; ok && i < k; i++)
+    {
+        ok = hybrid_read_header(shares[i], *inputs[i]) && shares[i].cipher == shares[0].cipher && shares[i].k == k && shares[i].n == shares[0].n
+            && shares[i].chunkSize == shares[0].chunkSize && std::equal(shares[i].iv, shares[i].iv + HYBRID_IV_BYTES, shares[0].iv);
+        for (int j = 0; ok && j < i; j++) {
+            ok = shares[j].index != shares[i].index;
+        }
+    }
+
+    if (!ok)
+    {
+        for (size_t i = 0; i < shares.size(); i++) {
+            hybrid_share_clear(shares[i]);
+        }
+        return false;
+    }
+
+    // Reconstruction de la clé
+    std::vector<mpz_t> x(k), y(k), alphas(k);
+    std::vector<int> indices(k);
+    for (int i = 0; i < k; i++)
+    {
+        indices[i] = shares[i].index;
+        mpz_init_set_ui(x[i], shares[i].index + 1);
+        mpz_init_set(y[i], shares[i].keyShare);
+    }
+
+    mpz_t prime, secret;
+    mpz_inits(prime, secret, NULL);
+    generate_field_prime(prime, HYBRID_KEY_BYTES);
+    compute_lagrange_coefficients(alphas, x.data(), k, prime);
+    reconstruct_secret(secret, alphas, y.data(), k, prime);
+
+    unsigned char key[HYBRID_KEY_BYTES] = { 0 };
+    size_t count = (mpz_sizeinbase(secret, 2) + 7) / 8;
+    ok = count <= HYBRID_KEY_BYTES;
+    if (ok && mpz_sgn(secret) != 0) {
+        mpz_export(key + HYBRID_KEY_BYTES - count, NULL, 1, 1, 1, 0, secret);
+    }
+
+    for (int i = 0; i < k; i++) {
+        mpz_clear(x[i]);
+        mpz_clear(y[i]);
+        mpz_clear(alphas[i]);
+    }
+    mpz_clears(prime, secret, NULL);
+
+    // Reconstruction puis déchiffrement authentifié de chaque morceau, écrit dès qu'il est authentifié
+    size_t chunkSize = shares[0].chunkSize;
+    size_t maxBlock = (chunkSize + HYBRID_TAG_BYTES + k - 1) / k;
+    std::vector<unsigned char> plain(chunkSize), sealed((size_t) k * maxBlock), received((size_t) k * maxBlock);
+    std::vector<unsigned char *> blocks(k);
+    std::vector<const unsigned char *> fragments(k);
+
+    EVP_CIPHER_CTX * ctx = hybrid_cipher_ctx(shares[0].cipher, false);
+    ok = ok && ctx != NULL;
+
+    bool last = false;
+    for (unsigned long long chunk = 0; ok && !last; chunk++)
+    {
+        failedChunk = chunk;
+
+        // Taille et drapeau de fin, identiques dans les k parts
+        size_t length = 0;
+        int flags = 0;
+        for (int i = 0; ok && i < k; i++)
+        {
+            size_t partLength = read_uint(*inputs[i], 4);
+            int partFlags = read_uint(*inputs[i], 1);
+            ok = inputs[i]->good() && (i == 0 || (partLength == length && partFlags == flags));
+            length = partLength;
+            flags = partFlags;
+        }
+        ok = ok && length <= chunkSize && (flags & ~HYBRID_LAST_CHUNK) == 0;
+        last = (flags & HYBRID_LAST_CHUNK) != 0;
+
+        size_t block = (length + HYBRID_TAG_BYTES + k - 1) / k;
+        for (int i = 0; ok && i < k; i++)
+        {
+            fragments[i] = received.data() + (size_t) i * block;
+            blocks[i] = sealed.data() + (size_t) i * block;
+            inputs[i]->read((char *) received.data() + (size_t) i * block, block);
+            ok = (size_t) inputs[i]->gcount() == block;
+        }
+
+        ok = ok && ida_decode_blocks(blocks.data(), fragments.data(), indices.data(), block, k, shares[0].n)
+            && hybrid_crypt(ctx, plain.data(), sealed.data(), length, key, shares[0].iv, chunk, last, sealed.data() + length, false);
+        if (ok)
+        {
+            output.write((const char *) plain.data(), length);
+            ok = output.good();
+        }
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+    OPENSSL_cleanse(plain.data(), plain.size());
+    OPENSSL_cleanse(key, HYBRID_KEY_BYTES);
+    for (size_t i = 0; i < shares.size(); i++) {
+        hybrid_share_clear(shares[i]);
+    }
+    return ok && last;
+}
+
+// Fonction qui écrit l'en-tête d'une part : paramètres publics puis part de la clé
+bool hybrid_write_header(std::ostream & out, const hybrid_share & share)
+{
+    unsigned char keyShare[HYBRID_KEY_BYTES + 1] = { 0 };
+    size_t count = (mpz_sizeinbase(share.keyShare, 2) + 7) / 8;
+    if (mpz_sgn(share.keyShare) != 0) {
+        mpz_export(keyShare + sizeof(keyShare) - count, NULL, 1, 1, 1, 0, share.keyShare);
+    }
+
+    out.write(HYBRID_MAGIC, 4);
+    write_uint(out, HYBRID_VERSION, 1);
+    write_uint(out, share.cipher, 1);
+    write_uint(out, share.k, 1);
+    write_uint(out, share.n, 1);
+    write_uint(out, share.index, 1);
+    write_uint(out, share.chunkSize, 4);
+    out.write((const char *) share.iv, HYBRID_IV_BYTES);
+    out.write((const char *) keyShare, sizeof(keyShare));
+
+    return out.good();
+}
+
+bool hybrid_read_header(hybrid_share & share, std::istream & in)
+{
+    char magic[4];
+    in.read(magic, 4);
+    if (!in || std::string(magic, 4) != HYBRID_MAGIC || read_uint(in, 1) != HYBRID_VERSION) {
+        return false;
+    }
+
+    share.cipher = read_uint(in, 1);
+    share.k = read_uint(in, 1);
+    share.n = read_uint(in, 1);
+    share.index = read_uint(in, 1);
+    share.chunkSize = read_uint(in, 4);
+    in.read((char *) share.iv, HYBRID_IV_BYTES);
+
+    unsigned char keyShare[HYBRID_KEY_BYTES + 1];
+    in.read((char *) keyShare, sizeof(keyShare));
+    mpz_import(share.keyShare, sizeof(keyShare), 1, 1, 1, 0, keyShare);
+
+    return in.good() && hybrid_evp_cipher(share.cipher) != NULL && share.k >= 1 && share.k <= share.n && share.index < share.n
+        && share.chunkSize != 0 && share.chunkSize <= HYBRID_MAX_CHUNK;
+}
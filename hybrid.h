@@ -0,0 +1,46 @@
+#ifndef HYBRID_H
+#define HYBRID_H
+
+#include <gmp.h>
+#include <iostream>
+#include <vector>
+
+#define HYBRID_AES_256_GCM 1
+#define HYBRID_CHACHA20_POLY1305 2
+
+#define HYBRID_KEY_BYTES 32
+#define HYBRID_IV_BYTES 12
+#define HYBRID_TAG_BYTES 16
+
+#define HYBRID_DEFAULT_CHUNK (1 << 20) // Taille par défaut d'un morceau de l'entrée
+#define HYBRID_MAX_CHUNK (1 << 30)     // EVP_*Update prend une taille de type int
+
+// En-tête d'une part du mode hybride : paramètres publics communs et part de la clé, suivis des enregistrements des morceaux
+struct hybrid_share
+{
+    int cipher;                                 // Algorithme de chiffrement authentifié
+    int k;                                      // Seuil
+    int n;                                      // Nombre de parts
+    int index;                                  // Indice de la part dans [0; n[, son abscisse est index + 1
+    unsigned int chunkSize;                     // Taille maximale d'un morceau en clair
+    unsigned char iv[HYBRID_IV_BYTES];          // Nonce de base, combiné à l'indice de chaque morceau
+    mpz_t keyShare;                             // Part de la clé
+};
+
+void hybrid_share_init(hybrid_share & share);
+void hybrid_share_clear(hybrid_share & share);
+
+// Fonction qui chiffre l'entrée morceau par morceau, disperse chaque morceau chiffré en n = outputs.size() fragments et
+// partage la clé avec un seuil k : outputs[i] reçoit la part d'indice i, écrite au fil des morceaux
+bool hybrid_split(std::istream & input, std::vector<std::ostream *> & outputs, int k, size_t chunkSize, int cipher, gmp_randstate_t gmpRandState);
+
+// Fonction qui reconstruit la clé à partir des k premières parts puis déchiffre morceau par morceau
+// Renvoie false si un en-tête est invalide ou si un morceau ne s'authentifie pas ; failedChunk reçoit alors son indice
+// (les morceaux précédents, authentifiés, ont déjà été écrits)
+bool hybrid_combine(std::vector<std::istream *> & inputs, std::ostream & output, unsigned long long & failedChunk);
+
+// Fonctions d'écriture et de lecture de l'en-tête d'une part
+bool hybrid_write_header(std::ostream & out, const hybrid_share & share);
+bool hybrid_read_header(hybrid_share & share, std::istream & in);
+
+#endif
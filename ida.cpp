@@ -0,0 +1,189 @@
+#include "ida.h"
+#include "gf256.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+/*
+ * Dispersion d'information (code de Reed-Solomon systématique) sur GF(2^8).
+ * Les données sont découpées en k blocs de B = ceil(length / k) octets (le dernier complété par des zéros).
+ * La matrice de codage n x k est l'identité suivie d'une matrice de Cauchy C[r][j] = 1 / (r + j) pour r dans [k; n[ :
+ * les k premiers fragments sont les blocs eux-mêmes et toute sous-matrice carrée est inversible, donc k fragments
+ * quelconques redonnent les blocs. Chaque fragment fait 1 / k de la taille des données.
+ *
+ * Au décodage, seuls les blocs manquants sont recalculés, avec l'inverse de la sous-matrice des fragments reçus ;
+ * ces inverses sont gardés en cache par motif d'effacement (k, n, indices reçus).
+ */
+
+#define IDA_TILE 8192 // Taille des tuiles traitées ensemble pour rester dans le cache L1/L2
+
+// Fonction qui donne le coefficient de la ligne r >= k de la matrice de Cauchy
+static unsigned char ida_cauchy(int r, int j)
+{
+    return gf256_inv(r ^ j);
+}
+
+// Fonction qui code k blocs de blockSize octets en n fragments : les k premiers sont les blocs eux-mêmes
+// fragments[0 .. k-1] peuvent pointer sur les blocs (aucune copie n'est alors faite)
+void ida_encode_blocks(unsigned char ** fragments, const unsigned char * const * blocks, size_t blockSize, int k, int n)
+{
+    for (int j = 0; j < k; j++)
+    {
+        if (fragments[j] != blocks[j]) {
+            memcpy(fragments[j], blocks[j], blockSize);
+        }
+    }
+
+    for (size_t offset = 0; offset < blockSize; offset += IDA_TILE)
+    {
+        size_t size = std::min((size_t) IDA_TILE, blockSize - offset);
+
+        for (int r = k; r < n; r++)
+        {
+            gf256_region_mul(fragments[r] + offset, blocks[0] + offset, ida_cauchy(r, 0), size);
+            for (int j = 1; j < k; j++) {
+                gf256_region_muladd(fragments[r] + offset, blocks[j] + offset, ida_cauchy(r, j), size);
+            }
+        }
+    }
+}
+
+// Fonction qui donne l'inverse de la sous-matrice des lignes reçues, calculé une fois par motif d'effacement
+static bool ida_inverse(std::vector<unsigned char> & inverse, const std::vector<int> & rows, int k, int n)
+{
+    static std::mutex cacheMutex;
+    static std::map<std::vector<int>, std::vector<unsigned char> > cache;
+
+    std::vector<int> key(rows);
+    key.push_back(k);
+    key.push_back(n);
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        std::map<std::vector<int>, std::vector<unsigned char> >::iterator it = cache.find(key);
+        if (it != cache.end()) {
+            inverse = it->second;
+            return true;
+        }
+    }
+
+    std::vector<unsigned char> matrix(k * k, 0);
+    for (int i = 0; i < k; i++)
+    {
+        for (int j = 0; j < k; j++) {
+            matrix[i * k + j] = rows[i] < k ? (rows[i] == j) : ida_cauchy(rows[i], j);
+        }
+    }
+    if (!gf256_invert_matrix(matrix, inverse, k)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache[key] = inverse;
+    return true;
+}
+
+// Fonction qui retrouve les k blocs à partir de k fragments et de leurs indices (dans [0; n[)
+bool ida_decode_blocks(unsigned char ** blocks, const unsigned char * const * fragments, const int * indices, size_t blockSize, int k, int n)
+{
+    // Fragments triés par indice : le motif d'effacement ne dépend pas de l'ordre de réception
+    std::vector<int> order(k);
+    for (int i = 0; i < k; i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [indices](int a, int b) { return indices[a] < indices[b]; });
+
+    std::vector<int> rows(k);
+    std::vector<const unsigned char *> sorted(k);
+    for (int i = 0; i < k; i++)
+    {
+        rows[i] = indices[order[i]];
+        sorted[i] = fragments[order[i]];
+        if (rows[i] < 0 || rows[i] >= n || (i > 0 && rows[i] == rows[i - 1])) {
+            return false;
+        }
+    }
+
+    std::vector<unsigned char> inverse;
+    if (!ida_inverse(inverse, rows, k, n)) {
+        return false;
+    }
+
+    // Les blocs reçus tels quels sont copiés, les autres recalculés
+    std::vector<int> missing;
+    for (int j = 0; j < k; j++)
+    {
+        const int * found = std::find(rows.data(), rows.data() + k, j);
+        if (found != rows.data() + k) {
+            if (blocks[j] != sorted[found - rows.data()]) {
+                memcpy(blocks[j], sorted[found - rows.data()], blockSize);
+            }
+        } else {
+            missing.push_back(j);
+        }
+    }
+
+    for (size_t offset = 0; offset < blockSize; offset += IDA_TILE)
+    {
+        size_t size = std::min((size_t) IDA_TILE, blockSize - offset);
+
+        for (size_t m = 0; m < missing.size(); m++)
+        {
+            int j = missing[m];
+            gf256_region_mul(blocks[j] + offset, sorted[0] + offset, inverse[j * k], size);
+            for (int i = 1; i < k; i++) {
+                gf256_region_muladd(blocks[j] + offset, sorted[i] + offset, inverse[j * k + i], size);
+            }
+        }
+    }
+    return true;
+}
+
+// Fonction qui disperse length octets en n fragments de ceil(length / k) octets, k fragments quelconques suffisant à les retrouver
+void ida_split(std::vector<std::vector<unsigned char> > & fragments, const unsigned char * data, size_t length, int k, int n)
+{
+    size_t block = (length + k - 1) / k;
+
+    fragments.resize(n);
+    std::vector<unsigned char *> outputs(n);
+    for (int i = 0; i < n; i++) {
+        fragments[i].assign(block, 0);
+        outputs[i] = fragments[i].data();
+    }
+
+    // Les fragments systématiques reçoivent directement les blocs, le dernier complété par des zéros
+    for (int j = 0; j < k && (size_t) j * block < length; j++) {
+        memcpy(outputs[j], data + j * block, std::min(block, length - j * block));
+    }
+
+    ida_encode_blocks(outputs.data(), outputs.data(), block, k, n);
+}
+
+// Fonction qui retrouve les length octets à partir de k fragments et de leurs indices (dans [0; n[)
+bool ida_combine(std::vector<unsigned char> & data, size_t length, std::vector<std::vector<unsigned char> > & fragments, int * indices, int k, int n)
+{
+    size_t block = (length + k - 1) / k;
+
+    std::vector<const unsigned char *> inputs(k);
+    for (int i = 0; i < k; i++)
+    {
+        if (fragments[i].size() != block) {
+            return false;
+        }
+        inputs[i] = fragments[i].data();
+    }
+
+    data.assign(block * k, 0);
+    std::vector<unsigned char *> outputs(k);
+    for (int j = 0; j < k; j++) {
+        outputs[j] = data.data() + j * block;
+    }
+
+    if (!ida_decode_blocks(outputs.data(), inputs.data(), indices, block, k, n)) {
+        return false;
+    }
+    data.resize(length);
+    return true;
+}
@@ -0,0 +1,19 @@
+#ifndef IDA_H
+#define IDA_H
+
+#include <cstddef>
+#include <vector>
+
+// Fonction qui code k blocs de blockSize octets en n fragments : les k premiers sont les blocs eux-mêmes
+void ida_encode_blocks(unsigned char ** fragments, const unsigned char * const * blocks, size_t blockSize, int k, int n);
+
+// Fonction qui retrouve les k blocs à partir de k fragments et de leurs indices (dans [0; n[)
+bool ida_decode_blocks(unsigned char ** blocks, const unsigned char * const * fragments, const int * indices, size_t blockSize, int k, int n);
+
+// Fonction qui disperse length octets en n fragments de ceil(length / k) octets, k fragments quelconques suffisant à les retrouver
+void ida_split(std::vector<std::vector<unsigned char> > & fragments, const unsigned char * data, size_t length, int k, int n);
+
+// Fonction qui retrouve les length octets à partir de k fragments et de leurs indices (dans [0; n[)
+bool ida_combine(std::vector<unsigned char> & data, size_t length, std::vector<std::vector<unsigned char> > & fragments, int * indices, int k, int n);
+
+#endif
@@ -0,0 +1,235 @@
+#include "journal.h"
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * Validation groupée (group commit) : un fdatasync coûte de l'ordre d'une milliseconde quel que soit le
+ * volume écrit, un fdatasync par écriture plafonne donc le débit à quelques centaines d'écritures par
+ * seconde. Ici les threads ajoutent leurs enregistrements à un lot en mémoire et ne font pas d'appel
+ * système ; le thread de validation prend le lot entier, l'écrit en une fois et le rend durable par un seul
+ * fdatasync, pendant que le lot suivant se remplit. Le coût d'une validation est partagé par tous les
+ * enregistrements du lot : le débit croît avec la taille des lots, la latence est bornée par le délai.
+ *
+ * Les lots sont écrits et validés dans l'ordre : un enregistrement durable implique que tous les
+ * précédents le sont. Après un échec d'écriture ou de fdatasync, l'état des pages du fichier n'est plus
+ * connu (le noyau peut les avoir marquées propres) : le journal refuse alors tout nouvel ajout.
+ */
+
+group_journal::group_journal()
+    : fd_(-1), interval_(JOURNAL_DEFAULT_INTERVAL), batchBytes_(JOURNAL_DEFAULT_BATCH), end_(0), durable_(0), commits_(0),
+      flushRequested_(false), stopping_(false), failed_(false)
+{
+}
+
+group_journal::~group_journal()
+{
+    close();
+}
+
+// Fonction qui ouvre (ou crée) le journal et démarre le thread de validation ; les ajouts suivent la fin du fichier
+bool group_journal::open(const std::string & path, unsigned int intervalMicros, size_t batchBytes)
+{
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd_ < 0) {
+        return false;
+    }
+    off_t size = lseek(fd_, 0, SEEK_END);
+    if (size < 0) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    interval_ = intervalMicros;
+    batchBytes_ = batchBytes == 0 ? 1 : batchBytes;
+    end_ = durable_ = size;
+    commits_ = 0;
+    flushRequested_ = stopping_ = failed_ = false;
+    committer_ = std::thread(&group_journal::run, this);
+    return true;
+}
+
+// Fonction qui ajoute un enregistrement et renvoie sa position dans offset ; listener (éventuellement nul) est
+// averti de sa durabilité
+bool group_journal::append(const unsigned char * data, size_t length, journal_listener * listener, unsigned long long * offset)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Contre-pression : le lot en cours ne grossit pas sans limite si le disque ne suit pas
+    committed_.wait(lock, [this] { return failed_ || stopping_ || buffer_.size() < JOURNAL_PENDING_BATCHES * batchBytes_; });
+    if (failed_ || stopping_ || fd_ < 0) {
+        return false;
+    }
+
+    if (buffer_.empty()) {
+        firstPending_ = std::chrono::steady_clock::now();
+    }
+    if (offset != NULL) {
+        *offset = end_;
+    }
+    if (listener != NULL) {
+        listeners_.push_back(std::make_pair(end_, listener));
+    }
+    buffer_.insert(buffer_.end(), data, data + length);
+    end_ += length;
+
+    // Le thread de validation n'est réveillé qu'au premier enregistrement du lot et quand le seuil est atteint
+    if (buffer_.size() == length || buffer_.size() >= batchBytes_) {
+        pending_.notify_one();
+    }
+    return true;
+}
+
+// Fonction qui attend que le journal soit durable jusqu'à target
+bool group_journal::wait_durable(std::unique_lock<std::mutex> & lock, unsigned long long target)
+{
+    committed_.wait(lock, [this, target] { return failed_ || durable_ >= target; });
+    return durable_ >= target;
+}
+
+// Fonction qui ajoute un enregistrement et attend qu'il soit durable
+bool group_journal::append_sync(const unsigned char * data, size_t length, unsigned long long * offset)
+{
+    unsigned long long position;
+    if (!append(data, length, NULL, &position)) {
+        return false;
+    }
+    if (offset != NULL) {
+        *offset = position;
+    }
+
+    return sync_to(position + length);
+}
+
+// Fonction qui attend que le journal soit durable jusqu'à la position end (fin d'un enregistrement ajouté)
+bool group_journal::sync_to(unsigned long long end)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return wait_durable(lock, end);
+}
+
+// Fonction qui valide sans attendre le délai et attend que tous les ajouts précédents soient durables
+bool group_journal::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (fd_ < 0) {
+        return false;
+    }
+    if (!buffer_.empty()) {
+        flushRequested_ = true;
+        pending_.notify_one();
+    }
+    return wait_durable(lock, end_);
+}
+
+// Fonction qui valide les ajouts en attente, arrête le thread de validation et ferme le fichier
+bool group_journal::close()
+{
+    if (fd_ < 0) {
+        return true;
+    }
+
+    bool ok = flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        pending_.notify_one();
+        committed_.notify_all();
+    }
+    committer_.join();
+
+    if (::close(fd_) != 0) {
+        ok = false;
+    }
+    fd_ = -1;
+    return ok;
+}
+
+unsigned long long group_journal::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return end_;
+}
+
+unsigned long long group_journal::durable_size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return durable_;
+}
+
+unsigned long long group_journal::commits() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return commits_;
+}
+
+// Fonction qui écrit entièrement un lot par pwrite
+static bool journal_write(int fd, const unsigned char * data, size_t length, unsigned long long offset)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t written = pwrite(fd, data + done, length - done, offset + done);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        done += written;
+    }
+    return true;
+}
+
+// Thread de validation : un lot à la fois, écrit puis rendu durable hors du verrou
+void group_journal::run()
+{
+    std::vector<unsigned char> batch;
+    std::vector<std::pair<unsigned long long, journal_listener *> > batchListeners;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        pending_.wait(lock, [this] { return stopping_ || !buffer_.empty(); });
+        if (stopping_ && buffer_.empty()) {
+            break;
+        }
+
+        // Le lot attend le délai compté depuis son premier enregistrement, sauf seuil atteint ou flush
+        std::chrono::steady_clock::time_point deadline = firstPending_ + std::chrono::microseconds(interval_);
+        pending_.wait_until(lock, deadline, [this] { return stopping_ || flushRequested_ || buffer_.size() >= batchBytes_; });
+
+        batch.swap(buffer_);
+        batchListeners.swap(listeners_);
+        unsigned long long offset = end_ - batch.size();
+        flushRequested_ = false;
+        bool ok = !failed_;
+
+        // Les ajouts reprennent dans un lot vide pendant l'écriture
+        committed_.notify_all();
+        lock.unlock();
+
+        ok = ok && journal_write(fd_, batch.data(), batch.size(), offset) && fdatasync(fd_) == 0;
+
+        lock.lock();
+        if (ok) {
+            durable_ = offset + batch.size();
+        } else {
+            failed_ = true;
+        }
+        commits_++;
+        committed_.notify_all();
+
+        // Les avis sont donnés hors du verrou : un listener peut ajouter au journal
+        lock.unlock();
+        for (size_t i = 0; i < batchListeners.size(); i++) {
+            batchListeners[i].second->durable(batchListeners[i].first, ok);
+        }
+        batch.clear();
+        batchListeners.clear();
+        lock.lock();
+    }
+}
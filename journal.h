@@ -0,0 +1,90 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define JOURNAL_DEFAULT_INTERVAL 1000   // Délai maximal (µs) entre le premier enregistrement en attente et sa validation
+#define JOURNAL_DEFAULT_BATCH (1 << 20) // Octets en attente qui déclenchent la validation sans attendre le délai
+#define JOURNAL_PENDING_BATCHES 4       // Lots en attente au-delà desquels append bloque (contre-pression)
+
+// Avis de durabilité d'un enregistrement du journal, appelé par le thread de validation
+struct journal_listener
+{
+    virtual ~journal_listener() {}
+
+    // L'enregistrement écrit à offset est durable (ok) ou ne le sera jamais (échec d'écriture ou de fdatasync)
+    virtual void durable(unsigned long long offset, bool ok) = 0;
+};
+
+// Journal en ajout seul à validation groupée : les enregistrements de tous les threads s'accumulent en mémoire
+// et un thread de validation les écrit puis les rend durables par un seul fdatasync par lot. Un lot part quand
+// son premier enregistrement a attendu le délai, quand il atteint la taille seuil, ou sur flush()
+class group_journal
+{
+public:
+    group_journal();
+    ~group_journal();
+
+    // Fonction qui ouvre (ou crée) le journal et démarre le thread de validation ; les ajouts suivent la fin du fichier
+    bool open(const std::string & path, unsigned int intervalMicros, size_t batchBytes);
+
+    // Fonction qui ajoute un enregistrement et renvoie sa position dans offset ; listener (éventuellement nul) est
+    // averti de sa durabilité. Les enregistrements deviennent durables dans l'ordre des ajouts
+    bool append(const unsigned char * data, size_t length, journal_listener * listener, unsigned long long * offset);
+
+    // Fonction qui ajoute un enregistrement et attend qu'il soit durable
+    bool append_sync(const unsigned char * data, size_t length, unsigned long long * offset);
+
+    // Fonction qui attend que le journal soit durable jusqu'à la position end (fin d'un enregistrement ajouté)
+    bool sync_to(unsigned long long end);
+
+    // Fonction qui valide sans attendre le délai et attend que tous les ajouts précédents soient durables
+    bool flush();
+
+    // Fonction qui valide les ajouts en attente, arrête le thread de validation et ferme le fichier
+    bool close();
+
+    // Taille du journal, enregistrements en attente compris, et taille de la partie durable
+    unsigned long long size() const;
+    unsigned long long durable_size() const;
+
+    // Nombre de validations (appels à fdatasync) depuis l'ouverture
+    unsigned long long commits() const;
+
+    // Descripteur du fichier, pour la lecture des enregistrements durables
+    int fd() const { return fd_; }
+
+private:
+    group_journal(const group_journal &);
+    group_journal & operator=(const group_journal &);
+
+    void run();
+    bool wait_durable(std::unique_lock<std::mutex> & lock, unsigned long long target);
+
+    int fd_;
+    unsigned int interval_;
+    size_t batchBytes_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable pending_;       // Réveille le thread de validation
+    std::condition_variable committed_;     // Réveille les threads qui attendent une validation
+    std::vector<unsigned char> buffer_;     // Lot en cours de remplissage
+    std::vector<std::pair<unsigned long long, journal_listener *> > listeners_;
+    std::chrono::steady_clock::time_point firstPending_;
+    unsigned long long end_;                // Fin du journal, lot en cours compris
+    unsigned long long durable_;            // Fin de la partie durable
+    unsigned long long commits_;
+    bool flushRequested_;
+    bool stopping_;
+    bool failed_;                           // Une écriture ou un fdatasync a échoué : plus rien n'est accepté
+    std::thread committer_;
+};
+
+#endif
@@ -1,114 +1,27 @@
 #include <iostream>
 #include <gmp.h>
+#include <string>
 #include <vector>
 
+#include "shamir.h"
+#include "vss.h"
+#include "enroll.h"
+#include "refresh.h"
+#include "reshare.h"
+#include "packed.h"
+#include "ramp.h"
+#include "commands.h"
+
 #define BITSTRENGTH 14
 #define DEBUG true
 
-// Fonction qui génère un nombre premier avec un nombre de bits donné
-void generate_prime(mpz_t num, int bit_strength, gmp_randstate_t gmpRandState) 
-{
-    // Génère un nombre aléatoire avec un nombre de bits donné en prenant un état aléatoire
-    mpz_urandomb(num, gmpRandState, bit_strength);
-
-    // On met le dernier bit à 1 pour qu'il soit impair car les nombres premiers supérieurs à 2 sont tous impairs
-    mpz_setbit(num, 0);
-
-    // On trouve le nombre premier le plus proche du nombre aléatoire généré
-    mpz_nextprime(num, num);
-}
-
-// Fonction qui génère un secret de façon aléatoire dans l'intervalle [0; prime] 
-void generate_secret(mpz_t secret, mpz_t prime, gmp_randstate_t gmpRandState) 
-{
-    mpz_urandomm(secret, gmpRandState, prime);
-}
-
-// Fonction qui génère les coefficients du polynome
-void generate_coefficients(std::vector<mpz_t> & coefficients, mpz_t prime, int & k, mpz_t secret, gmp_randstate_t gmpRandState) 
-{
-    // Génère les coefficients aléatoirement dans l'intervalle [0; prime] et les stocke dans le vecteur de coefficients
-    for (int i = 0; i < k - 1; i++) {
-        mpz_init(coefficients[i]);
-        mpz_urandomm(coefficients[i], gmpRandState, prime);
-    }
-
-    // On met le coefficient nulle égale au secret
-    mpz_set(coefficients[k - 1], secret);
-}
-
-// Fonction qui calcul les yi des points avec des xi et des coefficients donnés, k fois  
-void compute_shares(std::vector<mpz_t> & x, std::vector<mpz_t> & y, mpz_t * coefficients, int k) 
-{
-    mpz_t temp;
-
-    for (int i = 0; i < k; i++) // On parcourt le vecteur des xi, yi pour un seuil donné k
-    {
-        // Initialise yi à 0
-        mpz_init_set_ui(y[i], 0);
-
-        mpz_init(temp); // Utilisation d'un temp pour ne pas écraser les anciennes valeurs des yi
-
-        // Calcul des yi pour des xi et coefficients donnés
-        for (int j = 0; j < k; j++) 
-        {
-            mpz_pow_ui(temp, x[i], j);     // x^j
-            mpz_mul(temp, temp, coefficients[j]);  // coefficients[j] * x^j
-            mpz_add(y[i], y[i], temp);        // On met le résultat de coefficients[j] * x^j dans yi
-        }
-    }
-    mpz_clear(temp);
-}
-
-// Fonction qui calcul les coefficients de Lagrange
-void compute_lagrange_coefficients(std::vector<mpz_t> & alphas, mpz_t * x, int k, mpz_t prime) 
-{
-    // Calcul des coefficients de Lagrange pour l'interpolation
-    for (int i = 0; i < k; i++) 
-    {
-        mpz_init(alphas[i]);
-        mpz_init_set_ui(alphas[i], 1); // Car alphas[i](xi) = 1
-
-        for (int j = 0; j < k; j++) 
-        {
-            if (j != i) {
-                mpz_t temp;
-                mpz_init(temp);
-
-                // Calcul : (x[j] - x[i])^-1 modulo prime
-                mpz_sub(temp, x[j], x[i]); // x[j] - x[i]
-                mpz_invert(temp, temp, prime); // Calcul l'inverse multiplicatif de (x[j] - x[i]) puis on fait le modulo prime
-
-                // Met à jour le coefficient de Lagrange
-                mpz_mul(alphas[i], alphas[i], temp);
-                mpz_clear(temp);
-            }
-        }
-    }
-}
-
-// Fonction de recronstruction de secret avec k coefficients, k parts et p
-void reconstruct_secret(mpz_t reconstructedSecret, std::vector<mpz_t> & alphas, mpz_t * shares, int k, mpz_t p) 
+int main(int argc, char ** argv) 
 {
-    // Initialisation à 0
-    mpz_init_set_ui(reconstructedSecret, 0);
-
-    mpz_t temp;
-    mpz_init(temp);
-
-    // Reconstruct the secret using Lagrange interpolation
-    for (int i = 0; i < k; i++) {
-        mpz_mul(temp, alphas[i], shares[i]); // alpha[i] * y[i]
-        mpz_add(reconstructedSecret, reconstructedSecret, temp); // Mise à jour du résultat
+    // Avec des arguments, tp7 exécute une commande au lieu de la démonstration
+    if (argc > 1) {
+        return run_command(argc, argv);
     }
 
-    // On module par p pour obtenir le Secret
-    mpz_mod(reconstructedSecret, reconstructedSecret, p);
-    mpz_clear(temp);
-}
-
-int main() 
-{
     int n = 4;  // Numbers of users (max)
     int k = 3;  // Threshold: minimal number of users => secret
 
@@ -167,7 +80,6 @@ int main()
      */
 
     generate_coefficients(a, p, k, S, gmpRandState);
-    mpz_init_set(a[k - 1], S);
 
     if (DEBUG) 
     {
@@ -219,6 +131,294 @@ int main()
         std::cout << "Reconstruction of the secret : S = " << Sr_str << std::endl;
     }
 
+    /*
+     * Step 6: Verifiable shares: the polynomial now lives in Z/nZ where n is the prime order
+     * of the curve group P-256, and each user checks its share against the commitments
+     */
+
+    ec_group curve;
+    ec_group_init_p256(curve);
+
+    std::vector<mpz_t> b(k);          // Coefficients of polynomial in Z/nZ
+    std::vector<mpz_t> z(n);          // Shares of users in Z/nZ
+    std::vector<ec_point> C;          // Commitments of the coefficients
+
+    generate_coefficients(b, curve.n, k, S, gmpRandState);
+    compute_shares(x, z, b.data(), k);
+    for (int i = 0; i < k; i++) {
+        mpz_mod(z[i], z[i], curve.n);
+    }
+
+    vss_commit(C, b.data(), k, curve);
+
+    if (DEBUG) 
+    {
+        std::vector<unsigned char> C_bytes;
+        vss_encode_commitments(C_bytes, C, k, curve);
+        std::cout << "Commitments of the polynomial : " << C_bytes.size() << " bytes" << std::endl;
+
+        for (int i = 0; i < k; i++) {
+            std::cout << "Share of user " << i + 1 << " : " << (vss_verify_share(x[i], z[i], C, k, curve) ? "valid" : "invalid") << std::endl;
+        }
+
+        // Une part altérée doit être rejetée
+        mpz_add_ui(z[0], z[0], 1);
+        std::cout << "Altered share of user 1 : " << (vss_verify_share(x[0], z[0], C, k, curve) ? "valid" : "invalid") << std::endl;
+    }
+
+    /*
+     * Step 7: Enrollment of the last user by users 1, 2 and 3 without reconstructing the secret
+     */
+
+    std::vector<unsigned char> pairSeeds(k * k * REFRESH_SEED_BYTES, 0);  // Seed agreed by users i and j: pairSeeds[(i * k + j) * REFRESH_SEED_BYTES]
+    std::vector<const unsigned char *> pairPointers(k * k);
+    std::vector<mpz_t> partials(k);                                      // Masked contributions of users 1, 2 and 3
+    bool enrolled = true;
+
+    for (int i = 0; i < k * k; i++) {
+        pairPointers[i] = pairSeeds.data() + i * REFRESH_SEED_BYTES;
+    }
+    for (int i = 0; i < k; i++) 
+    {
+        for (int j = i + 1; j < k; j++) {
+            enrolled = refresh_generate_seed(pairSeeds.data() + (i * k + j) * REFRESH_SEED_BYTES) && enrolled;
+            pairPointers[j * k + i] = pairPointers[i * k + j];
+        }
+    }
+
+    // Les alphas de l'étape 5 servent de cache de poids pour les xi des détenteurs
+    for (int i = 0; i < k; i++) {
+        mpz_init(partials[i]);
+        enrolled = enroll_partial(partials[i], alphas, x.data(), k, i, y[i], x[n - 1], pairPointers.data() + i * k, p) && enrolled;
+    }
+
+    mpz_init(y[n - 1]);
+    enroll_combine(y[n - 1], partials.data(), k, p);
+
+    if (DEBUG) 
+    {
+        mpz_t expected;
+        mpz_init(expected);
+        evaluate_polynomial(expected, a.data(), k, x[n - 1], p);
+
+        char y_str[1000]; mpz_get_str(y_str, 10, y[n - 1]);
+        char e_str[1000]; mpz_get_str(e_str, 10, expected);
+        std::cout << "Enrollment of user " << n << " : y" << n << " = " << y_str << " (P(x" << n << ") mod p = " << e_str << ")"
+                  << (enrolled ? "" : " (enrollment failed)") << std::endl;
+
+        mpz_clear(expected);
+    }
+
+    /*
+     * Step 8: Proactive refresh of the shares of the 4 users, each user being also a contributor:
+     * the shares change but still reconstruct the secret
+     */
+
+    std::vector<field_batch> shareBatches(n);             // Share of each user, as a batch of one secret
+    std::vector<std::vector<field_batch> > received(n);   // Values received by each user, one per contributor
+    std::vector<unsigned char> refreshSeeds((k - 1) * REFRESH_SEED_BYTES);  // Seeds of a contributor with users 1 ... k-1
+    std::vector<const unsigned char *> seedPointers(k - 1);
+    bool refreshed = true;
+
+    for (int i = 0; i < n; i++) {
+        mpz_mod(y[i], y[i], p);
+        field_batch_init(shareBatches[i], 1, p);
+        field_batch_set(shareBatches[i], 0, y[i]);
+    }
+
+    for (int c = 0; c < n && refreshed; c++)
+    {
+        for (int i = 0; i < k - 1; i++) {
+            seedPointers[i] = refreshSeeds.data() + i * REFRESH_SEED_BYTES;
+            refreshed = refreshed && refresh_generate_seed(refreshSeeds.data() + i * REFRESH_SEED_BYTES);
+        }
+
+        // Les k-1 premiers utilisateurs dérivent leur valeur de leur graine, les autres la reçoivent du contributeur
+        std::vector<field_batch> evaluations;
+        refreshed = refreshed && refresh_evaluations(evaluations, seedPointers.data(), x.data(), n, k, 1, p);
+        for (int i = 0; i < n && refreshed; i++)
+        {
+            field_batch delta;
+            if (i < k - 1) {
+                refreshed = refresh_derive_deltas(delta, seedPointers[i], 1, p);
+            } else {
+                delta = evaluations[i - (k - 1)];
+            }
+            received[i].push_back(delta);
+        }
+    }
+
+    for (int i = 0; i < n && refreshed; i++) {
+        refresh_shares(shareBatches[i], received[i], p);
+        field_batch_get(y[i], shareBatches[i], 0);
+    }
+
+    if (DEBUG) 
+    {
+        std::cout << "Refreshed shares :";
+        for (int i = 0; i < n; i++) {
+            char y_str[1000]; mpz_get_str(y_str, 10, y[i]);
+            std::cout << " ( x" << i + 1 << " ; y" << i + 1 << "=" << y_str << " )";
+        }
+        std::cout << std::endl;
+
+        mpz_clear(Sr);
+        reconstruct_secret(Sr, alphas, y.data(), k, p);
+        char Sr_str[1000]; mpz_get_str(Sr_str, 10, Sr);
+        std::cout << "Reconstruction after refresh : S = " << Sr_str << (refreshed ? "" : " (refresh failed)") << std::endl;
+
+        // Les utilisateurs 2, 3 et 4 ont reçu des valeurs explicites de chaque contributeur et reconstruisent aussi le secret
+        std::vector<mpz_t> betas(k);
+        compute_lagrange_coefficients(betas, x.data() + 1, k, p);
+        mpz_clear(Sr);
+        reconstruct_secret(Sr, betas, y.data() + 1, k, p);
+        mpz_get_str(Sr_str, 10, Sr);
+        std::cout << "Reconstruction after refresh with users 2, 3 and 4 : S = " << Sr_str << std::endl;
+        for (int i = 0; i < k; i++) {
+            mpz_clear(betas[i]);
+        }
+    }
+
+    /*
+     * Step 9: Resharing by users 1, 2 and 3 from the policy (3, 4) to a policy (4, 6) without reconstructing the secret
+     */
+
+    int kNew = 4;
+    int nNew = 6;
+    std::vector<mpz_t> xNew(nNew);            // Logins of the new users
+    std::vector<mpz_t> yNew(nNew);            // Shares of the new users
+    std::vector<field_batch> subshares(k);    // Sub-shares sent by users 1, 2 and 3
+    field_batch vandermonde;
+    bool reshared = true;
+
+    for (int i = 0; i < nNew; i++) {
+        mpz_init_set_ui(xNew[i], (i + 1) * 3);
+        mpz_init(yNew[i]);
+    }
+    field_batch_vandermonde(vandermonde, xNew.data(), nNew, kNew, p);
+
+    // Les parts rafraîchies de l'étape 8 sont déjà des lots d'un secret
+    for (int i = 0; i < k && reshared; i++) {
+        reshared = reshare_subshares(subshares[i], shareBatches[i], vandermonde, kNew, nNew, p);
+    }
+    for (int r = 0; r < nNew && reshared; r++)
+    {
+        field_batch newShare;
+        reshare_combine(newShare, subshares, k, nNew, r, alphas, p);
+        field_batch_get(yNew[r], newShare, 0);
+    }
+
+    if (DEBUG) 
+    {
+        std::cout << "Reshared shares :";
+        for (int i = 0; i < nNew; i++) {
+            char x_str[1000]; mpz_get_str(x_str, 10, xNew[i]);
+            char y_str[1000]; mpz_get_str(y_str, 10, yNew[i]);
+            std::cout << " ( x" << i + 1 << "'=" << x_str << " ; y" << i + 1 << "'=" << y_str << " )";
+        }
+        std::cout << std::endl;
+
+        // Il faut maintenant 4 nouveaux utilisateurs : les 4 premiers, puis les 4 derniers
+        for (int first = 0; first + kNew <= nNew; first += nNew - kNew)
+        {
+            std::vector<mpz_t> betas(kNew);
+            compute_lagrange_coefficients(betas, xNew.data() + first, kNew, p);
+            mpz_clear(Sr);
+            reconstruct_secret(Sr, betas, yNew.data() + first, kNew, p);
+            char Sr_str[1000]; mpz_get_str(Sr_str, 10, Sr);
+            std::cout << "Reconstruction after resharing with new users " << first + 1 << " to " << first + kNew << " : S = " << Sr_str
+                      << (reshared ? "" : " (resharing failed)") << std::endl;
+            for (int i = 0; i < kNew; i++) {
+                mpz_clear(betas[i]);
+            }
+        }
+    }
+
+    for (int i = 0; i < nNew; i++) {
+        mpz_clear(xNew[i]);
+        mpz_clear(yNew[i]);
+    }
+
+    /*
+     * Step 10: Packed sharing of 3 secrets with a single polynomial: each of the 4 users keeps one share for the
+     * 3 secrets, one share reveals nothing and the 4 shares give back the 3 secrets
+     */
+
+    int l = 3;  // Secrets per polynomial
+    int t = 1;  // Shares that reveal nothing
+    mpz_t packedValue;
+    field_batch packedSecrets, packedShareMatrix, packedMatrix, packedRecovered;
+    std::vector<field_batch> packedShares;
+
+    mpz_init(packedValue);
+    field_batch_init(packedSecrets, l, p);
+    field_batch_set(packedSecrets, 0, S);
+    for (int j = 1; j < l; j++) {
+        generate_secret(packedValue, p, gmpRandState);
+        field_batch_set(packedSecrets, j, packedValue);
+    }
+
+    packed_share_matrix(packedShareMatrix, x.data(), n, l, t, p);
+    bool packed = packed_split(packedShares, packedSecrets, packedShareMatrix, n, l, t, p);
+
+    packed_reconstruct_matrix(packedMatrix, x.data(), l, t, p);
+    if (packed) {
+        packed_reconstruct(packedRecovered, packedShares, packedMatrix, l, t, p);
+    }
+
+    if (DEBUG && !packed) {
+        std::cout << "Packed sharing failed" << std::endl;
+    } else if (DEBUG) 
+    {
+        std::cout << "Packed secrets :";
+        for (int j = 0; j < l; j++) {
+            field_batch_get(packedValue, packedSecrets, j);
+            char v_str[1000]; mpz_get_str(v_str, 10, packedValue);
+            std::cout << " " << v_str;
+        }
+        std::cout << " ; shares :";
+        for (int i = 0; i < n; i++) {
+            field_batch_get(packedValue, packedShares[i], 0);
+            char y_str[1000]; mpz_get_str(y_str, 10, packedValue);
+            std::cout << " ( x" << i + 1 << " ; " << y_str << " )";
+        }
+        std::cout << std::endl;
+
+        std::cout << "Reconstruction of the packed secrets with " << packed_threshold(l, t) << " users :";
+        for (int j = 0; j < l; j++) {
+            field_batch_get(packedValue, packedRecovered, j);
+            char v_str[1000]; mpz_get_str(v_str, 10, packedValue);
+            std::cout << " " << v_str;
+        }
+        std::cout << std::endl;
+    }
+
+    mpz_clear(packedValue);
+
+    /*
+     * Step 11: Ramp sharing of a message with t = 1 and k = 3: one share reveals nothing, 3 shares give back the
+     * message and each share is half the size of the message (bytes are elements of Z/pZ since p > 2^8)
+     */
+
+    const std::string message = "Shamir secret sharing";
+    std::vector<unsigned char> blob(message.begin(), message.end());
+    std::vector<unsigned char> recovered;
+    std::vector<field_batch> rampShares;
+    field_batch rampMatrix;
+    int rampT = 1;
+
+    bool ramped = ramp_split(rampShares, blob, x.data(), n, k, rampT, 1, p)
+        && ramp_reconstruct_matrix(rampMatrix, x.data(), k, rampT, p)
+        && ramp_reconstruct(recovered, blob.size(), rampShares, rampMatrix, k, rampT, 1, p);
+
+    if (DEBUG) 
+    {
+        std::cout << "Ramp sharing of \"" << message << "\" (" << blob.size() << " bytes) : "
+                  << ramp_share_elements(blob.size(), k, rampT, 1) << " elements per share" << std::endl;
+        std::cout << "Reconstruction of the message with users 1, 2 and 3 : "
+                  << (ramped ? "\"" + std::string(recovered.begin(), recovered.end()) + "\"" : "failed") << std::endl;
+    }
+
     // Clean up the GMP integers
     mpz_clear(S);
     mpz_clear(p);
@@ -232,8 +432,14 @@ int main()
     for (int i = 0; i < k; i++) {
         mpz_clear(a[i]);
         mpz_clear(alphas[i]);
+        mpz_clear(partials[i]);
+        mpz_clear(b[i]);
+        mpz_clear(z[i]);
+        ec_point_clear(C[i]);
     }
 
+    ec_group_clear(curve);
+
     gmp_randclear(gmpRandState);
 
     return 0;
@@ -0,0 +1,131 @@
+#include "packed.h"
+#include "shamir.h"
+#include "enroll.h"
+#include "refresh.h"
+
+#include <algorithm>
+
+#include <openssl/crypto.h>
+
+/*
+ * Partage empaqueté (Franklin-Yung) : l secrets sont les valeurs d'un même polynome en l points réservés
+ * e_j = -(j + 1), et t valeurs aléatoires en t autres points réservés -(l + u + 1) garantissent que t parts
+ * ne révèlent rien. Le polynome est de degré l + t - 1 : il faut l + t parts pour reconstruire les l secrets,
+ * mais chaque participant ne stocke qu'une part pour l secrets.
+ *
+ * Les parts sont des combinaisons linéaires fixes des valeurs réservées (matrice de Lagrange calculée une fois),
+ * un lot de groups paquets se partage donc avec un seul produit matriciel.
+ * Les xi des participants doivent être distincts des points réservés (petits entiers positifs par exemple).
+ */
+
+// Fonction qui donne le nombre de parts nécessaires pour reconstruire l secrets empaquetés avec un seuil de confidentialité t
+int packed_threshold(int l, int t)
+{
+    return l + t;
+}
+
+// Fonction qui calcule les points réservés : les l points des secrets puis les t points aléatoires
+static void packed_points(std::vector<mpz_t> & points, int l, int t, mpz_t prime)
+{
+    for (int j = 0; j < l + t; j++)
+    {
+        mpz_init(points[j]);
+        mpz_sub_ui(points[j], prime, j + 1);    // -(j + 1) modulo prime
+    }
+}
+
+// Fonction qui calcule la matrice (rows x m) des poids de Lagrange : matrix[a][b] = L_b(at[a]) pour la base des points from
+static void packed_lagrange_matrix(field_batch & matrix, mpz_t * from, int m, mpz_t * at, int rows, mpz_t prime)
+{
+    std::vector<mpz_t> alphas(m);
+    compute_lagrange_coefficients(alphas, from, m, prime);
+
+    mpz_t weight;
+    mpz_init(weight);
+
+    field_batch_init(matrix, (size_t) rows * m, prime);
+
+    for (int a = 0; a < rows; a++)
+    {
+        for (int b = 0; b < m; b++)
+        {
+            enroll_lagrange_weight(weight, alphas, from, m, b, at[a], prime);
+            field_batch_set(matrix, (size_t) a * m + b, weight);
+        }
+    }
+
+    mpz_clear(weight);
+    for (int b = 0; b < m; b++) {
+        mpz_clear(alphas[b]);
+    }
+}
+
+// Fonction qui calcule la matrice (n x (l + t)) qui donne les parts des n participants à partir des valeurs réservées
+void packed_share_matrix(field_batch & matrix, mpz_t * x, int n, int l, int t, mpz_t prime)
+{
+    std::vector<mpz_t> points(l + t);
+    packed_points(points, l, t, prime);
+
+    packed_lagrange_matrix(matrix, points.data(), l + t, x, n, prime);
+
+    for (int j = 0; j < l + t; j++) {
+        mpz_clear(points[j]);
+    }
+}
+
+// Fonction qui calcule la matrice (l x (l + t)) qui donne les l secrets à partir des parts des l + t premiers xi
+void packed_reconstruct_matrix(field_batch & matrix, mpz_t * x, int l, int t, mpz_t prime)
+{
+    std::vector<mpz_t> points(l + t);
+    packed_points(points, l, t, prime);
+
+    // Seuls les l points des secrets nous intéressent
+    packed_lagrange_matrix(matrix, x, l + t, points.data(), l, prime);
+
+    for (int j = 0; j < l + t; j++) {
+        mpz_clear(points[j]);
+    }
+}
+
+// Fonction qui partage les secrets (l x groups) par paquets de l : chaque participant reçoit un lot de groups parts
+// La colonne g de secrets contient les l secrets du paquet g, shares[i] reçoit les parts du participant i
+// Les t lignes aléatoires cachent les secrets : elles sont tirées par refresh_random_batch (RAND_bytes et AES-256-CTR)
+bool packed_split(std::vector<field_batch> & shares, const field_batch & secrets, const field_batch & shareMatrix, int n, int l, int t, mpz_t prime)
+{
+    size_t groups = secrets.count / l;
+
+    // Valeurs aux points réservés : les secrets puis t lignes aléatoires
+    field_batch random, values;
+    if (!refresh_random_batch(random, (size_t) t * groups, prime)) {
+        return false;
+    }
+    field_batch_init(values, (size_t) (l + t) * groups, prime);
+    std::copy(secrets.data.begin(), secrets.data.end(), values.data.begin());
+    std::copy(random.data.begin(), random.data.end(), values.data.begin() + (size_t) l * groups * values.limbs);
+
+    field_batch all;
+    field_batch_matmul(all, shareMatrix, values, n, l + t, groups, prime);
+
+    shares.resize(n);
+    for (int i = 0; i < n; i++) {
+        field_batch_get_row(shares[i], all, i, groups);
+    }
+
+    OPENSSL_cleanse(random.data.data(), random.data.size() * sizeof(mp_limb_t));
+    OPENSSL_cleanse(values.data.data(), values.data.size() * sizeof(mp_limb_t));
+    return true;
+}
+
+// Fonction qui reconstruit les secrets (l x groups) à partir des lots de parts des l + t premiers xi
+void packed_reconstruct(field_batch & secrets, std::vector<field_batch> & shares, const field_batch & reconstructMatrix, int l, int t, mpz_t prime)
+{
+    size_t groups = shares[0].count;
+
+    field_batch received;
+    field_batch_init(received, (size_t) (l + t) * groups, prime);
+    for (int i = 0; i < l + t; i++) {
+        field_batch_set_row(received, i, shares[i]);
+    }
+
+    field_batch_matmul(secrets, reconstructMatrix, received, l, l + t, groups, prime);
+}
@@ -0,0 +1,24 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include <gmp.h>
+#include <vector>
+
+#include "batch.h"
+
+// Fonction qui donne le nombre de parts nécessaires pour reconstruire l secrets empaquetés avec un seuil de confidentialité t
+int packed_threshold(int l, int t);
+
+// Fonction qui calcule la matrice (n x (l + t)) qui donne les parts des n participants à partir des valeurs réservées
+void packed_share_matrix(field_batch & matrix, mpz_t * x, int n, int l, int t, mpz_t prime);
+
+// Fonction qui calcule la matrice (l x (l + t)) qui donne les l secrets à partir des parts des l + t premiers xi
+void packed_reconstruct_matrix(field_batch & matrix, mpz_t * x, int l, int t, mpz_t prime);
+
+// Fonction qui partage les secrets (l x groups) par paquets de l : chaque participant reçoit un lot de groups parts
+bool packed_split(std::vector<field_batch> & shares, const field_batch & secrets, const field_batch & shareMatrix, int n, int l, int t, mpz_t prime);
+
+// Fonction qui reconstruit les secrets (l x groups) à partir des lots de parts des l + t premiers xi
+void packed_reconstruct(field_batch & secrets, std::vector<field_batch> & shares, const field_batch & reconstructMatrix, int l, int t, mpz_t prime);
+
+#endif
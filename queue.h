@@ -0,0 +1,214 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// File bloquante de capacité bornée entre threads producteurs et consommateurs
+// push bloque tant que la file est pleine, pop tant qu'elle est vide ; après close() les deux renvoient false
+template <typename T>
+class blocking_queue
+{
+public:
+    explicit blocking_queue(size_t capacity) : capacity_(capacity), closed_(false) {}
+
+    bool push(const T & value)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(value);
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    bool pop(T & value)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return false;
+        }
+        value = items_.front();
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    // Les éléments déjà en file restent disponibles pour pop
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
+
+private:
+    size_t capacity_;
+    bool closed_;
+    std::deque<T> items_;
+    std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+};
+
+// File de réordonnancement : des producteurs déposent les éléments dans le désordre avec leur rang (first, first + 1 ...)
+// et pop les rend dans l'ordre des rangs. La file n'est pas bornée : la mémoire est bornée par le nombre de rangs
+// en circulation, par exemple un jeu fixe de tampons recyclés par une blocking_queue
+template <typename T>
+class ordered_queue
+{
+public:
+    explicit ordered_queue(unsigned long long first = 0) : next_(first), closed_(false) {}
+
+    bool push(unsigned long long rank, const T & value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return false;
+        }
+        items_[rank] = value;
+        if (rank == next_) {
+            ready_.notify_all();
+        }
+        return true;
+    }
+
+    // Attend l'élément de rang suivant ; renvoie false après close() s'il n'est pas arrivé
+    bool pop(T & value)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return closed_ || (!items_.empty() && items_.begin()->first == next_); });
+        if (items_.empty() || items_.begin()->first != next_) {
+            return false;
+        }
+        value = items_.begin()->second;
+        items_.erase(items_.begin());
+        next_++;
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        ready_.notify_all();
+    }
+
+private:
+    unsigned long long next_;
+    bool closed_;
+    std::map<unsigned long long, T> items_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+};
+
+// File sans verrou, bornée, à plusieurs producteurs et plusieurs consommateurs (anneau de D. Vyukov) : chaque case
+// porte un numéro de séquence qui dit si elle attend une écriture ou une lecture. try_push échoue si la file est
+// pleine et try_pop si elle est vide, sans jamais bloquer. La capacité est arrondie à une puissance de 2
+template <typename T>
+class ring_queue
+{
+public:
+    explicit ring_queue(size_t capacity) : mask_(round(capacity) - 1), cells_(new cell[mask_ + 1]), enqueue_(0), dequeue_(0)
+    {
+        for (size_t i = 0; i <= mask_; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool try_push(const T & value)
+    {
+        size_t position = enqueue_.load(std::memory_order_relaxed);
+        cell * target;
+        while (true)
+        {
+            target = &cells_[position & mask_];
+            size_t sequence = target->sequence.load(std::memory_order_acquire);
+            long difference = (long) sequence - (long) position;
+            if (difference == 0)
+            {
+                if (enqueue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueue_.load(std::memory_order_relaxed);
+            }
+        }
+        target->value = value;
+        target->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T & value)
+    {
+        size_t position = dequeue_.load(std::memory_order_relaxed);
+        cell * source;
+        while (true)
+        {
+            source = &cells_[position & mask_];
+            size_t sequence = source->sequence.load(std::memory_order_acquire);
+            long difference = (long) sequence - (long) (position + 1);
+            if (difference == 0)
+            {
+                if (dequeue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = dequeue_.load(std::memory_order_relaxed);
+            }
+        }
+        value = source->value;
+        source->sequence.store(position + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Nombre approché d'éléments (exact en l'absence d'opération concurrente)
+    size_t size() const
+    {
+        size_t enqueued = enqueue_.load(std::memory_order_acquire), dequeued = dequeue_.load(std::memory_order_acquire);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    ring_queue(const ring_queue &);
+    ring_queue & operator=(const ring_queue &);
+
+    struct cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t round(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    const size_t mask_;
+    std::unique_ptr<cell[]> cells_;
+    char padding_[64];                          // Lignes de cache distinctes : producteurs et consommateurs ne se gênent pas
+    std::atomic<size_t> enqueue_;
+    char padding2_[64];
+    std::atomic<size_t> dequeue_;
+};
+
+#endif
@@ -0,0 +1,188 @@
+#include "quorum.h"
+#include "stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+
+#include <openssl/crypto.h>
+
+/*
+ * Reconstruction couverte (hedged) : en production les parts viennent de n services dépositaires et les plus lents
+ * fixent la latence d'une reconstruction qui attend un sous-ensemble fixe de k services. Interroger les n services
+ * et garder les k premières réponses coupe cette queue de latence : il suffit que k services sur n soient rapides.
+ * Les demandes en retard sont annulées par un stop_token commun à la reconstruction, pour ne pas retenir leurs
+ * services. Une réponse en erreur est remplacée par une demande à la source suivante pas encore interrogée.
+ */
+
+// Etat d'une reconstruction, partagé avec les threads des sources interrogées (les retardataires s'en servent
+// encore après le retour de combine)
+struct quorum_round
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::stop_source stop;
+    int needed;
+    int pending;                            // Demandes envoyées sans réponse
+    std::vector<int> x;                     // Réponses reçues, dans l'ordre d'arrivée
+    std::vector<std::vector<unsigned char> > shares;
+};
+
+quorum_file_source::quorum_file_source(const std::string & prefix, int x, const quorum_faults & faults, unsigned int seed)
+    : path_(prefix + "." + std::to_string(x)), x_(x), faults_(faults), random_(seed)
+{
+}
+
+// Fonction qui rend la part après le délai injecté ; l'attente est interrompue par stop
+bool quorum_file_source::fetch(std::vector<unsigned char> & share, std::stop_token stop)
+{
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    double delay = faults_.delayMs * (0.5 + uniform(random_));
+    if (uniform(random_) < faults_.slowProbability) {
+        delay += faults_.slowMs;
+    }
+    bool fail = uniform(random_) < faults_.failProbability;
+
+    std::mutex mutex;
+    std::condition_variable_any never;
+    std::unique_lock<std::mutex> lock(mutex);
+    never.wait_for(lock, stop, std::chrono::duration<double, std::milli>(delay), [] { return false; });
+    if (stop.stop_requested() || fail) {
+        return false;
+    }
+
+    std::ifstream in(path_.c_str(), std::ios::binary);
+    share.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return in.good() || in.eof();
+}
+
+quorum_combiner::quorum_combiner(const std::vector<quorum_source *> & sources) : sources_(sources), cancelled_(0), failed_(0)
+{
+    for (size_t i = 0; i < sources_.size(); i++) {
+        queues_.push_back(std::unique_ptr<blocking_queue<std::shared_ptr<quorum_round> > >(new blocking_queue<std::shared_ptr<quorum_round> >(QUORUM_QUEUE)));
+    }
+    for (size_t i = 0; i < sources_.size(); i++) {
+        threads_.push_back(std::thread(&quorum_combiner::serve, this, i));
+    }
+}
+
+quorum_combiner::~quorum_combiner()
+{
+    for (size_t i = 0; i < queues_.size(); i++) {
+        queues_[i]->close();
+    }
+    for (size_t i = 0; i < threads_.size(); i++) {
+        threads_[i].join();
+    }
+}
+
+// Thread d'une source : ses demandes sont servies dans l'ordre ; une demande déjà annulée n'est pas envoyée
+void quorum_combiner::serve(size_t index)
+{
+    std::shared_ptr<quorum_round> round;
+    while (queues_[index]->pop(round))
+    {
+        std::vector<unsigned char> share;
+        std::stop_token stop = round->stop.get_token();
+        bool ok = !stop.stop_requested() && sources_[index]->fetch(share, stop);
+
+        std::lock_guard<std::mutex> lock(round->mutex);
+        if (ok && (int) round->x.size() < round->needed)
+        {
+            round->x.push_back(sources_[index]->x());
+            round->shares.push_back(share);
+            if ((int) round->x.size() == round->needed) {
+                round->stop.request_stop();
+            }
+        } else if (!ok && stop.stop_requested()) {
+            cancelled_++;
+        } else if (!ok) {
+            failed_++;
+        }
+        OPENSSL_cleanse(share.data(), share.size());
+        round->pending--;
+        round->changed.notify_all();
+        round.reset();
+    }
+}
+
+// Fonction qui reconstruit le secret à partir des k premières parts reçues
+int quorum_combiner::combine(int k, int ask, std::vector<unsigned char> & secret, std::vector<int> * used)
+{
+    int n = sources_.size();
+    if (k < 1 || k > n || k > 255) {
+        return QUORUM_ERROR_FORMAT;
+    }
+    ask = std::min(std::max(ask, k), n);
+
+    std::shared_ptr<quorum_round> round = std::make_shared<quorum_round>();
+    round->needed = k;
+    round->pending = 0;
+    int next = 0;
+    std::unique_lock<std::mutex> lock(round->mutex);
+    while ((int) round->x.size() < k)
+    {
+        // Sources à interroger : les ask premières, puis une de plus par réponse en erreur
+        int wanted = next == 0 ? ask : std::min(n - next, k - (int) round->x.size() - round->pending);
+        if (wanted > 0)
+        {
+            round->pending += wanted;
+            lock.unlock();
+            for (int i = 0; i < wanted; i++) {
+                queues_[next++]->push(round);
+            }
+            lock.lock();
+            continue;
+        }
+        if (round->pending == 0) {
+            break;
+        }
+        round->changed.wait(lock);
+    }
+
+    std::vector<int> x(round->x);
+    std::vector<std::vector<unsigned char> > shares;
+    shares.swap(round->shares);
+    lock.unlock();
+
+    int status = (int) x.size() < k ? QUORUM_ERROR_SHORT : QUORUM_OK;
+    for (int i = 1; i < (int) shares.size() && status == QUORUM_OK; i++)
+    {
+        if (shares[i].size() != shares[0].size()) {
+            status = QUORUM_ERROR_FORMAT;
+        }
+    }
+    if (status == QUORUM_OK)
+    {
+        std::vector<const unsigned char *> pointers(k);
+        for (int i = 0; i < k; i++) {
+            pointers[i] = shares[i].data();
+        }
+        std::vector<unsigned char> weights(k);
+        stream_lagrange_weights(weights.data(), x.data(), k, 0);
+        secret.resize(shares[0].size());
+        stream_reconstruct_chunk(secret.data(), pointers.data(), weights.data(), secret.size(), k, NULL);
+        if (used != NULL) {
+            *used = x;
+        }
+    }
+    for (size_t i = 0; i < shares.size(); i++) {
+        OPENSSL_cleanse(shares[i].data(), shares[i].size());
+    }
+    return status;
+}
+
+// Fonction qui donne le message d'un code de retour du quorum
+const char * quorum_error_string(int error)
+{
+    switch (error)
+    {
+        case QUORUM_OK: return "ok";
+        case QUORUM_ERROR_SHORT: return "fewer than k sources answered";
+        case QUORUM_ERROR_FORMAT: return "shares of different lengths, or k out of range";
+        default: return "unknown error";
+    }
+}
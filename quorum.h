@@ -0,0 +1,95 @@
+#ifndef QUORUM_H
+#define QUORUM_H
+
+#include "queue.h"
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define QUORUM_QUEUE 64                 // Demandes en attente par source
+
+// Codes de retour de la reconstruction par quorum
+#define QUORUM_OK 0
+#define QUORUM_ERROR_SHORT 1            // Moins de k sources ont répondu
+#define QUORUM_ERROR_FORMAT 2           // Parts de tailles différentes, ou k hors des limites
+
+// Source d'une part : un service dépositaire, ou ce qui en tient lieu
+struct quorum_source
+{
+    virtual ~quorum_source() {}
+
+    // Abscisse de la part de la source
+    virtual int x() const = 0;
+
+    // Fonction qui rend la part ; doit abandonner (renvoyer false) dès que stop est demandé
+    virtual bool fetch(std::vector<unsigned char> & share, std::stop_token stop) = 0;
+};
+
+// Pannes injectées dans une source simulée
+struct quorum_faults
+{
+    double delayMs;                         // Délai d'une réponse, tiré uniformément entre delayMs / 2 et 3 delayMs / 2
+    double slowProbability;                 // Probabilité d'une réponse lente...
+    double slowMs;                          // ... qui prend slowMs de plus
+    double failProbability;                 // Probabilité d'une réponse en erreur, après le délai
+};
+
+// Source simulée : lit la part <prefix>.<x> (format de dealer-split) après un délai et des pannes injectés
+class quorum_file_source : public quorum_source
+{
+public:
+    quorum_file_source(const std::string & prefix, int x, const quorum_faults & faults, unsigned int seed);
+
+    int x() const { return x_; }
+    bool fetch(std::vector<unsigned char> & share, std::stop_token stop);
+
+private:
+    std::string path_;
+    int x_;
+    quorum_faults faults_;
+    std::mt19937 random_;
+};
+
+struct quorum_round;
+
+// Reconstruction par quorum : chaque source a un thread qui sert ses demandes dans l'ordre. Une reconstruction
+// interroge d'emblée ask sources (ask = k : sous-ensemble fixe ; ask = n : toutes, requêtes couvertes), remplace
+// chaque source en erreur par la suivante et reconstruit dès les k premières réponses ; les demandes encore en
+// cours sont alors annulées, ce qui libère leurs sources pour la reconstruction suivante
+class quorum_combiner
+{
+public:
+    // Les sources restent à l'appelant et doivent vivre plus longtemps que le quorum_combiner
+    explicit quorum_combiner(const std::vector<quorum_source *> & sources);
+    ~quorum_combiner();
+
+    // Fonction qui reconstruit le secret à partir des k premières parts reçues ; used reçoit, s'il n'est pas nul, les
+    // abscisses utilisées
+    int combine(int k, int ask, std::vector<unsigned char> & secret, std::vector<int> * used = NULL);
+
+    // Demandes annulées et réponses en erreur depuis la création
+    unsigned long long cancelled() const { return cancelled_; }
+    unsigned long long failed() const { return failed_; }
+
+private:
+    quorum_combiner(const quorum_combiner &);
+    quorum_combiner & operator=(const quorum_combiner &);
+
+    void serve(size_t index);
+
+    std::vector<quorum_source *> sources_;
+    std::vector<std::unique_ptr<blocking_queue<std::shared_ptr<quorum_round> > > > queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<unsigned long long> cancelled_;
+    std::atomic<unsigned long long> failed_;
+};
+
+// Fonction qui donne le message d'un code de retour du quorum
+const char * quorum_error_string(int error);
+
+#endif
@@ -0,0 +1,178 @@
+#include "ramp.h"
+#include "refresh.h"
+#include "shamir.h"
+
+#include <algorithm>
+
+#include <openssl/crypto.h>
+
+/*
+ * Partage à rampe : le polynome de degré k-1 porte k - t morceaux du secret dans ses coefficients t ... k-1
+ * (les coefficients de poids fort, comme le secret dans generate_coefficients) et t coefficients aléatoires.
+ * t parts ne révèlent rien, k parts reconstruisent tout, et chaque part est k - t fois plus petite que le secret.
+ *
+ * Le secret est découpé en éléments de elementBytes octets (big-endian, le dernier complété par des zéros),
+ * ce qui impose prime > 2^(8 * elementBytes) (voir generate_field_prime). L'élément e va dans le coefficient
+ * t + e % (k - t) du polynome e / (k - t).
+ */
+
+// Fonction qui donne le nombre d'éléments de elementBytes octets que porte la part d'un participant pour un secret de length octets
+size_t ramp_share_elements(size_t length, int k, int t, int elementBytes)
+{
+    if (t < 0 || t >= k) {
+        return 0;
+    }
+    size_t elements = (length + elementBytes - 1) / elementBytes;
+    return (elements + (k - t) - 1) / (k - t);
+}
+
+// Fonction qui partage un secret de taille quelconque avec un seuil de confidentialité t et un seuil de reconstruction k
+// shares[i] reçoit ramp_share_elements(...) éléments pour le participant d'abscisse x[i]
+// Les t coefficients aléatoires de chaque polynome sont tirés par refresh_random_batch (RAND_bytes et AES-256-CTR)
+bool ramp_split(std::vector<field_batch> & shares, const std::vector<unsigned char> & blob, mpz_t * x, int n, int k, int t, int elementBytes, mpz_t prime)
+{
+    if (t < 0 || t >= k) {
+        return false;
+    }
+    size_t groups = ramp_share_elements(blob.size(), k, t, elementBytes);
+    size_t elements = (blob.size() + elementBytes - 1) / elementBytes;
+
+    mpz_t value;
+    mpz_init(value);
+
+    // Matrice (k x groups) des coefficients : une colonne par polynome, les t premières lignes aléatoires
+    field_batch random, coefficients;
+    if (!refresh_random_batch(random, (size_t) t * groups, prime))
+    {
+        mpz_clear(value);
+        return false;
+    }
+    field_batch_init(coefficients, (size_t) k * groups, prime);
+    std::copy(random.data.begin(), random.data.end(), coefficients.data.begin());
+
+    std::vector<unsigned char> block(elementBytes);
+    for (size_t e = 0; e < elements; e++)
+    {
+        size_t offset = e * elementBytes;
+        size_t size = blob.size() - offset < (size_t) elementBytes ? blob.size() - offset : elementBytes;
+
+        std::fill(block.begin(), block.end(), 0);
+        std::copy(blob.begin() + offset, blob.begin() + offset + size, block.begin());
+        mpz_import(value, elementBytes, 1, 1, 1, 0, block.data());
+
+        field_batch_set(coefficients, (size_t) (t + e % (k - t)) * groups + e / (k - t), value);
+    }
+
+    // Les parts de tous les polynomes d'un coup : Vandermonde (n x k) * coefficients (k x groups)
+    field_batch vandermonde, all;
+    field_batch_vandermonde(vandermonde, x, n, k, prime);
+    field_batch_matmul(all, vandermonde, coefficients, n, k, groups, prime);
+
+    shares.resize(n);
+    for (int i = 0; i < n; i++) {
+        field_batch_get_row(shares[i], all, i, groups);
+    }
+
+    OPENSSL_cleanse(random.data.data(), random.data.size() * sizeof(mp_limb_t));
+    OPENSSL_cleanse(coefficients.data.data(), coefficients.data.size() * sizeof(mp_limb_t));
+    mpz_clear(value);
+    return true;
+}
+
+// Fonction qui calcule la matrice ((k - t) x k) qui donne les coefficients t ... k-1 à partir des parts des xi
+// Le polynome vaut la somme des alphas[i] * y[i] * M(X) / (X - x[i]) avec M(X) = produit des (X - x[j]) :
+// seuls les k - t coefficients de poids fort de chaque quotient sont nécessaires (division synthétique depuis le haut)
+bool ramp_reconstruct_matrix(field_batch & matrix, mpz_t * x, int k, int t, mpz_t prime)
+{
+    if (t < 0 || t >= k) {
+        return false;
+    }
+    std::vector<mpz_t> alphas(k);
+    compute_lagrange_coefficients(alphas, x, k, prime);
+
+    // M(X) = produit des (X - x[j]), master[d] est le coefficient de X^d
+    std::vector<mpz_t> master(k + 1);
+    for (int d = 0; d <= k; d++) {
+        mpz_init_set_ui(master[d], d == 0 ? 1 : 0);
+    }
+    mpz_t quotient, entry;
+    mpz_inits(quotient, entry, NULL);
+
+    for (int j = 0; j < k; j++)
+    {
+        // Multiplication par (X - x[j]) : master[d] = master[d - 1] - x[j] * master[d]
+        for (int d = j + 1; d >= 1; d--)
+        {
+            mpz_mul(entry, master[d], x[j]);
+            mpz_sub(master[d], master[d - 1], entry);
+            mpz_mod(master[d], master[d], prime);
+        }
+        mpz_mul(master[0], master[0], x[j]);
+        mpz_neg(master[0], master[0]);
+        mpz_mod(master[0], master[0], prime);
+    }
+
+    field_batch_init(matrix, (size_t) (k - t) * k, prime);
+
+    for (int i = 0; i < k; i++)
+    {
+        // Coefficients de M(X) / (X - x[i]) du degré k-1 jusqu'au degré t
+        mpz_set_ui(quotient, 1);
+        for (int d = k - 1; d >= t; d--)
+        {
+            mpz_mul(entry, quotient, alphas[i]);
+            mpz_mod(entry, entry, prime);
+            field_batch_set(matrix, (size_t) (d - t) * k + i, entry);
+
+            mpz_mul(quotient, quotient, x[i]);
+            mpz_add(quotient, quotient, master[d]);
+            mpz_mod(quotient, quotient, prime);
+        }
+    }
+
+    mpz_clears(quotient, entry, NULL);
+    for (int d = 0; d <= k; d++) {
+        mpz_clear(master[d]);
+    }
+    for (int i = 0; i < k; i++) {
+        mpz_clear(alphas[i]);
+    }
+    return true;
+}
+
+// Fonction qui reconstruit les length octets du secret à partir des lots de parts des k xi de la matrice
+bool ramp_reconstruct(std::vector<unsigned char> & blob, size_t length, std::vector<field_batch> & shares, const field_batch & reconstructMatrix, int k, int t, int elementBytes, mpz_t prime)
+{
+    if (t < 0 || t >= k || (int) shares.size() < k) {
+        return false;
+    }
+    size_t groups = shares[0].count;
+    size_t elements = (length + elementBytes - 1) / elementBytes;
+
+    field_batch received, chunks;
+    field_batch_init(received, (size_t) k * groups, prime);
+    for (int i = 0; i < k; i++) {
+        field_batch_set_row(received, i, shares[i]);
+    }
+
+    field_batch_matmul(chunks, reconstructMatrix, received, k - t, k, groups, prime);
+
+    mpz_t value;
+    mpz_init(value);
+
+    blob.assign(elements * elementBytes, 0);
+    for (size_t e = 0; e < elements; e++)
+    {
+        field_batch_get(value, chunks, (size_t) (e % (k - t)) * groups + e / (k - t));
+
+        // Export big-endian aligné à droite sur elementBytes octets
+        size_t count = (mpz_sizeinbase(value, 2) + 7) / 8;
+        if (mpz_sgn(value) != 0 && count <= (size_t) elementBytes) {
+            mpz_export(blob.data() + e * elementBytes + elementBytes - count, NULL, 1, 1, 1, 0, value);
+        }
+    }
+    blob.resize(length);
+
+    mpz_clear(value);
+    return true;
+}
@@ -0,0 +1,23 @@
+#ifndef RAMP_H
+#define RAMP_H
+
+#include <gmp.h>
+#include <vector>
+
+#include "batch.h"
+
+// Les fonctions du partage à rampe exigent 0 <= t < k : sinon elles ne calculent rien (0 éléments, false)
+
+// Fonction qui donne le nombre d'éléments de elementBytes octets que porte la part d'un participant pour un secret de length octets
+size_t ramp_share_elements(size_t length, int k, int t, int elementBytes);
+
+// Fonction qui partage un secret de taille quelconque avec un seuil de confidentialité t et un seuil de reconstruction k
+bool ramp_split(std::vector<field_batch> & shares, const std::vector<unsigned char> & blob, mpz_t * x, int n, int k, int t, int elementBytes, mpz_t prime);
+
+// Fonction qui calcule la matrice ((k - t) x k) qui donne les coefficients t ... k-1 à partir des parts des xi
+bool ramp_reconstruct_matrix(field_batch & matrix, mpz_t * x, int k, int t, mpz_t prime);
+
+// Fonction qui reconstruit les length octets du secret à partir des lots de parts des k xi de la matrice
+bool ramp_reconstruct(std::vector<unsigned char> & blob, size_t length, std::vector<field_batch> & shares, const field_batch & reconstructMatrix, int k, int t, int elementBytes, mpz_t prime);
+
+#endif
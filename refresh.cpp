@@ -0,0 +1,145 @@
+#include "refresh.h"
+
+#include <algorithm>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#define REFRESH_EXTRA_BYTES 8 // Octets tirés en plus de la taille de p : le biais de la réduction modulo p est en 2^-64
+
+/*
+ * Rafraîchissement proactif : chaque contributeur choisit, pour chaque secret du lot, un polynome de degré k-2 au
+ * plus, donc de coefficient du secret (le coefficient k-1) nul. Chaque destinataire ajoute à ses parts les valeurs
+ * en son abscisse des polynomes de tous les contributeurs : les parts changent mais reconstruisent le même secret.
+ *
+ * Le contributeur partage une graine distincte avec chacun des k-1 premiers destinataires x[0] ... x[k-2], par un
+ * canal privé : la valeur du polynome en x[i] est dérivée de la graine i par AES-256-CTR (une PRF), ce qui fixe
+ * le polynome. Les autres destinataires reçoivent leur valeur explicitement, calculée par interpolation. Un
+ * destinataire ne connaît ainsi que sa propre valeur : k-1 destinataires coalisés voient k-1 valeurs d'un polynome
+ * de degré k-2 aléatoire, qui ne disent rien des valeurs des autres. Pour les k-1 premiers destinataires seule la
+ * graine circule, quel que soit le nombre de secrets du lot ; les graines sont détruites après usage.
+ */
+
+// Fonction qui tire la graine partagée par un contributeur et un destinataire pour une époque de rafraîchissement
+bool refresh_generate_seed(unsigned char * seed)
+{
+    return RAND_bytes(seed, REFRESH_SEED_BYTES) == 1;
+}
+
+// Fonction qui dérive d'une graine, par la PRF AES-256-CTR, les valeurs en l'abscisse du destinataire des polynomes
+// de rafraîchissement de count secrets
+bool refresh_derive_deltas(field_batch & deltas, const unsigned char * seed, size_t count, mpz_t prime)
+{
+    size_t elementBytes = mpz_sizeinbase(prime, 256) + REFRESH_EXTRA_BYTES;
+    std::vector<unsigned char> stream(count * elementBytes, 0);
+
+    // Chaque graine ne sert qu'une fois : le compteur part de zéro
+    unsigned char iv[16] = { 0 };
+    EVP_CIPHER_CTX * ctx = EVP_CIPHER_CTX_new();
+    bool ok = ctx != NULL && EVP_EncryptInit_ex(ctx, EVP_aes_256_ctr(), NULL, seed, iv) == 1;
+
+    // Le flot chiffre des zéros, par paquets car EVP_EncryptUpdate prend une taille de type int
+    for (size_t offset = 0; ok && offset < stream.size(); offset += (1 << 30))
+    {
+        int length = std::min((size_t) (1 << 30), stream.size() - offset);
+        int written = 0;
+        ok = EVP_EncryptUpdate(ctx, stream.data() + offset, &written, stream.data() + offset, length) == 1;
+    }
+    EVP_CIPHER_CTX_free(ctx);
+
+    field_batch_init(deltas, count, prime);
+
+    mpz_t y;
+    mpz_init(y);
+    for (size_t s = 0; ok && s < count; s++)
+    {
+        mpz_import(y, elementBytes, 1, 1, 1, 0, stream.data() + s * elementBytes);
+        mpz_mod(y, y, prime);
+        field_batch_set(deltas, s, y);
+    }
+    mpz_clear(y);
+
+    OPENSSL_cleanse(stream.data(), stream.size());
+    return ok;
+}
+
+// Fonction qui tire count éléments uniformes de Z/pZ : une graine neuve (RAND_bytes) dérivée par la PRF AES-256-CTR
+// Sert aux coefficients qui cachent un secret ou une part, à la place d'un gmp_randstate_t (Mersenne Twister)
+bool refresh_random_batch(field_batch & batch, size_t count, mpz_t prime)
+{
+    unsigned char seed[REFRESH_SEED_BYTES];
+    bool ok = refresh_generate_seed(seed) && refresh_derive_deltas(batch, seed, count, prime);
+    OPENSSL_cleanse(seed, REFRESH_SEED_BYTES);
+    return ok;
+}
+
+// Fonction du contributeur : ses polynomes sont fixés par les valeurs dérivées des graines des destinataires x[0] ... x[k-2],
+// il calcule leurs valeurs en x[k-1] ... x[n-1] à envoyer explicitement (evaluations[r] pour le destinataire x[k-1+r])
+bool refresh_evaluations(std::vector<field_batch> & evaluations, const unsigned char * const * seeds, mpz_t * x, int n, int k, size_t count, mpz_t prime)
+{
+    int rows = n - (k - 1);
+    int inner = k - 1;
+
+    // Valeurs dérivées des graines, une ligne par destinataire x[0] ... x[k-2]
+    field_batch values, derived;
+    field_batch_init(values, (size_t) inner * count, prime);
+    bool ok = true;
+    for (int i = 0; ok && i < inner; i++)
+    {
+        ok = refresh_derive_deltas(derived, seeds[i], count, prime);
+        field_batch_set_row(values, i, derived);
+    }
+    OPENSSL_cleanse(derived.data.data(), derived.data.size() * sizeof(mp_limb_t));
+
+    // Poids de Lagrange des noeuds x[0] ... x[k-2] en x[k-1+r] : produit des (x[k-1+r] - x[j]) / (x[i] - x[j]) pour j != i
+    field_batch weights;
+    field_batch_init(weights, (size_t) rows * inner, prime);
+    mpz_t weight, temp;
+    mpz_inits(weight, temp, NULL);
+    for (int r = 0; ok && r < rows; r++)
+    {
+        for (int i = 0; i < inner; i++)
+        {
+            mpz_set_ui(weight, 1);
+            for (int j = 0; j < inner; j++)
+            {
+                if (j != i)
+                {
+                    mpz_sub(temp, x[k - 1 + r], x[j]);
+                    mpz_mul(weight, weight, temp);
+                    mpz_sub(temp, x[i], x[j]);
+                    mpz_invert(temp, temp, prime);
+                    mpz_mul(weight, weight, temp);
+                    mpz_mod(weight, weight, prime);
+                }
+            }
+            field_batch_set(weights, (size_t) r * inner + i, weight);
+        }
+    }
+    mpz_clears(weight, temp, NULL);
+
+    evaluations.clear();
+    if (ok)
+    {
+        field_batch product;
+        field_batch_matmul(product, weights, values, rows, inner, count, prime);
+
+        evaluations.resize(rows);
+        for (int r = 0; r < rows; r++) {
+            field_batch_get_row(evaluations[r], product, r, count);
+        }
+        OPENSSL_cleanse(product.data.data(), product.data.size() * sizeof(mp_limb_t));
+    }
+
+    OPENSSL_cleanse(values.data.data(), values.data.size() * sizeof(mp_limb_t));
+    return ok;
+}
+
+// Fonction qui rafraîchit le lot de parts d'un destinataire avec les valeurs reçues de chaque contributeur
+void refresh_shares(field_batch & shares, const std::vector<field_batch> & deltas, mpz_t prime)
+{
+    for (size_t c = 0; c < deltas.size(); c++) {
+        field_batch_add_mod(shares, deltas[c], prime);
+    }
+}
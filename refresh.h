@@ -0,0 +1,28 @@
+#ifndef REFRESH_H
+#define REFRESH_H
+
+#include <gmp.h>
+#include <vector>
+
+#include "batch.h"
+
+#define REFRESH_SEED_BYTES 32 // Taille d'une graine (clé AES-256 de la PRF)
+
+// Fonction qui tire la graine partagée par un contributeur et un destinataire pour une époque de rafraîchissement
+bool refresh_generate_seed(unsigned char * seed);
+
+// Fonction qui dérive d'une graine, par la PRF AES-256-CTR, les valeurs en l'abscisse du destinataire des polynomes
+// de rafraîchissement de count secrets
+bool refresh_derive_deltas(field_batch & deltas, const unsigned char * seed, size_t count, mpz_t prime);
+
+// Fonction qui tire count éléments uniformes de Z/pZ : une graine neuve (RAND_bytes) dérivée par la PRF AES-256-CTR
+bool refresh_random_batch(field_batch & batch, size_t count, mpz_t prime);
+
+// Fonction du contributeur : ses polynomes sont fixés par les valeurs dérivées des graines des destinataires x[0] ... x[k-2],
+// il calcule leurs valeurs en x[k-1] ... x[n-1] à envoyer explicitement (evaluations[r] pour le destinataire x[k-1+r])
+bool refresh_evaluations(std::vector<field_batch> & evaluations, const unsigned char * const * seeds, mpz_t * x, int n, int k, size_t count, mpz_t prime);
+
+// Fonction qui rafraîchit le lot de parts d'un destinataire avec les valeurs reçues de chaque contributeur
+void refresh_shares(field_batch & shares, const std::vector<field_batch> & deltas, mpz_t prime);
+
+#endif
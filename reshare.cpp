@@ -0,0 +1,68 @@
+#include "reshare.h"
+#include "refresh.h"
+
+#include <algorithm>
+
+#include <openssl/crypto.h>
+
+/*
+ * Changement de politique (k, n) -> (kNew, nNew) sans reconstruire les secrets.
+ * Chacun des k anciens détenteurs partage sa part avec un nouveau polynome de degré kNew-1 (sa part en est
+ * le coefficient kNew-1, comme le secret dans generate_coefficients) et envoie une sous-part à chaque nouveau
+ * détenteur. Le nouveau détenteur r combine les k sous-parts reçues avec les alphas de l'ancien quorum : le
+ * polynome obtenu a pour coefficient kNew-1 la somme des alphas[i] * y_i, c'est-à-dire le secret.
+ *
+ * Pour un lot de count secrets, les sous-parts d'un ancien détenteur sont le produit de la matrice de
+ * Vandermonde (nNew x kNew) des nouvelles abscisses par la matrice (kNew x count) des coefficients.
+ * Les coefficients aléatoires cachent la part de l'ancien détenteur : ils sont tirés par refresh_random_batch
+ * (RAND_bytes et AES-256-CTR), jamais d'un générateur que l'on pourrait rejouer.
+ */
+
+// Fonction qui calcule les sous-parts (nNew x count) qu'un ancien détenteur envoie aux nouveaux détenteurs
+// vandermonde est la matrice des nouvelles abscisses construite une fois par field_batch_vandermonde(nNew x kNew)
+bool reshare_subshares(field_batch & subshares, const field_batch & shares, const field_batch & vandermonde, int kNew, int nNew, mpz_t prime)
+{
+    size_t count = shares.count;
+
+    // Matrice des coefficients : une colonne par secret, les kNew-1 premières lignes aléatoires, la dernière contient
+    // les parts de l'ancien détenteur
+    field_batch random, coefficients;
+    if (!refresh_random_batch(random, (size_t) (kNew - 1) * count, prime)) {
+        return false;
+    }
+    field_batch_init(coefficients, (size_t) kNew * count, prime);
+    std::copy(random.data.begin(), random.data.end(), coefficients.data.begin());
+    std::copy(shares.data.begin(), shares.data.end(), coefficients.data.begin() + (size_t) (kNew - 1) * count * coefficients.limbs);
+
+    field_batch_matmul(subshares, vandermonde, coefficients, nNew, kNew, count, prime);
+
+    OPENSSL_cleanse(random.data.data(), random.data.size() * sizeof(mp_limb_t));
+    OPENSSL_cleanse(coefficients.data.data(), coefficients.data.size() * sizeof(mp_limb_t));
+    return true;
+}
+
+// Fonction qui calcule les nouvelles parts du nouveau détenteur r à partir des sous-parts reçues des k anciens détenteurs
+// subshares[i] est la matrice envoyée par l'ancien détenteur i, alphas sont les coefficients de Lagrange de l'ancien quorum
+void reshare_combine(field_batch & newShares, std::vector<field_batch> & subshares, int k, int nNew, int r, std::vector<mpz_t> & alphas, mpz_t prime)
+{
+    size_t count = subshares[0].count / nNew;
+    mp_size_t limbs = mpz_size(prime);
+
+    // Ligne des alphas (1 x k)
+    field_batch weights;
+    field_batch_init(weights, k, prime);
+    for (int i = 0; i < k; i++) {
+        field_batch_set(weights, i, alphas[i]);
+    }
+
+    // Matrice (k x count) des sous-parts reçues : la ligne r de chaque matrice envoyée
+    field_batch received;
+    field_batch_init(received, (size_t) k * count, prime);
+    for (int i = 0; i < k; i++)
+    {
+        std::vector<mp_limb_t>::const_iterator row = subshares[i].data.begin() + (size_t) r * count * limbs;
+        std::copy(row, row + count * limbs, received.data.begin() + (size_t) i * count * limbs);
+    }
+
+    field_batch_matmul(newShares, weights, received, 1, k, count, prime);
+}
@@ -0,0 +1,15 @@
+#ifndef RESHARE_H
+#define RESHARE_H
+
+#include <gmp.h>
+#include <vector>
+
+#include "batch.h"
+
+// Fonction qui calcule les sous-parts (nNew x count) qu'un ancien détenteur envoie aux nouveaux détenteurs
+bool reshare_subshares(field_batch & subshares, const field_batch & shares, const field_batch & vandermonde, int kNew, int nNew, mpz_t prime);
+
+// Fonction qui calcule les nouvelles parts du nouveau détenteur r à partir des sous-parts reçues des k anciens détenteurs
+void reshare_combine(field_batch & newShares, std::vector<field_batch> & subshares, int k, int nNew, int r, std::vector<mpz_t> & alphas, mpz_t prime);
+
+#endif
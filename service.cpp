@@ -0,0 +1,380 @@
+#include "service.h"
+#include "bytes.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <openssl/crypto.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/*
+ * Boucle d'événements du service de partage. Chaque thread d'entrée-sortie a son epoll ; la socket d'écoute est
+ * inscrite dans tous avec EPOLLEXCLUSIVE (un seul thread réveillé par connexion entrante) et une connexion reste
+ * au thread qui l'a acceptée : son état n'est jamais partagé et n'a pas de verrou.
+ *
+ * Les connexions sont inscrites en déclenchement sur front (EPOLLET) : un événement n'est signalé qu'à l'arrivée de
+ * nouveaux octets, la connexion est donc lue jusqu'à EAGAIN, sauf quand elle est volontairement laissée en
+ * attente (requête en calcul, réponse pas encore envoyée) : elle est alors relue dès que l'attente cesse.
+ *
+ * Les workers rendent les requêtes calculées par une pile sans verrou propre à chaque boucle ; seul le premier
+ * calcul déposé dans une pile vide écrit dans l'eventfd de la boucle, qui reprend ensuite toute la pile.
+ */
+
+// Fonction qui dépose une requête calculée dans la pile de la boucle (appelée par un worker)
+void service_loop::completed(dealer_request * request)
+{
+    service_connection * connection = static_cast<service_connection *>(request);
+    service_connection * head = completions.load(std::memory_order_relaxed);
+    do {
+        connection->nextCompleted = head;
+    } while (!completions.compare_exchange_weak(head, connection, std::memory_order_release, std::memory_order_relaxed));
+
+    if (head == NULL)
+    {
+        unsigned long long one = 1;
+        ssize_t written = write(event, &one, sizeof(one));
+        (void) written;
+    }
+}
+
+dealer_service::dealer_service() : listen_(-1), stopping_(false), connections_(0), accepted_(0), shed_(0)
+{
+}
+
+dealer_service::~dealer_service()
+{
+    close();
+}
+
+// Fonction qui crée la socket d'écoute à path, les boucles d'entrée-sortie et les workers de calcul
+bool dealer_service::open(const std::string & path, int ioThreads, int workers, size_t queueCapacity)
+{
+    listen_ = dealer_listen(path);
+    if (listen_ < 0) {
+        return false;
+    }
+    path_ = path;
+    stopping_ = false;
+    bool ok = fcntl(listen_, F_SETFL, fcntl(listen_, F_GETFL) | O_NONBLOCK) == 0 && engine_.start(workers, queueCapacity);
+
+    for (int i = 0; i < std::max(1, ioThreads) && ok; i++)
+    {
+        service_loop * loop = new service_loop();
+        loop->epoll = epoll_create1(EPOLL_CLOEXEC);
+        loop->event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        loop->completions = NULL;
+        loop->inFlight = 0;
+        loops_.push_back(loop);
+
+        struct epoll_event wake, incoming;
+        wake.events = EPOLLIN;
+        wake.data.ptr = loop;
+        incoming.events = EPOLLIN | EPOLLEXCLUSIVE;
+        incoming.data.ptr = &listen_;
+        ok = loop->epoll >= 0 && loop->event >= 0 && epoll_ctl(loop->epoll, EPOLL_CTL_ADD, loop->event, &wake) == 0
+            && epoll_ctl(loop->epoll, EPOLL_CTL_ADD, listen_, &incoming) == 0;
+    }
+
+    if (!ok) {
+        close();
+    }
+    return ok;
+}
+
+// Fonction qui sert les connexions jusqu'à stop()
+void dealer_service::run()
+{
+    for (size_t i = 0; i < loops_.size(); i++) {
+        loops_[i]->thread = std::thread(&dealer_service::loop, this, loops_[i]);
+    }
+    for (size_t i = 0; i < loops_.size(); i++) {
+        loops_[i]->thread.join();
+    }
+}
+
+// Fonction qui demande l'arrêt ; seuls des appels système sûrs dans un gestionnaire de signal sont faits ici
+void dealer_service::stop()
+{
+    stopping_ = true;
+    for (size_t i = 0; i < loops_.size(); i++)
+    {
+        unsigned long long one = 1;
+        ssize_t written = write(loops_[i]->event, &one, sizeof(one));
+        (void) written;
+    }
+}
+
+// Fonction qui attend la fin des boucles, arrête les workers et supprime la socket
+void dealer_service::close()
+{
+    if (listen_ < 0) {
+        return;
+    }
+    stop();
+    for (size_t i = 0; i < loops_.size(); i++)
+    {
+        if (loops_[i]->thread.joinable()) {
+            loops_[i]->thread.join();
+        }
+    }
+    engine_.stop();
+
+    for (size_t i = 0; i < loops_.size(); i++)
+    {
+        // Une boucle jamais lancée garde ses connexions : aucune n'a de requête en calcul
+        while (!loops_[i]->connections.empty()) {
+            release(*loops_[i]->connections.begin());
+        }
+        for (size_t j = 0; j < loops_[i]->released.size(); j++) {
+            delete loops_[i]->released[j];
+        }
+        if (loops_[i]->epoll >= 0) {
+            ::close(loops_[i]->epoll);
+        }
+        if (loops_[i]->event >= 0) {
+            ::close(loops_[i]->event);
+        }
+        delete loops_[i];
+    }
+    loops_.clear();
+
+    ::close(listen_);
+    listen_ = -1;
+    unlink(path_.c_str());
+}
+
+// Boucle d'un thread d'entrée-sortie ; après stop(), elle attend encore les requêtes en calcul de ses connexions
+void dealer_service::loop(service_loop * loop)
+{
+    struct epoll_event events[SERVICE_EVENTS];
+    bool listening = true;
+    while (!stopping_ || loop->inFlight > 0)
+    {
+        if (stopping_ && listening)
+        {
+            epoll_ctl(loop->epoll, EPOLL_CTL_DEL, listen_, NULL);
+            listening = false;
+        }
+
+        int count = epoll_wait(loop->epoll, events, SERVICE_EVENTS, -1);
+        for (int e = 0; e < count; e++)
+        {
+            void * source = events[e].data.ptr;
+            if (source == &listen_)
+            {
+                if (!stopping_) {
+                    accept_connections(loop);
+                }
+                continue;
+            }
+
+            if (source == loop)
+            {
+                unsigned long long value;
+                ssize_t got = read(loop->event, &value, sizeof(value));
+                (void) got;
+
+                // La pile est rendue dans l'ordre inverse des dépôts : elle est retournée pour servir les plus anciens d'abord
+                service_connection * list = loop->completions.exchange(NULL, std::memory_order_acquire), * ordered = NULL;
+                while (list != NULL)
+                {
+                    service_connection * next = list->nextCompleted;
+                    list->nextCompleted = ordered;
+                    ordered = list;
+                    list = next;
+                }
+
+                while (ordered != NULL)
+                {
+                    service_connection * connection = ordered;
+                    ordered = ordered->nextCompleted;
+                    connection->inFlight = false;
+                    loop->inFlight--;
+
+                    unsigned char size[4];
+                    store_uint(size, connection->response.size(), 4);
+                    connection->output.insert(connection->output.end(), size, size + 4);
+                    connection->output.insert(connection->output.end(), connection->response.begin(), connection->response.end());
+                    OPENSSL_cleanse(connection->response.data(), connection->response.size());
+                    flush(connection);
+                    pump(connection);
+                }
+                continue;
+            }
+
+            // Une connexion fermée plus tôt dans le même lot n'est pas encore libérée
+            service_connection * connection = (service_connection *) source;
+            if (connection->fd < 0) {
+                continue;
+            }
+            if (events[e].events & EPOLLOUT) {
+                flush(connection);
+            }
+            pump(connection);
+        }
+
+        for (size_t i = 0; i < loop->released.size(); i++) {
+            delete loop->released[i];
+        }
+        loop->released.clear();
+    }
+
+    while (!loop->connections.empty()) {
+        release(*loop->connections.begin());
+    }
+    for (size_t i = 0; i < loop->released.size(); i++) {
+        delete loop->released[i];
+    }
+    loop->released.clear();
+}
+
+// Fonction qui accepte toutes les connexions en attente ; au-delà de SERVICE_MAX_CONNECTIONS, elles sont fermées
+void dealer_service::accept_connections(service_loop * loop)
+{
+    while (true)
+    {
+        int fd = accept4(listen_, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Plus de descripteur : la socket d'écoute reste prête, une pause évite de boucler
+            if (errno == EMFILE || errno == ENFILE) {
+                usleep(1000);
+            }
+            return;
+        }
+
+        if (connections_ >= SERVICE_MAX_CONNECTIONS)
+        {
+            ::close(fd);
+            shed_++;
+            continue;
+        }
+
+        service_connection * connection = new service_connection();
+        connection->fd = fd;
+        connection->loop = loop;
+        connection->listener = loop;
+        connection->inputOffset = connection->outputOffset = 0;
+        connection->inFlight = connection->closed = false;
+        connection->nextCompleted = NULL;
+
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = connection;
+        if (epoll_ctl(loop->epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            ::close(fd);
+            delete connection;
+            continue;
+        }
+        loop->connections.insert(connection);
+        connections_++;
+        accepted_++;
+    }
+}
+
+// Fonction qui découpe et soumet les trames d'une connexion, en la lisant jusqu'à EAGAIN ; la connexion n'est plus
+// lue tant qu'une requête est en calcul ou qu'une réponse attend d'être envoyée. Une connexion fermée sans requête
+// en calcul est libérée : l'appelant ne doit plus s'en servir
+void dealer_service::pump(service_connection * connection)
+{
+    while (!connection->closed && !connection->inFlight && connection->outputOffset == connection->output.size() && !stopping_)
+    {
+        std::vector<unsigned char> & input = connection->input;
+        size_t available = input.size() - connection->inputOffset;
+        if (available >= 4)
+        {
+            unsigned long long length = load_uint(input.data() + connection->inputOffset, 4);
+            if (length > DEALER_MAX_BODY)
+            {
+                connection->closed = true;
+                break;
+            }
+            if (available >= 4 + length)
+            {
+                std::vector<unsigned char>::iterator first = input.begin() + connection->inputOffset + 4;
+                connection->body.assign(first, first + length);
+                connection->inputOffset += 4 + length;
+
+                if (engine_.submit(connection))
+                {
+                    connection->inFlight = true;
+                    connection->loop->inFlight++;
+                } else {
+                    // Délestage : réponse immédiate plutôt qu'une attente sans limite
+                    static const unsigned char busy[8] = { DEALER_HEADER_BYTES, 0, 0, 0, DEALER_ERROR_BUSY, 0, 0, 0 };
+                    shed_++;
+                    OPENSSL_cleanse(connection->body.data(), connection->body.size());
+                    connection->output.insert(connection->output.end(), busy, busy + sizeof(busy));
+                    flush(connection);
+                }
+                continue;
+            }
+        }
+
+        // Trame incomplète : les octets déjà découpés sont effacés, puis la connexion est lue
+        if (connection->inputOffset > 0)
+        {
+            OPENSSL_cleanse(input.data(), connection->inputOffset);
+            input.erase(input.begin(), input.begin() + connection->inputOffset);
+            connection->inputOffset = 0;
+        }
+        size_t old = input.size();
+        input.resize(old + SERVICE_READ_BYTES);
+        ssize_t got = read(connection->fd, input.data() + old, SERVICE_READ_BYTES);
+        input.resize(old + (got > 0 ? got : 0));
+        if (got > 0 || (got < 0 && errno == EINTR)) {
+            continue;
+        }
+        if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            connection->closed = true;
+        }
+        break;
+    }
+
+    if (connection->closed && !connection->inFlight) {
+        release(connection);
+    }
+}
+
+// Fonction qui envoie les réponses en attente jusqu'à EAGAIN (la suite partira sur EPOLLOUT)
+void dealer_service::flush(service_connection * connection)
+{
+    std::vector<unsigned char> & output = connection->output;
+    while (connection->outputOffset < output.size() && !connection->closed)
+    {
+        ssize_t sent = send(connection->fd, output.data() + connection->outputOffset, output.size() - connection->outputOffset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection->outputOffset += sent;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else {
+            connection->closed = true;
+        }
+    }
+    OPENSSL_cleanse(output.data(), output.size());
+    output.clear();
+    connection->outputOffset = 0;
+}
+
+// Fonction qui ferme une connexion sans requête en calcul ; elle est libérée à la fin du lot d'événements
+void dealer_service::release(service_connection * connection)
+{
+    ::close(connection->fd);
+    connection->fd = -1;
+    OPENSSL_cleanse(connection->input.data(), connection->input.size());
+    OPENSSL_cleanse(connection->body.data(), connection->body.size());
+    connection->loop->connections.erase(connection);
+    connection->loop->released.push_back(connection);
+    connections_--;
+}
@@ -0,0 +1,96 @@
+#ifndef SERVICE_H
+#define SERVICE_H
+
+#include "dealer.h"
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define SERVICE_IO_THREADS 2            // Threads d'entrée-sortie par défaut
+#define SERVICE_MAX_CONNECTIONS 16384   // Connexions au-delà desquelles les nouvelles sont fermées dès l'acceptation
+#define SERVICE_EVENTS 256              // Evénements lus par epoll_wait
+#define SERVICE_READ_BYTES 65536        // Taille d'une lecture sur une connexion
+
+struct service_loop;
+
+// Connexion du service : possédée par le thread d'entrée-sortie qui l'a acceptée, elle porte sa requête en calcul
+struct service_connection : public dealer_request
+{
+    int fd;
+    service_loop * loop;
+    std::vector<unsigned char> input;       // Octets reçus pas encore découpés en trames
+    size_t inputOffset;
+    std::vector<unsigned char> output;      // Réponses pas encore envoyées
+    size_t outputOffset;
+    bool inFlight;                          // Requête en calcul : la connexion n'est plus lue jusqu'à sa réponse
+    bool closed;                            // Pair parti ou erreur : libérée dès que plus rien n'est en calcul
+    service_connection * nextCompleted;     // Pile des calculs terminés de la boucle
+};
+
+// Boucle d'un thread d'entrée-sortie : son epoll, son eventfd et la pile sans verrou des requêtes calculées
+struct service_loop : public dealer_listener
+{
+    int epoll;
+    int event;
+    std::atomic<service_connection *> completions;
+    std::set<service_connection *> connections;
+    std::vector<service_connection *> released;    // Fermées pendant le lot d'événements, libérées à sa fin
+    int inFlight;
+    std::thread thread;
+
+    void completed(dealer_request * request);
+};
+
+// Service de partage piloté par epoll (déclenchement sur front) : quelques threads d'entrée-sortie découpent les
+// trames de milliers de connexions et passent les requêtes aux workers du dealer_engine par sa file sans verrou.
+// Contre-pression : une connexion n'est plus lue tant que sa requête est en calcul ou sa réponse pas envoyée, le
+// client est alors freiné par le tampon de la socket. Délestage : file de calcul pleine, la requête reçoit
+// aussitôt DEALER_ERROR_BUSY ; trop de connexions, les nouvelles sont fermées
+class dealer_service
+{
+public:
+    dealer_service();
+    ~dealer_service();
+
+    // Fonction qui crée la socket d'écoute à path, les boucles d'entrée-sortie et les workers de calcul
+    bool open(const std::string & path, int ioThreads, int workers, size_t queueCapacity);
+
+    // Fonction qui sert les connexions jusqu'à stop()
+    void run();
+
+    // Fonction qui demande l'arrêt : plus de nouvelle requête, les requêtes en calcul sont terminées ; utilisable
+    // depuis un gestionnaire de signal
+    void stop();
+
+    // Fonction qui attend la fin des boucles, arrête les workers et supprime la socket
+    void close();
+
+    const dealer_engine & engine() const { return engine_; }
+    dealer_engine & engine() { return engine_; }
+    unsigned long long accepted() const { return accepted_; }
+    unsigned long long shed() const { return shed_; }
+
+private:
+    dealer_service(const dealer_service &);
+    dealer_service & operator=(const dealer_service &);
+
+    void loop(service_loop * loop);
+    void accept_connections(service_loop * loop);
+    void pump(service_connection * connection);
+    void flush(service_connection * connection);
+    void release(service_connection * connection);
+
+    std::string path_;
+    int listen_;
+    std::atomic<bool> stopping_;
+    std::atomic<int> connections_;
+    std::atomic<unsigned long long> accepted_;
+    std::atomic<unsigned long long> shed_;
+    dealer_engine engine_;
+    std::vector<service_loop *> loops_;
+};
+
+#endif
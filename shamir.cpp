@@ -0,0 +1,126 @@
+#include "shamir.h"
+
+// Fonction qui génère un nombre premier avec un nombre de bits donné
+void generate_prime(mpz_t num, int bit_strength, gmp_randstate_t gmpRandState) 
+{
+    // Génère un nombre aléatoire avec un nombre de bits donné en prenant un état aléatoire
+    mpz_urandomb(num, gmpRandState, bit_strength);
+
+    // On met le dernier bit à 1 pour qu'il soit impair car les nombres premiers supérieurs à 2 sont tous impairs
+    mpz_setbit(num, 0);
+
+    // On trouve le nombre premier le plus proche du nombre aléatoire généré
+    mpz_nextprime(num, num);
+}
+
+// Fonction qui donne le plus petit nombre premier supérieur à 2^(8 * bytes) : tout bloc de bytes octets est alors un élément de Z/pZ
+void generate_field_prime(mpz_t num, int bytes) 
+{
+    mpz_set_ui(num, 0);
+    mpz_setbit(num, 8 * bytes);
+    mpz_nextprime(num, num);
+}
+
+// Fonction qui génère un secret de façon aléatoire dans l'intervalle [0; prime] 
+void generate_secret(mpz_t secret, mpz_t prime, gmp_randstate_t gmpRandState) 
+{
+    mpz_urandomm(secret, gmpRandState, prime);
+}
+
+// Fonction qui génère les coefficients du polynome
+void generate_coefficients(std::vector<mpz_t> & coefficients, mpz_t prime, int & k, mpz_t secret, gmp_randstate_t gmpRandState) 
+{
+    // Génère les coefficients aléatoirement dans l'intervalle [0; prime] et les stocke dans le vecteur de coefficients
+    for (int i = 0; i < k - 1; i++) {
+        mpz_init(coefficients[i]);
+        mpz_urandomm(coefficients[i], gmpRandState, prime);
+    }
+
+    // On met le coefficient nulle égale au secret
+    mpz_init_set(coefficients[k - 1], secret);
+}
+
+// Fonction qui calcul les yi des points avec des xi et des coefficients donnés, k fois  
+void compute_shares(std::vector<mpz_t> & x, std::vector<mpz_t> & y, mpz_t * coefficients, int k) 
+{
+    mpz_t temp;
+
+    for (int i = 0; i < k; i++) // On parcourt le vecteur des xi, yi pour un seuil donné k
+    {
+        // Initialise yi à 0
+        mpz_init_set_ui(y[i], 0);
+
+        mpz_init(temp); // Utilisation d'un temp pour ne pas écraser les anciennes valeurs des yi
+
+        // Calcul des yi pour des xi et coefficients donnés
+        for (int j = 0; j < k; j++) 
+        {
+            mpz_pow_ui(temp, x[i], j);     // x^j
+            mpz_mul(temp, temp, coefficients[j]);  // coefficients[j] * x^j
+            mpz_add(y[i], y[i], temp);        // On met le résultat de coefficients[j] * x^j dans yi
+        }
+    }
+    mpz_clear(temp);
+}
+
+// Fonction qui évalue le polynome en x modulo prime par le schéma de Horner
+void evaluate_polynomial(mpz_t y, mpz_t * coefficients, int k, mpz_t x, mpz_t prime) 
+{
+    mpz_set(y, coefficients[k - 1]);
+
+    for (int j = k - 2; j >= 0; j--) 
+    {
+        mpz_mul(y, y, x);                  // y * x
+        mpz_add(y, y, coefficients[j]);    // y * x + coefficients[j]
+        mpz_mod(y, y, prime);
+    }
+}
+
+// Fonction qui calcul les coefficients de Lagrange
+// alphas[i] = 1 / produit des (x[i] - x[j]) pour j != i : ce sont les poids barycentriques des xi,
+// la somme des alphas[i] * y[i] donne le coefficient de degré k-1 du polynome, c'est-à-dire le secret
+void compute_lagrange_coefficients(std::vector<mpz_t> & alphas, mpz_t * x, int k, mpz_t prime) 
+{
+    // Calcul des coefficients de Lagrange pour l'interpolation
+    for (int i = 0; i < k; i++) 
+    {
+        mpz_init_set_ui(alphas[i], 1); // Car alphas[i](xi) = 1
+
+        for (int j = 0; j < k; j++) 
+        {
+            if (j != i) {
+                mpz_t temp;
+                mpz_init(temp);
+
+                // Calcul : (x[i] - x[j])^-1 modulo prime
+                mpz_sub(temp, x[i], x[j]); // x[i] - x[j]
+                mpz_invert(temp, temp, prime); // Calcul l'inverse multiplicatif de (x[i] - x[j]) puis on fait le modulo prime
+
+                // Met à jour le coefficient de Lagrange
+                mpz_mul(alphas[i], alphas[i], temp);
+                mpz_mod(alphas[i], alphas[i], prime);
+                mpz_clear(temp);
+            }
+        }
+    }
+}
+
+// Fonction de recronstruction de secret avec k coefficients, k parts et p
+void reconstruct_secret(mpz_t reconstructedSecret, std::vector<mpz_t> & alphas, mpz_t * shares, int k, mpz_t p) 
+{
+    // Initialisation à 0
+    mpz_init_set_ui(reconstructedSecret, 0);
+
+    mpz_t temp;
+    mpz_init(temp);
+
+    // Reconstruct the secret using Lagrange interpolation
+    for (int i = 0; i < k; i++) {
+        mpz_mul(temp, alphas[i], shares[i]); // alpha[i] * y[i]
+        mpz_add(reconstructedSecret, reconstructedSecret, temp); // Mise à jour du résultat
+    }
+
+    // On module par p pour obtenir le Secret
+    mpz_mod(reconstructedSecret, reconstructedSecret, p);
+    mpz_clear(temp);
+}
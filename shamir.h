@@ -0,0 +1,31 @@
+#ifndef SHAMIR_H
+#define SHAMIR_H
+
+#include <gmp.h>
+#include <vector>
+
+// Fonction qui génère un nombre premier avec un nombre de bits donné
+void generate_prime(mpz_t num, int bit_strength, gmp_randstate_t gmpRandState);
+
+// Fonction qui donne le plus petit nombre premier supérieur à 2^(8 * bytes) : tout bloc de bytes octets est alors un élément de Z/pZ
+void generate_field_prime(mpz_t num, int bytes);
+
+// Fonction qui génère un secret de façon aléatoire dans l'intervalle [0; prime] 
+void generate_secret(mpz_t secret, mpz_t prime, gmp_randstate_t gmpRandState);
+
+// Fonction qui génère les coefficients du polynome (le secret est le coefficient k-1)
+void generate_coefficients(std::vector<mpz_t> & coefficients, mpz_t prime, int & k, mpz_t secret, gmp_randstate_t gmpRandState);
+
+// Fonction qui calcul les yi des points avec des xi et des coefficients donnés, k fois  
+void compute_shares(std::vector<mpz_t> & x, std::vector<mpz_t> & y, mpz_t * coefficients, int k);
+
+// Fonction qui évalue le polynome en x modulo prime par le schéma de Horner
+void evaluate_polynomial(mpz_t y, mpz_t * coefficients, int k, mpz_t x, mpz_t prime);
+
+// Fonction qui calcul les coefficients de Lagrange
+void compute_lagrange_coefficients(std::vector<mpz_t> & alphas, mpz_t * x, int k, mpz_t prime);
+
+// Fonction de recronstruction de secret avec k coefficients, k parts et p
+void reconstruct_secret(mpz_t reconstructedSecret, std::vector<mpz_t> & alphas, mpz_t * shares, int k, mpz_t p);
+
+#endif
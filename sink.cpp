@@ -0,0 +1,372 @@
+#include "sink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/*
+ * Les n flux de parts reçoivent toujours les mêmes tailles : ils avancent ensemble dans des tampons de
+ * SINK_STAGE_BYTES octets, un par fichier. Quand les tampons sont pleins, les n écritures partent en une
+ * seule soumission io_uring (IORING_OP_WRITE_FIXED sur des tampons enregistrés, donc sans projection des
+ * pages à chaque écriture), liées entre elles pour qu'un échec annule les suivantes. Pendant ce temps le
+ * second jeu de tampons se remplit : un seul appel système par mégaoctet et par lot de n fichiers, au lieu
+ * de n écritures par morceau.
+ *
+ * Tampons et positions sont alignés sur SINK_ALIGNMENT, ce qui permet O_DIRECT ; seule la fin du fichier,
+ * de taille quelconque, est écrite sans O_DIRECT. Une écriture courte ou annulée est refaite par pwrite.
+ * Pour reprendre un partage, les fichiers sont tronqués au point de reprise et le bloc aligné qui le contient
+ * est relu dans les tampons : les écritures suivantes restent alignées.
+ * Si io_uring n'est pas disponible (noyau ancien, seccomp, mémoire verrouillable insuffisante), les
+ * tampons sont écrits par pwrite, fichier par fichier.
+ */
+
+// Fonctions d'appel système io_uring (sans liburing)
+static int sink_uring_setup(unsigned entries, io_uring_params * params)
+{
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sink_uring_enter(int ring, unsigned submit, unsigned complete, unsigned flags)
+{
+    return syscall(__NR_io_uring_enter, ring, submit, complete, flags, NULL, 0);
+}
+
+static int sink_uring_register(int ring, unsigned opcode, void * arg, unsigned count)
+{
+    return syscall(__NR_io_uring_register, ring, opcode, arg, count);
+}
+
+file_sink::file_sink()
+    : direct_(false), failed_(false), buffers_(NULL), current_(0), fill_(0), offset_(0), ring_(-1), rings_(MAP_FAILED),
+      ringsSize_(0), sqes_(MAP_FAILED), sqesSize_(0), sqTail_(NULL), sqMask_(NULL),
+      sqArray_(NULL), cqHead_(NULL), cqTail_(NULL), cqMask_(NULL), cqes_(NULL)
+{
+    setOffset_[0] = setOffset_[1] = 0;
+    setLength_[0] = setLength_[1] = 0;
+    pending_[0] = pending_[1] = 0;
+}
+
+file_sink::~file_sink()
+{
+    // Sans finish() (arrêt sur erreur), les écritures en cours sont attendues avant de libérer les tampons
+    if (ring_ >= 0) {
+        wait_set(0);
+        wait_set(1);
+    }
+    close_ring();
+    for (size_t i = 0; i < fds_.size(); i++) {
+        close(fds_[i]);
+    }
+    free(buffers_);
+}
+
+// Fonction qui crée les fichiers ; avec direct, ils sont ouverts en O_DIRECT si le système de fichiers l'accepte
+// Avec resumeOffset non nul, les fichiers existants sont gardés jusqu'à cette position et l'écriture continue à la suite
+bool file_sink::open(const std::vector<std::string> & paths, bool direct, unsigned long long resumeOffset)
+{
+    direct_ = direct;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        int flags = resumeOffset == 0 ? O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC : O_RDWR | O_CLOEXEC;
+        int fd = direct_ ? ::open(paths[i].c_str(), flags | O_DIRECT, 0644) : -1;
+        if (fd < 0) {
+            // tmpfs et certains systèmes de fichiers refusent O_DIRECT : tous les fichiers passent alors par le cache
+            direct_ = false;
+            fd = ::open(paths[i].c_str(), flags, 0644);
+        }
+        if (fd < 0) {
+            return false;
+        }
+        fds_.push_back(fd);
+    }
+    if (!direct_)
+    {
+        for (size_t i = 0; i < fds_.size(); i++) {
+            fcntl(fds_[i], F_SETFL, fcntl(fds_[i], F_GETFL) & ~O_DIRECT);
+        }
+    }
+
+    void * memory = NULL;
+    if (fds_.empty() || posix_memalign(&memory, SINK_ALIGNMENT, 2 * fds_.size() * SINK_STAGE_BYTES) != 0) {
+        return false;
+    }
+    buffers_ = (unsigned char *) memory;
+
+    // Reprise : le début du bloc aligné qui contient le point de reprise est relu dans le jeu courant
+    if (resumeOffset != 0)
+    {
+        offset_ = resumeOffset & ~(unsigned long long) (SINK_ALIGNMENT - 1);
+        fill_ = resumeOffset - offset_;
+        for (size_t i = 0; i < fds_.size(); i++)
+        {
+            if (ftruncate(fds_[i], resumeOffset) != 0 || !read_sync(i, buffer(current_, i), fill_, offset_)) {
+                return false;
+            }
+        }
+    }
+
+    if (!setup_ring()) {
+        close_ring();
+    }
+    return true;
+}
+
+// Fonction qui crée l'anneau io_uring et enregistre les 2n tampons
+bool file_sink::setup_ring()
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_ = sink_uring_setup(2 * fds_.size(), &params);
+    if (ring_ < 0 || !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        return false;
+    }
+
+    // Une seule projection pour les deux anneaux (IORING_FEAT_SINGLE_MMAP)
+    ringsSize_ = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned), params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    rings_ = mmap(NULL, ringsSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQ_RING);
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(NULL, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQES);
+    if (rings_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+        return false;
+    }
+
+    unsigned char * sq = (unsigned char *) rings_;
+    sqTail_ = (unsigned *) (sq + params.sq_off.tail);
+    sqMask_ = (unsigned *) (sq + params.sq_off.ring_mask);
+    sqArray_ = (unsigned *) (sq + params.sq_off.array);
+    cqHead_ = (unsigned *) (sq + params.cq_off.head);
+    cqTail_ = (unsigned *) (sq + params.cq_off.tail);
+    cqMask_ = (unsigned *) (sq + params.cq_off.ring_mask);
+    cqes_ = sq + params.cq_off.cqes;
+
+    std::vector<iovec> iovecs(2 * fds_.size());
+    for (size_t b = 0; b < iovecs.size(); b++)
+    {
+        iovecs[b].iov_base = buffers_ + b * SINK_STAGE_BYTES;
+        iovecs[b].iov_len = SINK_STAGE_BYTES;
+    }
+    return sink_uring_register(ring_, IORING_REGISTER_BUFFERS, iovecs.data(), iovecs.size()) == 0;
+}
+
+// Fonction qui libère l'anneau : les écritures passent ensuite par pwrite
+void file_sink::close_ring()
+{
+    if (sqes_ != MAP_FAILED) {
+        munmap(sqes_, sqesSize_);
+    }
+    if (rings_ != MAP_FAILED) {
+        munmap(rings_, ringsSize_);
+    }
+    if (ring_ >= 0) {
+        close(ring_);
+    }
+    sqes_ = rings_ = MAP_FAILED;
+    ring_ = -1;
+}
+
+bool file_sink::append(const unsigned char * data, size_t stride, size_t length)
+{
+    size_t done = 0;
+    while (done < length && !failed_)
+    {
+        size_t size = std::min((size_t) SINK_STAGE_BYTES - fill_, length - done);
+        for (size_t i = 0; i < fds_.size(); i++) {
+            memcpy(buffer(current_, i) + fill_, data + i * stride + done, size);
+        }
+        fill_ += size;
+        done += size;
+
+        if (fill_ == SINK_STAGE_BYTES) {
+            flush();
+        }
+    }
+    return !failed_;
+}
+
+// Fonction qui écrit le jeu courant et passe à l'autre jeu, une fois ses écritures terminées
+bool file_sink::flush()
+{
+    setOffset_[current_] = offset_;
+    setLength_[current_] = fill_;
+    if (ring_ >= 0) {
+        submit(current_);
+    } else {
+        for (size_t i = 0; i < fds_.size() && !failed_; i++) {
+            failed_ = !write_sync(i, buffer(current_, i), fill_, offset_);
+        }
+    }
+
+    offset_ += fill_;
+    fill_ = 0;
+    current_ ^= 1;
+    return wait_set(current_) && !failed_;
+}
+
+// Fonction qui soumet en un appel les n écritures liées du jeu
+void file_sink::submit(int set)
+{
+    unsigned tail = *sqTail_;
+    int n = fds_.size();
+    for (int i = 0; i < n; i++)
+    {
+        unsigned slot = tail & *sqMask_;
+        io_uring_sqe * sqe = (io_uring_sqe *) sqes_ + slot;
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->fd = fds_[i];
+        sqe->off = setOffset_[set];
+        sqe->addr = (unsigned long long) buffer(set, i);
+        sqe->len = setLength_[set];
+        sqe->buf_index = set * n + i;
+        sqe->flags = i + 1 < n ? IOSQE_IO_LINK : 0;
+        sqe->user_data = set * n + i;
+        sqArray_[slot] = slot;
+        tail++;
+    }
+    __atomic_store_n(sqTail_, tail, __ATOMIC_RELEASE);
+
+    int submitted = sink_uring_enter(ring_, n, 0, 0);
+    if (submitted != n) {
+        failed_ = true;
+        return;
+    }
+    pending_[set] += n;
+}
+
+// Fonction qui traite les complétions disponibles, en attendant au moins l'une d'elles avec wait
+void file_sink::reap(bool wait)
+{
+    unsigned head = *cqHead_;
+    if (wait && head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE))
+    {
+        if (sink_uring_enter(ring_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            failed_ = true;
+            pending_[0] = pending_[1] = 0;
+            return;
+        }
+    }
+
+    int n = fds_.size();
+    while (head != __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE))
+    {
+        const io_uring_cqe * cqe = (const io_uring_cqe *) cqes_ + (head & *cqMask_);
+        int set = cqe->user_data / n, file = cqe->user_data % n;
+
+        // Ecriture courte, en erreur ou annulée par l'échec d'une écriture liée : on la refait par pwrite
+        if (cqe->res != (int) setLength_[set] && !write_sync(file, buffer(set, file), setLength_[set], setOffset_[set])) {
+            failed_ = true;
+        }
+        pending_[set]--;
+        head++;
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+}
+
+// Fonction qui attend la fin des écritures d'un jeu avant de le réutiliser
+bool file_sink::wait_set(int set)
+{
+    while (ring_ >= 0 && pending_[set] > 0) {
+        reap(true);
+    }
+    return !failed_;
+}
+
+// Fonction qui lit entièrement un tampon par pread, hors O_DIRECT (la taille est quelconque)
+bool file_sink::read_sync(int file, unsigned char * data, size_t length, unsigned long long offset)
+{
+    set_direct(file, false);
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t got = pread(fds_[file], data + done, length - done, offset + done);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            break;
+        }
+        done += got;
+    }
+    set_direct(file, direct_);
+    return done == length;
+}
+
+// Fonction qui active ou désactive O_DIRECT sur un fichier
+void file_sink::set_direct(int file, bool direct)
+{
+    int flags = fcntl(fds_[file], F_GETFL);
+    fcntl(fds_[file], F_SETFL, direct ? flags | O_DIRECT : flags & ~O_DIRECT);
+}
+
+// Fonction qui écrit entièrement un tampon par pwrite
+bool file_sink::write_sync(int file, const unsigned char * data, size_t length, unsigned long long offset)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t written = pwrite(fds_[file], data + done, length - done, offset + done);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        done += written;
+    }
+    return true;
+}
+
+// Fonction qui rend durables les octets ajoutés : le jeu en cours de remplissage est écrit (hors O_DIRECT) sans être
+// libéré, il sera écrit à nouveau, complété, à la même position
+bool file_sink::sync()
+{
+    wait_set(0);
+    wait_set(1);
+
+    for (size_t i = 0; i < fds_.size() && !failed_; i++)
+    {
+        if (fill_ > 0)
+        {
+            set_direct(i, false);
+            failed_ = !write_sync(i, buffer(current_, i), fill_, offset_);
+            set_direct(i, direct_);
+        }
+        if (!failed_ && fdatasync(fds_[i]) != 0) {
+            failed_ = true;
+        }
+    }
+    return !failed_;
+}
+
+// Fonction qui écrit la fin des fichiers et attend toutes les écritures
+bool file_sink::finish()
+{
+    wait_set(0);
+    wait_set(1);
+
+    // La fin n'est pas alignée : elle est écrite hors O_DIRECT
+    for (size_t i = 0; i < fds_.size() && !failed_ && fill_ > 0; i++)
+    {
+        set_direct(i, false);
+        failed_ = !write_sync(i, buffer(current_, i), fill_, offset_);
+    }
+    offset_ += fill_;
+    fill_ = 0;
+
+    for (size_t i = 0; i < fds_.size(); i++)
+    {
+        if (close(fds_[i]) != 0) {
+            failed_ = true;
+        }
+    }
+    fds_.clear();
+    return !failed_;
+}
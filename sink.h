@@ -0,0 +1,73 @@
+#ifndef SINK_H
+#define SINK_H
+
+#include "stream.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#define SINK_STAGE_BYTES (1 << 20)  // Tampon d'écriture de chaque fichier, multiple de SINK_ALIGNMENT
+#define SINK_ALIGNMENT 4096         // Alignement des tampons et des positions d'écriture exigé par O_DIRECT
+
+// Sortie des n flux de parts dans n fichiers : les octets sont regroupés dans des tampons alignés, et chaque
+// tampon plein part dans les n fichiers en une seule soumission io_uring ; repli sur pwrite sans io_uring
+class file_sink : public stream_sink
+{
+public:
+    file_sink();
+    ~file_sink();
+
+    // Fonction qui crée les fichiers ; avec direct, ils sont ouverts en O_DIRECT si le système de fichiers l'accepte
+    // Avec resumeOffset non nul, les fichiers existants sont gardés jusqu'à cette position et l'écriture continue à la suite
+    bool open(const std::vector<std::string> & paths, bool direct, unsigned long long resumeOffset);
+
+    bool append(const unsigned char * data, size_t stride, size_t length);
+    bool sync();
+    bool finish();
+
+    // Indique si les écritures passent par io_uring
+    bool uses_uring() const { return ring_ >= 0; }
+
+private:
+    file_sink(const file_sink &);
+    file_sink & operator=(const file_sink &);
+
+    unsigned char * buffer(int set, int file) { return buffers_ + ((size_t) set * fds_.size() + file) * SINK_STAGE_BYTES; }
+    bool setup_ring();
+    void close_ring();
+    bool flush();
+    void submit(int set);
+    void reap(bool wait);
+    bool wait_set(int set);
+    bool write_sync(int file, const unsigned char * data, size_t length, unsigned long long offset);
+    bool read_sync(int file, unsigned char * data, size_t length, unsigned long long offset);
+    void set_direct(int file, bool direct);
+
+    std::vector<int> fds_;
+    bool direct_;
+    bool failed_;
+    unsigned char * buffers_;       // Deux jeux de n tampons : l'un se remplit pendant que l'autre s'écrit
+    int current_;                   // Jeu en cours de remplissage
+    size_t fill_;                   // Octets du jeu courant
+    unsigned long long offset_;     // Position dans les fichiers du début du jeu courant
+    unsigned long long setOffset_[2];
+    size_t setLength_[2];
+    int pending_[2];                // Ecritures du jeu en attente de complétion
+
+    // Anneaux io_uring projetés en mémoire
+    int ring_;
+    void * rings_;                  // Anneaux de soumission et de complétion (une seule projection)
+    size_t ringsSize_;
+    void * sqes_;
+    size_t sqesSize_;
+    unsigned * sqTail_;
+    unsigned * sqMask_;
+    unsigned * sqArray_;
+    unsigned * cqHead_;
+    unsigned * cqTail_;
+    unsigned * cqMask_;
+    void * cqes_;
+};
+
+#endif
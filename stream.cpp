@@ -0,0 +1,1516 @@
+#include "stream.h"
+#include "crc32c.h"
+#include "gf256.h"
+#include "queue.h"
+#include "bytes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#include <openssl/rand.h>
+#include <zlib.h>
+
+/*
+ * Partage en flux : l'entrée est lue par morceaux de taille fixe, chaque octet est un secret de GF(2^8)
+ * partagé par un polynome de degré k-1 dont il est le coefficient k-1 (comme dans generate_coefficients).
+ * Les k-1 autres coefficients de tous les octets d'un morceau forment k-1 plans aléatoires tirés d'un flot
+ * AES-256-CTR (clé aléatoire propre au partage, compteur dérivé de l'indice du morceau).
+ * La part d'abscisse x d'un morceau est alors la somme des x^j * plan_j, calculée par les noyaux de gf256.
+ *
+ * Un thread lit l'entrée, un groupe de workers (un par coeur) calcule les parts de morceaux entiers dans
+ * n'importe quel ordre et le thread appelant les écrit dans l'ordre grâce à une file de réordonnancement.
+ * Les morceaux circulent dans un jeu fixe de tampons (workers + STREAM_SLOTS) recyclés par une file bornée :
+ * la lecture attend qu'un tampon soit écrit et la mémoire reste bornée, quelle que soit la taille de l'entrée.
+ * Un tampon porte le morceau et ses n parts : avec beaucoup de parts ou de grands morceaux, le nombre de
+ * tampons, puis de workers, est réduit pour que l'ensemble tienne dans STREAM_MEMORY_BUDGET (au moins deux).
+ *
+ * Compression : les parts sont aléatoires et ne se compressent pas, un étage optionnel compresse donc chaque
+ * morceau (deflate) avant le partage, dans le worker qui le partage ensuite. Un morceau qui
+ * ne gagne pas assez est partagé tel quel, et après un tel échec seul un morceau sur STREAM_PROBE_INTERVAL est
+ * essayé jusqu'au prochain succès : une entrée déjà compressée ne coûte presque rien. La taille compressée
+ * de chaque morceau est visible par chaque détenteur de part : elle laisse fuir une information sur le contenu.
+ *
+ * Format d'un flux de parts : en-tête (magic, version, k, n, x, taille des morceaux, options, identifiant du partage) puis, pour
+ * chaque morceau, son indice sur 8 octets, la taille de la part sur 4 octets, la taille du morceau
+ * décompressé sur 4 octets, le codec sur 4 octets, l'étiquette d'authentification sur 16 octets, le CRC-32C
+ * de l'enregistrement (la part puis ses 36 premiers octets) sur 4 octets et la part. Un enregistrement de
+ * taille nulle termine le flux : un flux tronqué est ainsi détecté à la reconstruction.
+ *
+ * Intégrité : le CRC-32C de chaque part est calculé par l'instruction crc32 de SSE4.2 (voir crc32c) tuile
+ * par tuile, pendant le calcul des parts au partage et pendant la reconstruction, tant que la tuile est dans
+ * le cache : il détecte les erreurs de stockage pour un coût négligeable. Il ne protège pas d'une
+ * modification volontaire ; avec une clé (option STREAM_FLAG_MAC de l'en-tête), l'étiquette est le
+ * HMAC-SHA256 tronqué de l'identifiant du partage et de l'enregistrement (ses 20 premiers octets, l'abscisse
+ * de la part et la part), vérifié avant tout usage de la part. L'identifiant, tiré au hasard à chaque partage et
+ * à chaque mise à jour, empêche de mêler des enregistrements de deux partages faits avec la même clé ou de
+ * remettre un enregistrement d'avant une mise à jour. L'algorithme HMAC est cherché une fois pour le processus
+ * et chaque thread réinitialise son propre contexte pour chaque enregistrement.
+ * Après la fin du flux vient un index : pour chaque morceau, sa position dans l'entrée sur 8 octets, la
+ * position de son enregistrement dans le fichier sur 8 octets, la taille de la part et celle du morceau
+ * décompressé sur 4 octets chacune, puis une fin de
+ * fichier de taille fixe (nombre d'entrées, position de l'index, CRC-32 de l'index et magic). L'index est le
+ * même pour toutes les parts : il permet de lire une plage de l'entrée sans parcourir les fichiers.
+ *
+ * Mise à jour : le partage étant linéaire et chaque morceau partagé avec son propre aléa, un morceau
+ * modifié peut être partagé à nouveau seul, sans toucher aux parts des autres morceaux. La carte des
+ * morceaux (empreinte SHA-256 de chaque morceau, gardée par le dealer car elle dépend du contenu) désigne
+ * les morceaux modifiés ; leurs enregistrements sont réécrits sur place dans les n fichiers.
+ *
+ * La reconstruction lit k flux en parallèle et calcule chaque morceau avec les poids de Lagrange des k
+ * abscisses, calculés une seule fois, avec le même groupe de workers et la même remise en ordre. Chaque
+ * enregistrement est vérifié avant usage et, si plus de k flux sont fournis, les flux supplémentaires doivent
+ * coïncider avec le polynome reconstruit : la reconstruction s'arrête au premier morceau altéré ou incohérent.
+ */
+
+#define STREAM_MAGIC "TP7S"
+#define STREAM_INDEX_MAGIC "TP7I"
+#define STREAM_MAP_MAGIC "TP7M"
+#define STREAM_MAP_VERSION 1
+#define STREAM_VERSION 6
+#define STREAM_HEADER_BYTES 32
+#define STREAM_RECORD_BYTES 40
+#define STREAM_TAG_BYTES 16
+#define STREAM_INDEX_ENTRY_BYTES 24
+#define STREAM_TRAILER_BYTES 24
+#define STREAM_TILE 8192
+#define STREAM_PROBE_INTERVAL 16 // Après un morceau incompressible, un morceau sur STREAM_PROBE_INTERVAL est essayé
+
+// Fonction qui code l'en-tête d'un flux de parts sur STREAM_HEADER_BYTES octets
+static void stream_encode_header(unsigned char * bytes, const stream_header & header)
+{
+    memcpy(bytes, STREAM_MAGIC, 4);
+    store_uint(bytes + 4, header.version, 1);
+    store_uint(bytes + 5, header.k, 1);
+    store_uint(bytes + 6, header.n, 1);
+    store_uint(bytes + 7, header.x, 1);
+    store_uint(bytes + 8, header.chunkSize, 4);
+    store_uint(bytes + 12, header.flags, 4);
+    memcpy(bytes + 16, header.splitId, STREAM_SPLIT_ID_BYTES);
+}
+
+// Fonctions d'écriture et de lecture de l'en-tête d'un flux de parts
+bool stream_write_header(std::ostream & out, const stream_header & header)
+{
+    unsigned char bytes[STREAM_HEADER_BYTES];
+    stream_encode_header(bytes, header);
+    out.write((const char *) bytes, STREAM_HEADER_BYTES);
+    return out.good();
+}
+
+bool stream_read_header(stream_header & header, std::istream & in)
+{
+    unsigned char bytes[STREAM_HEADER_BYTES];
+    in.read((char *) bytes, STREAM_HEADER_BYTES);
+    if (!in || memcmp(bytes, STREAM_MAGIC, 4) != 0) {
+        return false;
+    }
+
+    header.version = load_uint(bytes + 4, 1);
+    header.k = load_uint(bytes + 5, 1);
+    header.n = load_uint(bytes + 6, 1);
+    header.x = load_uint(bytes + 7, 1);
+    header.chunkSize = load_uint(bytes + 8, 4);
+    header.flags = load_uint(bytes + 12, 4);
+    memcpy(header.splitId, bytes + 16, STREAM_SPLIT_ID_BYTES);
+
+    return header.version == STREAM_VERSION && header.k >= 1 && header.k <= header.n && header.x != 0 && header.chunkSize != 0
+        && header.chunkSize <= STREAM_MAX_CHUNK && (header.flags & ~STREAM_FLAG_MAC) == 0;
+}
+
+// Fonction qui remplit les plans aléatoires du morceau index avec le flot AES-256-CTR de la clé
+static bool stream_random_planes(unsigned char * planes, size_t size, const unsigned char * key, unsigned long long index)
+{
+    // Compteur initial : indice du morceau sur les 8 premiers octets, compteur de blocs sur les 8 suivants
+    unsigned char iv[16] = { 0 };
+    for (int b = 0; b < 8; b++) {
+        iv[b] = (unsigned char) (index >> (56 - 8 * b));
+    }
+
+    if (size == 0) {
+        return true;
+    }
+    memset(planes, 0, size);
+
+    EVP_CIPHER_CTX * ctx = EVP_CIPHER_CTX_new();
+    bool ok = ctx != NULL && EVP_EncryptInit_ex(ctx, EVP_aes_256_ctr(), NULL, key, iv) == 1;
+
+    // Le flot chiffre des zéros, par paquets car EVP_EncryptUpdate prend une taille de type int
+    for (size_t offset = 0; ok && offset < size; offset += (1 << 30))
+    {
+        int length = std::min((size_t) (1 << 30), size - offset);
+        int written = 0;
+        ok = EVP_EncryptUpdate(ctx, planes + offset, &written, planes + offset, length) == 1;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+    return ok;
+}
+
+// Fonction qui calcule les parts d'un morceau de length octets dans GF(2^8) : shares[i] reçoit la part d'abscisse i + 1
+// planes contient les k-1 plans aléatoires de length octets (les coefficients 0 ... k-2), data est le coefficient k-1
+// Si checksums n'est pas nul, checksums[i] reçoit le CRC-32C de la part i, calculé tuile par tuile
+void stream_compute_shares(unsigned char ** shares, const unsigned char * data, const unsigned char * planes, size_t length, int k, int n,
+                           unsigned int * checksums)
+{
+    std::vector<unsigned char> powers(k);
+    std::vector<const unsigned char *> tiles(n);
+    if (checksums != NULL) {
+        std::fill(checksums, checksums + n, 0);
+    }
+
+    for (size_t offset = 0; offset < length; offset += STREAM_TILE)
+    {
+        size_t size = std::min((size_t) STREAM_TILE, length - offset);
+
+        for (int i = 0; i < n; i++)
+        {
+            // x^j pour x = i + 1
+            powers[0] = 1;
+            for (int j = 1; j < k; j++) {
+                powers[j] = gf256_mul(powers[j - 1], i + 1);
+            }
+
+            gf256_region_mul(shares[i] + offset, data + offset, powers[k - 1], size);
+            for (int j = 0; j < k - 1; j++) {
+                gf256_region_muladd(shares[i] + offset, planes + j * length + offset, powers[j], size);
+            }
+            tiles[i] = shares[i] + offset;
+        }
+
+        if (checksums != NULL) {
+            crc32c_multi(checksums, tiles.data(), n, size);
+        }
+    }
+}
+
+// Fonction qui calcule le morceau (coefficient k-1) à partir de k parts et des poids de stream_lagrange_weights
+// Si checksums n'est pas nul, checksums[i] reçoit le CRC-32C de la part i, calculé sur chaque tuile juste après son usage
+void stream_reconstruct_chunk(unsigned char * data, const unsigned char * const * shares, const unsigned char * weights, size_t length, int k,
+                              unsigned int * checksums)
+{
+    std::vector<const unsigned char *> tiles(k);
+    if (checksums != NULL) {
+        std::fill(checksums, checksums + k, 0);
+    }
+
+    for (size_t offset = 0; offset < length; offset += STREAM_TILE)
+    {
+        size_t size = std::min((size_t) STREAM_TILE, length - offset);
+
+        gf256_region_mul(data + offset, shares[0] + offset, weights[0], size);
+        for (int i = 1; i < k; i++) {
+            gf256_region_muladd(data + offset, shares[i] + offset, weights[i], size);
+        }
+
+        if (checksums != NULL)
+        {
+            for (int i = 0; i < k; i++) {
+                tiles[i] = shares[i] + offset;
+            }
+            crc32c_multi(checksums, tiles.data(), k, size);
+        }
+    }
+}
+
+// Fonction qui calcule les poids de Lagrange des k abscisses dans GF(2^8)
+// Avec at = 0, weights[i] = 1 / produit des (x[i] - x[j]) donne le coefficient k-1 (le secret, comme compute_lagrange_coefficients)
+// Avec at != 0, weights[i] = L_i(at) donne la valeur du polynome en at
+void stream_lagrange_weights(unsigned char * weights, const int * x, int k, int at)
+{
+    for (int i = 0; i < k; i++)
+    {
+        unsigned char denominator = 1, numerator = 1;
+        for (int j = 0; j < k; j++)
+        {
+            if (j != i) {
+                denominator = gf256_mul(denominator, x[i] ^ x[j]);
+                numerator = gf256_mul(numerator, at ^ x[j]);
+            }
+        }
+        weights[i] = gf256_inv(denominator);
+        if (at != 0) {
+            weights[i] = gf256_mul(weights[i], numerator);
+        }
+    }
+}
+
+// Fonction qui donne le nombre de workers du partage et de la reconstruction : un par coeur
+static int stream_worker_count()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Fonction qui donne le nombre de tampons d'un partage ou d'une reconstruction sur streams flux de parts, et leur nombre
+// de workers : un worker par coeur et STREAM_SLOTS tampons de plus, réduits pour tenir dans STREAM_MEMORY_BUDGET
+// Renvoie 0 si deux tampons n'y tiennent pas
+static int stream_slot_count(size_t chunkSize, int streams, int & workers)
+{
+    unsigned long long slotBytes = (streams + 2ULL) * (chunkSize + STREAM_RECORD_BYTES);
+    unsigned long long fit = STREAM_MEMORY_BUDGET / slotBytes;
+    workers = stream_worker_count();
+    if (chunkSize == 0 || chunkSize > STREAM_MAX_CHUNK || fit < 2) {
+        return 0;
+    }
+    int slotCount = std::min(fit, (unsigned long long) workers + STREAM_SLOTS);
+    workers = std::max(1, std::min(workers, slotCount - STREAM_SLOTS));
+    return slotCount;
+}
+
+// Fonction qui indique si deux morceaux de chunkSize octets répartis sur streams flux de parts tiennent dans STREAM_MEMORY_BUDGET
+bool stream_chunk_fits(size_t chunkSize, int streams)
+{
+    int workers;
+    return stream_slot_count(chunkSize, streams, workers) != 0;
+}
+
+// Fonction qui calcule l'empreinte SHA-256 d'un morceau pour la carte des morceaux
+static bool stream_digest(unsigned char * digest, const unsigned char * data, size_t length)
+{
+    return EVP_Digest(data, length, digest, NULL, EVP_sha256(), NULL) == 1;
+}
+
+// Fonction qui compresse un morceau dans packed (au plus length octets)
+// Renvoie le codec retenu : STREAM_CODEC_NONE si le gain est insuffisant, le morceau est alors partagé tel quel
+static int stream_pack(unsigned char * packed, size_t & packedLength, const unsigned char * data, size_t length)
+{
+    // Au moins 1/32 de gain, sinon la décompression ne vaut pas la peine
+    uLongf size = length - length / 32;
+    if (compress2(packed, &size, data, length, Z_BEST_SPEED) != Z_OK || size >= length - length / 32) {
+        return STREAM_CODEC_NONE;
+    }
+    packedLength = size;
+    return STREAM_CODEC_DEFLATE;
+}
+
+// Fonction qui décompresse un morceau de length octets ; les octets qui suivent la fin du flux deflate sont ignorés
+static bool stream_unpack(unsigned char * data, size_t length, const unsigned char * packed, size_t packedLength, int codec)
+{
+    if (codec != STREAM_CODEC_DEFLATE) {
+        return false;
+    }
+    uLongf size = length;
+    return uncompress(data, &size, packed, packedLength) == Z_OK && size == length;
+}
+
+// Fonction qui termine le CRC-32C d'un enregistrement à partir de celui de la part : la part puis les 36 premiers octets
+static unsigned int stream_record_checksum(const unsigned char * record, unsigned int shareChecksum)
+{
+    return crc32c(shareChecksum, record, 36);
+}
+
+// Fonction qui donne l'algorithme HMAC, cherché une seule fois pour tout le processus
+static EVP_MAC * stream_hmac()
+{
+    static EVP_MAC * algorithm = EVP_MAC_fetch(NULL, "HMAC", NULL);
+    return algorithm;
+}
+
+// Contexte des étiquettes d'un thread : créé une fois avec la clé et l'identifiant du partage, il est réinitialisé
+// par EVP_MAC_init pour chaque enregistrement ; sans clé, les étiquettes sont nulles
+class stream_mac
+{
+public:
+    stream_mac(const unsigned char * key, const unsigned char * splitId) : ctx_(NULL), enabled_(key != NULL)
+    {
+        memcpy(splitId_, splitId, STREAM_SPLIT_ID_BYTES);
+        OSSL_PARAM params[] = { OSSL_PARAM_construct_utf8_string("digest", (char *) "SHA256", 0), OSSL_PARAM_construct_end() };
+        if (enabled_ && stream_hmac() != NULL && (ctx_ = EVP_MAC_CTX_new(stream_hmac())) != NULL
+            && EVP_MAC_init(ctx_, key, STREAM_MAC_KEY_BYTES, params) != 1)
+        {
+            EVP_MAC_CTX_free(ctx_);
+            ctx_ = NULL;
+        }
+    }
+
+    ~stream_mac() { EVP_MAC_CTX_free(ctx_); }
+
+    // Sans clé, ou avec un contexte utilisable
+    bool ready() const { return !enabled_ || ctx_ != NULL; }
+    bool enabled() const { return enabled_; }
+
+    // Fonction qui calcule l'étiquette d'un enregistrement : HMAC-SHA256 tronqué de l'identifiant du partage, des 20 premiers
+    // octets de l'enregistrement, de l'abscisse et de la part
+    bool tag(unsigned char * tag, const unsigned char * record, int x, const unsigned char * share, size_t length)
+    {
+        unsigned char abscissa = x;
+        unsigned char full[32] = { 0 };
+        size_t size = 0;
+        bool ok = ctx_ != NULL && EVP_MAC_init(ctx_, NULL, 0, NULL) == 1 && EVP_MAC_update(ctx_, splitId_, STREAM_SPLIT_ID_BYTES) == 1
+            && EVP_MAC_update(ctx_, record, 20) == 1 && EVP_MAC_update(ctx_, &abscissa, 1) == 1
+            && (length == 0 || EVP_MAC_update(ctx_, share, length) == 1) && EVP_MAC_final(ctx_, full, &size, sizeof(full)) == 1;
+        memcpy(tag, full, STREAM_TAG_BYTES);
+        return ok;
+    }
+
+private:
+    stream_mac(const stream_mac &);
+    stream_mac & operator=(const stream_mac &);
+
+    EVP_MAC_CTX * ctx_;
+    bool enabled_;
+    unsigned char splitId_[STREAM_SPLIT_ID_BYTES];
+};
+
+// Fonction qui prépare l'en-tête d'enregistrement de la part d'abscisse x d'un morceau
+// shareChecksum est le CRC-32C de la part ; sans clé, l'étiquette est nulle
+static bool stream_make_record(unsigned char * record, unsigned long long index, const unsigned char * share, size_t length,
+                               size_t plainLength, int codec, int x, stream_mac & mac, unsigned int shareChecksum)
+{
+    memset(record, 0, STREAM_RECORD_BYTES);
+    store_uint(record, index, 8);
+    store_uint(record + 8, length, 4);
+    store_uint(record + 12, plainLength, 4);
+    store_uint(record + 16, codec, 4);
+
+    bool ok = !mac.enabled() || mac.tag(record + 20, record, x, share, length);
+    store_uint(record + 36, stream_record_checksum(record, shareChecksum), 4);
+    return ok;
+}
+
+// Fonction qui vérifie l'enregistrement de la part d'abscisse x à partir du CRC-32C de la part, puis son étiquette avec une clé
+static int stream_check_record(const unsigned char * record, const unsigned char * share, size_t length, int x, stream_mac & mac,
+                               unsigned int shareChecksum)
+{
+    if (load_uint(record + 36, 4) != stream_record_checksum(record, shareChecksum)) {
+        return STREAM_ERROR_CHECKSUM;
+    }
+
+    unsigned char tag[STREAM_TAG_BYTES];
+    if (mac.enabled() && (!mac.tag(tag, record, x, share, length) || CRYPTO_memcmp(tag, record + 20, STREAM_TAG_BYTES) != 0)) {
+        return STREAM_ERROR_AUTH;
+    }
+    return STREAM_OK;
+}
+
+// Fonction qui vérifie les enregistrements des count parts d'un morceau après stream_reconstruct_chunk
+// checksums contient déjà le CRC-32C des k premières parts ; celui des parts de vérification est calculé ici
+static int stream_check_records(const unsigned char * records, const unsigned char * const * shares, size_t length, const int * x, int count, int k,
+                                stream_mac & mac, unsigned int * checksums)
+{
+    std::fill(checksums + k, checksums + count, 0);
+    crc32c_multi(checksums + k, shares + k, count - k, length);
+
+    for (int i = 0; i < count; i++)
+    {
+        int error = stream_check_record(records + i * STREAM_RECORD_BYTES, shares[i], length, x[i], mac, checksums[i]);
+        if (error != STREAM_OK) {
+            return error;
+        }
+    }
+    return STREAM_OK;
+}
+
+// Fonction qui vérifie la cohérence des tailles et du codec d'un enregistrement
+static bool stream_valid_record(const unsigned char * record, size_t chunkSize)
+{
+    size_t length = load_uint(record + 8, 4), plainLength = load_uint(record + 12, 4);
+    int codec = load_uint(record + 16, 4);
+    if (length > chunkSize || plainLength > chunkSize || (length == 0) != (plainLength == 0)) {
+        return false;
+    }
+    return (codec == STREAM_CODEC_NONE && length == plainLength) || (codec == STREAM_CODEC_DEFLATE && length < plainLength);
+}
+
+// Fonction qui code l'index des morceaux suivi de la fin de fichier qui le désigne
+static void stream_encode_index(std::vector<unsigned char> & bytes, const std::vector<stream_index_entry> & index, unsigned long long indexOffset)
+{
+    bytes.assign(index.size() * STREAM_INDEX_ENTRY_BYTES + STREAM_TRAILER_BYTES, 0);
+    for (size_t c = 0; c < index.size(); c++)
+    {
+        unsigned char * entry = bytes.data() + c * STREAM_INDEX_ENTRY_BYTES;
+        store_uint(entry, index[c].plainOffset, 8);
+        store_uint(entry + 8, index[c].fileOffset, 8);
+        store_uint(entry + 16, index[c].length, 4);
+        store_uint(entry + 20, index[c].plainLength, 4);
+    }
+
+    size_t size = index.size() * STREAM_INDEX_ENTRY_BYTES;
+    unsigned char * trailer = bytes.data() + size;
+    store_uint(trailer, index.size(), 8);
+    store_uint(trailer + 8, indexOffset, 8);
+    store_uint(trailer + 16, crc32c(0, bytes.data(), size), 4);
+    memcpy(trailer + 20, STREAM_INDEX_MAGIC, 4);
+}
+
+// Fonction qui écrit l'index des morceaux et la fin de fichier qui le désigne
+static bool stream_write_index(std::ostream & out, const std::vector<stream_index_entry> & index, unsigned long long indexOffset)
+{
+    std::vector<unsigned char> bytes;
+    stream_encode_index(bytes, index, indexOffset);
+    out.write((const char *) bytes.data(), bytes.size());
+    return out.good();
+}
+
+// Fonction qui lit l'index de fin d'un fichier de parts (le flux doit permettre le déplacement)
+bool stream_read_index(std::vector<stream_index_entry> & index, std::istream & in)
+{
+    in.seekg(0, std::ios::end);
+    std::streamoff size = in.tellg();
+    if (!in || size < STREAM_HEADER_BYTES + STREAM_RECORD_BYTES + STREAM_TRAILER_BYTES) {
+        return false;
+    }
+
+    unsigned char trailer[STREAM_TRAILER_BYTES];
+    in.seekg(size - STREAM_TRAILER_BYTES);
+    in.read((char *) trailer, STREAM_TRAILER_BYTES);
+    if (!in || memcmp(trailer + 20, STREAM_INDEX_MAGIC, 4) != 0) {
+        return false;
+    }
+
+    // L'index doit occuper exactement l'espace entre la fin du flux et la fin de fichier
+    unsigned long long count = load_uint(trailer, 8);
+    unsigned long long indexOffset = load_uint(trailer + 8, 8);
+    unsigned long long end = size - STREAM_TRAILER_BYTES;
+    if (indexOffset < STREAM_HEADER_BYTES + STREAM_RECORD_BYTES || indexOffset > end || (end - indexOffset) / STREAM_INDEX_ENTRY_BYTES != count
+        || (end - indexOffset) % STREAM_INDEX_ENTRY_BYTES != 0) {
+        return false;
+    }
+
+    std::vector<unsigned char> bytes(end - indexOffset);
+    in.seekg(indexOffset);
+    in.read((char *) bytes.data(), bytes.size());
+    if (!in || load_uint(trailer + 16, 4) != crc32c(0, bytes.data(), bytes.size())) {
+        return false;
+    }
+
+    // Les morceaux se suivent dans l'entrée et dans le fichier
+    index.resize(count);
+    unsigned long long plainOffset = 0, fileOffset = STREAM_HEADER_BYTES;
+    for (size_t c = 0; c < count; c++)
+    {
+        const unsigned char * entry = bytes.data() + c * STREAM_INDEX_ENTRY_BYTES;
+        index[c].plainOffset = load_uint(entry, 8);
+        index[c].fileOffset = load_uint(entry + 8, 8);
+        index[c].length = load_uint(entry + 16, 4);
+        index[c].plainLength = load_uint(entry + 20, 4);
+        if (index[c].plainOffset != plainOffset || index[c].fileOffset < fileOffset || index[c].length == 0 || index[c].plainLength == 0) {
+            return false;
+        }
+        plainOffset += index[c].plainLength;
+        fileOffset = index[c].fileOffset + STREAM_RECORD_BYTES + index[c].length;
+    }
+    return fileOffset + STREAM_RECORD_BYTES <= indexOffset;
+}
+
+// Morceau en vol dans le pipeline
+struct stream_slot
+{
+    unsigned long long index;           // Indice du morceau dans l'entrée
+    size_t length;                      // Taille du morceau, 0 pour la fin du flux
+    int codec;                          // Codec du morceau partagé
+    size_t packedLength;                // Taille du morceau compressé
+    std::vector<unsigned char> data;    // Morceau de l'entrée
+    std::vector<unsigned char> packed;  // Morceau compressé
+    std::vector<unsigned char> shares;  // n parts de chunkSize octets
+    std::vector<unsigned char> records; // n en-têtes d'enregistrement
+    std::vector<unsigned int> checksums; // CRC-32C des n parts
+    unsigned char digest[STREAM_DIGEST_BYTES]; // Empreinte du morceau pour la carte des morceaux
+};
+
+// Fonction qui passe les octets de l'entrée partagés avant la reprise ; digests reçoit leurs empreintes s'il n'est pas nul
+static bool stream_skip_input(std::istream & input, const stream_state & state, size_t chunkSize, std::vector<unsigned char> * digests)
+{
+    // Sans carte des morceaux, un fichier est directement positionné ; un tube est lu jusqu'au point de reprise
+    if (digests == NULL)
+    {
+        input.seekg(state.plainOffset);
+        if (input) {
+            return true;
+        }
+        input.clear();
+    }
+
+    std::vector<unsigned char> data(chunkSize);
+    unsigned char digest[STREAM_DIGEST_BYTES];
+    unsigned long long remaining = state.plainOffset;
+    for (unsigned long long c = 0; c < state.chunks; c++)
+    {
+        size_t length = std::min((unsigned long long) chunkSize, remaining);
+        input.read((char *) data.data(), length);
+        if ((size_t) input.gcount() != length) {
+            return false;
+        }
+        if (digests != NULL)
+        {
+            if (!stream_digest(digest, data.data(), length)) {
+                return false;
+            }
+            digests->insert(digests->end(), digest, digest + STREAM_DIGEST_BYTES);
+        }
+        remaining -= length;
+    }
+    return remaining == 0;
+}
+
+// Fonction qui relit les enregistrements des morceaux écrits avant un point de reprise dans un fichier de parts
+// Seuls les en-têtes d'enregistrement sont lus : les parts elles-mêmes sont vérifiées à la reconstruction
+bool stream_scan_records(std::vector<stream_index_entry> & index, std::istream & in, const stream_state & state)
+{
+    stream_header header;
+    if (!stream_read_header(header, in) || header.k != state.header.k || header.n != state.header.n || header.chunkSize != state.header.chunkSize
+        || header.flags != state.header.flags || memcmp(header.splitId, state.header.splitId, STREAM_SPLIT_ID_BYTES) != 0) {
+        return false;
+    }
+
+    index.clear();
+    unsigned long long plainOffset = 0, fileOffset = STREAM_HEADER_BYTES;
+    unsigned char record[STREAM_RECORD_BYTES];
+    for (unsigned long long c = 0; c < state.chunks; c++)
+    {
+        in.seekg(fileOffset);
+        in.read((char *) record, STREAM_RECORD_BYTES);
+        if (!in || !stream_valid_record(record, header.chunkSize) || load_uint(record, 8) != c || load_uint(record + 8, 4) == 0) {
+            return false;
+        }
+
+        stream_index_entry entry = { plainOffset, fileOffset, (unsigned int) load_uint(record + 8, 4), (unsigned int) load_uint(record + 12, 4) };
+        index.push_back(entry);
+        plainOffset += entry.plainLength;
+        fileOffset += STREAM_RECORD_BYTES + entry.length;
+    }
+    return plainOffset == state.plainOffset && fileOffset == state.fileOffset;
+}
+
+// Fonction qui partage un flux de taille quelconque en n flux de parts avec une mémoire bornée
+// Le flux i de sink reçoit la part d'abscisse i + 1 ; sink est terminé (finish) en fin de partage
+// Si digests n'est pas nul, il reçoit la carte des morceaux (empreinte de chaque morceau) pour stream_update
+// Avec compress, chaque morceau est compressé avant d'être partagé quand il y gagne
+// Si macKey n'est pas nul, les enregistrements sont authentifiés avec cette clé de STREAM_MAC_KEY_BYTES octets
+// Si checkpoint n'est pas nul, l'état est enregistré au début puis tous les STREAM_CHECKPOINT_BYTES octets écrits
+// Si resume n'est pas nul, le partage reprend après ses morceaux ; la clé des plans aléatoires n'est jamais
+// enregistrée, les morceaux suivants sont partagés avec une nouvelle clé
+bool stream_split(std::istream & input, stream_sink & sink, int k, int n, size_t chunkSize, bool compress,
+                  std::vector<unsigned char> * digests, const unsigned char * macKey, stream_checkpoint * checkpoint,
+                  const stream_state * resume, const std::vector<stream_index_entry> * resumeIndex)
+{
+    int workers;
+    int slotCount = stream_slot_count(chunkSize, n, workers);
+    if (k < 1 || k > n || n > 255 || slotCount == 0) {
+        return false;
+    }
+
+    // Un partage repris garde ses paramètres
+    unsigned int flags = macKey != NULL ? STREAM_FLAG_MAC : 0u;
+    if (resume != NULL && (resumeIndex == NULL || resumeIndex->size() != resume->chunks || resume->header.k != k || resume->header.n != n
+                           || resume->header.chunkSize != chunkSize || resume->header.flags != flags || resume->compress != compress)) {
+        return false;
+    }
+
+    stream_state state;
+    if (resume != NULL) {
+        state = *resume;
+    } else {
+        stream_header header = { STREAM_VERSION, k, n, 0, (unsigned int) chunkSize, flags, { 0 } };
+        state.header = header;
+        state.compress = compress;
+        state.chunks = state.plainOffset = 0;
+        state.fileOffset = STREAM_HEADER_BYTES;
+        if (RAND_bytes(state.header.splitId, STREAM_SPLIT_ID_BYTES) != 1) {
+            return false;
+        }
+    }
+    unsigned char key[STREAM_KEY_BYTES];
+    if (RAND_bytes(key, STREAM_KEY_BYTES) != 1) {
+        return false;
+    }
+    unsigned long long firstChunk = state.chunks;
+
+    std::vector<stream_index_entry> index;
+    if (digests != NULL) {
+        digests->clear();
+    }
+    bool ok = true;
+    if (resume != NULL) {
+        index = *resumeIndex;
+        ok = stream_skip_input(input, state, chunkSize, digests);
+    } else {
+        // Les n en-têtes ne diffèrent que par l'abscisse
+        std::vector<unsigned char> headers(n * STREAM_HEADER_BYTES);
+        for (int i = 0; i < n; i++)
+        {
+            state.header.x = i + 1;
+            stream_encode_header(headers.data() + i * STREAM_HEADER_BYTES, state.header);
+        }
+        state.header.x = 0;
+        ok = sink.append(headers.data(), STREAM_HEADER_BYTES, STREAM_HEADER_BYTES)
+            && (checkpoint == NULL || (sink.sync() && checkpoint->save(state)));
+    }
+    if (!ok) {
+        OPENSSL_cleanse(key, STREAM_KEY_BYTES);
+        return false;
+    }
+
+    // Morceaux en vol : les workers plus STREAM_SLOTS en lecture ou en attente d'écriture, dans le budget mémoire
+    std::vector<stream_slot> slots(slotCount);
+    blocking_queue<int> freeSlots(slotCount), toCompute(slotCount);
+    ordered_queue<int> toWrite(firstChunk);
+    for (int s = 0; s < slotCount; s++)
+    {
+        slots[s].data.resize(chunkSize);
+        slots[s].packed.resize(compress ? chunkSize : 0);
+        slots[s].shares.resize(n * chunkSize);
+        slots[s].records.resize(n * STREAM_RECORD_BYTES);
+        slots[s].checksums.resize(n);
+        freeSlots.push(s);
+    }
+
+    std::atomic<bool> failed(false);
+    std::atomic<int> skip(0);
+
+    // Lecture : remplit les morceaux libres, un morceau vide marque la fin
+    std::thread reader([&]() {
+        int s;
+        unsigned long long index = firstChunk;
+        while (freeSlots.pop(s))
+        {
+            input.read((char *) slots[s].data.data(), chunkSize);
+            slots[s].index = index++;
+            slots[s].length = input.gcount();
+
+            if (input.bad()) {
+                failed = true;
+                slots[s].length = 0;
+            }
+
+            // Le morceau appartient au thread suivant dès qu'il est en file : on ne le relit plus ensuite
+            bool last = slots[s].length == 0;
+            if (!toCompute.push(s) || last) {
+                break;
+            }
+            if (input.eof())
+            {
+                // Dernier morceau partiel : on envoie aussi la fin du flux
+                if (freeSlots.pop(s)) {
+                    slots[s].index = index;
+                    slots[s].length = 0;
+                    toCompute.push(s);
+                }
+                break;
+            }
+        }
+        // Les workers vident la file puis s'arrêtent
+        toCompute.close();
+    });
+
+    // Compression et calcul des parts : chaque worker traite un morceau entier, dans n'importe quel ordre
+    std::vector<std::thread> pool;
+    for (int w = 0; w < workers; w++)
+    {
+        pool.push_back(std::thread([&]() {
+            std::vector<unsigned char> planes((k - 1) * chunkSize);
+            std::vector<unsigned char *> shares(n);
+            stream_mac mac(macKey, state.header.splitId);
+            if (!mac.ready()) {
+                failed = true;
+            }
+            int s;
+            while (toCompute.pop(s))
+            {
+                stream_slot & slot = slots[s];
+                slot.codec = STREAM_CODEC_NONE;
+                if (slot.length != 0)
+                {
+                    // Après un échec, les morceaux suivants sont partagés sans essai jusqu'à épuisement de skip
+                    int remaining = skip;
+                    if (compress && (remaining == 0 || !skip.compare_exchange_strong(remaining, remaining - 1)))
+                    {
+                        slot.codec = stream_pack(slot.packed.data(), slot.packedLength, slot.data.data(), slot.length);
+                        skip = slot.codec == STREAM_CODEC_NONE ? STREAM_PROBE_INTERVAL - 1 : 0;
+                    }
+
+                    // On partage le morceau compressé s'il l'est
+                    const unsigned char * source = slot.codec == STREAM_CODEC_NONE ? slot.data.data() : slot.packed.data();
+                    size_t length = slot.codec == STREAM_CODEC_NONE ? slot.length : slot.packedLength;
+                    if (!stream_random_planes(planes.data(), (k - 1) * length, key, slot.index)) {
+                        failed = true;
+                    }
+                    for (int i = 0; i < n; i++) {
+                        shares[i] = slot.shares.data() + i * chunkSize;
+                    }
+                    stream_compute_shares(shares.data(), source, planes.data(), length, k, n, slot.checksums.data());
+
+                    for (int i = 0; i < n; i++)
+                    {
+                        if (!stream_make_record(slot.records.data() + i * STREAM_RECORD_BYTES, slot.index, shares[i], length, slot.length,
+                                                slot.codec, i + 1, mac, slot.checksums[i])) {
+                            failed = true;
+                        }
+                    }
+                    if (digests != NULL && !stream_digest(slot.digest, slot.data.data(), slot.length)) {
+                        failed = true;
+                    }
+                }
+
+                if (!toWrite.push(slot.index, s)) {
+                    break;
+                }
+            }
+        }));
+    }
+
+    // Ecriture dans le thread appelant, remise dans l'ordre des morceaux ; les n fichiers ont la même disposition
+    unsigned long long plainOffset = state.plainOffset, fileOffset = state.fileOffset, checkpointOffset = fileOffset;
+    stream_mac mac(macKey, state.header.splitId);
+    if (!mac.ready()) {
+        failed = true;
+    }
+    int s;
+    while (toWrite.pop(s))
+    {
+        stream_slot & slot = slots[s];
+        if (failed) {
+            break;
+        }
+        if (slot.length == 0)
+        {
+            // Enregistrement de fin de flux (l'étiquette dépend de l'abscisse) puis index, identique dans les n flux
+            for (int i = 0; i < n; i++)
+            {
+                if (!stream_make_record(slot.records.data() + i * STREAM_RECORD_BYTES, slot.index, NULL, 0, 0, STREAM_CODEC_NONE, i + 1, mac, 0)) {
+                    failed = true;
+                }
+            }
+            std::vector<unsigned char> bytes;
+            stream_encode_index(bytes, index, fileOffset + STREAM_RECORD_BYTES);
+            if (failed || !sink.append(slot.records.data(), STREAM_RECORD_BYTES, STREAM_RECORD_BYTES) || !sink.append(bytes.data(), 0, bytes.size())) {
+                failed = true;
+            }
+            break;
+        }
+
+        size_t length = slot.codec == STREAM_CODEC_NONE ? slot.length : slot.packedLength;
+        if (!sink.append(slot.records.data(), STREAM_RECORD_BYTES, STREAM_RECORD_BYTES) || !sink.append(slot.shares.data(), chunkSize, length)) {
+            failed = true;
+        }
+
+        stream_index_entry entry = { plainOffset, fileOffset, (unsigned int) length, (unsigned int) slot.length };
+        index.push_back(entry);
+        if (digests != NULL) {
+            digests->insert(digests->end(), slot.digest, slot.digest + STREAM_DIGEST_BYTES);
+        }
+        plainOffset += slot.length;
+        fileOffset += STREAM_RECORD_BYTES + length;
+        freeSlots.push(s);
+
+        // Point de reprise : les morceaux écrits jusqu'ici sont rendus durables avant d'enregistrer l'état
+        if (checkpoint != NULL && fileOffset - checkpointOffset >= STREAM_CHECKPOINT_BYTES)
+        {
+            state.chunks = index.size();
+            state.plainOffset = plainOffset;
+            state.fileOffset = checkpointOffset = fileOffset;
+            if (!sink.sync() || !checkpoint->save(state)) {
+                failed = true;
+            }
+        }
+    }
+
+    // Débloque les autres threads en cas d'arrêt anticipé
+    freeSlots.close();
+    toCompute.close();
+    toWrite.close();
+    reader.join();
+    for (size_t w = 0; w < pool.size(); w++) {
+        pool[w].join();
+    }
+
+    if (!sink.finish()) {
+        failed = true;
+    }
+
+    OPENSSL_cleanse(key, STREAM_KEY_BYTES);
+    return !failed;
+}
+
+// Fonction qui donne le message d'une erreur de reconstruction
+const char * stream_error_string(int error)
+{
+    switch (error)
+    {
+        case STREAM_OK: return "ok";
+        case STREAM_ERROR_IO: return "read or write error";
+        case STREAM_ERROR_FORMAT: return "invalid or incompatible share streams";
+        case STREAM_ERROR_CHECKSUM: return "corrupted share record";
+        case STREAM_ERROR_MISMATCH: return "inconsistent shares";
+        case STREAM_ERROR_TRUNCATED: return "truncated share stream";
+        case STREAM_ERROR_RANGE: return "range outside of the original input";
+        case STREAM_ERROR_AUTH: return "share authentication failed (wrong or missing MAC key)";
+        case STREAM_ERROR_MEMORY: return "chunks too large for the memory budget";
+        default: return "unknown error";
+    }
+}
+
+// Fonction qui lit les en-têtes des flux de parts : mêmes paramètres et même partage, abscisses distinctes et au moins k flux
+static bool stream_read_headers(stream_header & header, std::vector<int> & x, std::vector<std::istream *> & inputs)
+{
+    int count = inputs.size();
+    for (int i = 0; i < count; i++)
+    {
+        stream_header current;
+        if (!stream_read_header(current, *inputs[i])) {
+            return false;
+        }
+        if (i == 0) {
+            header = current;
+        }
+        x[i] = current.x;
+        if (current.k != header.k || current.n != header.n || current.chunkSize != header.chunkSize || current.flags != header.flags
+            || memcmp(current.splitId, header.splitId, STREAM_SPLIT_ID_BYTES) != 0 || std::find(x.begin(), x.begin() + i, x[i]) != x.begin() + i) {
+            return false;
+        }
+    }
+    return count >= 1 && count >= header.k;
+}
+
+// Morceau en vol dans le pipeline de reconstruction
+struct stream_combine_slot
+{
+    unsigned long long index;           // Indice du morceau
+    size_t length;                      // Taille des parts, 0 pour la fin du flux
+    size_t plainLength;                 // Taille du morceau décompressé
+    int codec;                          // Codec du morceau
+    int error;                          // Erreur détectée sur ce morceau
+    std::vector<unsigned char> records; // En-têtes d'enregistrement lus dans chaque flux
+    std::vector<unsigned char> shares;  // Parts lues dans chaque flux (chunkSize octets chacune)
+    std::vector<unsigned char> packed;  // Morceau compressé reconstruit
+    std::vector<unsigned char> data;    // Morceau reconstruit
+};
+
+// Fonction qui vérifie que la clé fournie correspond aux options du flux : une clé si et seulement si les parts sont authentifiées
+static bool stream_key_matches(const stream_header & header, const unsigned char * macKey)
+{
+    return ((header.flags & STREAM_FLAG_MAC) != 0) == (macKey != NULL);
+}
+
+// Fonction qui reconstruit un flux à partir d'au moins k flux de parts, les flux au-delà des k premiers servent à la vérification
+// Renvoie STREAM_OK ou le code d'erreur, failedChunk reçoit alors l'indice du morceau fautif
+// macKey est la clé des parts authentifiées, nul sinon
+// Si checkpoint n'est pas nul, l'état est enregistré tous les STREAM_CHECKPOINT_BYTES octets reconstruits, après output.flush()
+// Si resume n'est pas nul, la lecture des flux reprend à resume->fileOffset : n'importe quel jeu de k parts convient,
+// les enregistrements sont aux mêmes positions dans tous les fichiers
+int stream_combine(std::vector<std::istream *> & inputs, std::ostream & output, unsigned long long & failedChunk, const unsigned char * macKey,
+                   stream_checkpoint * checkpoint, const stream_state * resume)
+{
+    failedChunk = 0;
+    int count = inputs.size();
+
+    stream_header header;
+    std::vector<int> x(count);
+    if (!stream_read_headers(header, x, inputs) || (resume != NULL && (resume->header.k != header.k || resume->header.n != header.n
+        || resume->header.chunkSize != header.chunkSize || resume->header.flags != header.flags
+        || memcmp(resume->header.splitId, header.splitId, STREAM_SPLIT_ID_BYTES) != 0))) {
+        return STREAM_ERROR_FORMAT;
+    }
+    if (!stream_key_matches(header, macKey)) {
+        return STREAM_ERROR_AUTH;
+    }
+    int k = header.k;
+    size_t chunkSize = header.chunkSize;
+
+    stream_state state;
+    if (resume != NULL)
+    {
+        state = *resume;
+        failedChunk = state.chunks;
+        for (int i = 0; i < count; i++)
+        {
+            inputs[i]->seekg(state.fileOffset);
+            if (!*inputs[i]) {
+                return STREAM_ERROR_TRUNCATED;
+            }
+        }
+    } else {
+        memset(&state, 0, sizeof(state));
+        state.header = header;
+        state.header.x = 0;
+        state.fileOffset = STREAM_HEADER_BYTES;
+    }
+    unsigned long long firstChunk = state.chunks, checkpointOffset = state.plainOffset;
+
+    // Poids calculés une fois pour tout le flux : reconstruction puis valeurs attendues des flux supplémentaires
+    std::vector<unsigned char> weights(k), checkWeights((count - k) * k);
+    stream_lagrange_weights(weights.data(), x.data(), k, 0);
+    for (int e = k; e < count; e++) {
+        stream_lagrange_weights(checkWeights.data() + (e - k) * k, x.data(), k, x[e]);
+    }
+
+    int workers;
+    int slotCount = stream_slot_count(chunkSize, count, workers);
+    if (slotCount == 0) {
+        return STREAM_ERROR_MEMORY;
+    }
+    std::vector<stream_combine_slot> slots(slotCount);
+    blocking_queue<int> freeSlots(slotCount), toCompute(slotCount);
+    ordered_queue<int> toWrite(firstChunk);
+    for (int s = 0; s < slotCount; s++)
+    {
+        slots[s].records.resize(count * STREAM_RECORD_BYTES);
+        slots[s].shares.resize(count * chunkSize);
+        slots[s].packed.resize(chunkSize);
+        slots[s].data.resize(chunkSize);
+        freeSlots.push(s);
+    }
+
+    // Lecture des k flux en parallèle : un enregistrement de chaque flux par morceau
+    std::thread reader([&]() {
+        int s;
+        unsigned long long index = firstChunk;
+        while (freeSlots.pop(s))
+        {
+            stream_combine_slot & slot = slots[s];
+            slot.index = index++;
+            slot.length = 0;
+            slot.error = STREAM_OK;
+
+            for (int i = 0; i < count && slot.error == STREAM_OK; i++)
+            {
+                unsigned char * record = slot.records.data() + i * STREAM_RECORD_BYTES;
+                inputs[i]->read((char *) record, STREAM_RECORD_BYTES);
+
+                size_t length = load_uint(record + 8, 4);
+                if (!*inputs[i]) {
+                    slot.error = inputs[i]->eof() ? STREAM_ERROR_TRUNCATED : STREAM_ERROR_IO;
+                } else if (!stream_valid_record(record, chunkSize) || load_uint(record, 8) != slot.index) {
+                    slot.error = STREAM_ERROR_CHECKSUM;
+                } else if (i > 0 && memcmp(record + 8, slot.records.data() + 8, 12) != 0) {
+                    slot.error = STREAM_ERROR_MISMATCH;
+                } else {
+                    slot.length = length;
+                    slot.plainLength = load_uint(record + 12, 4);
+                    slot.codec = load_uint(record + 16, 4);
+                    inputs[i]->read((char *) slot.shares.data() + i * chunkSize, length);
+                    if (!*inputs[i]) {
+                        slot.error = inputs[i]->eof() ? STREAM_ERROR_TRUNCATED : STREAM_ERROR_IO;
+                    }
+                }
+            }
+
+            // On s'arrête après la fin du flux ou la première erreur
+            bool last = slot.length == 0 || slot.error != STREAM_OK;
+            if (!toCompute.push(s) || last) {
+                break;
+            }
+        }
+        toCompute.close();
+    });
+
+    // Vérification et reconstruction par les workers
+    std::vector<std::thread> pool;
+    for (int w = 0; w < workers; w++)
+    {
+        pool.push_back(std::thread([&]() {
+            std::vector<const unsigned char *> shares(count);
+            std::vector<unsigned char> expected(chunkSize);
+            std::vector<unsigned int> checksums(count);
+            stream_mac mac(macKey, header.splitId);
+            int s;
+            while (toCompute.pop(s))
+            {
+                stream_combine_slot & slot = slots[s];
+                if (slot.error == STREAM_OK && !mac.ready()) {
+                    slot.error = STREAM_ERROR_IO;
+                }
+                for (int i = 0; i < count; i++) {
+                    shares[i] = slot.shares.data() + i * chunkSize;
+                }
+
+                // Reconstruction d'abord : le CRC-32C des k parts est calculé au passage, puis les enregistrements sont vérifiés
+                unsigned char * target = slot.codec == STREAM_CODEC_NONE ? slot.data.data() : slot.packed.data();
+                if (slot.error == STREAM_OK)
+                {
+                    stream_reconstruct_chunk(target, shares.data(), weights.data(), slot.length, k, checksums.data());
+                    slot.error = stream_check_records(slot.records.data(), shares.data(), slot.length, x.data(), count, k, mac, checksums.data());
+                }
+
+                if (slot.error == STREAM_OK && slot.length != 0)
+                {
+                    // Les flux supplémentaires doivent être des évaluations du même polynome
+                    for (int e = k; e < count && slot.error == STREAM_OK; e++)
+                    {
+                        stream_reconstruct_chunk(expected.data(), shares.data(), checkWeights.data() + (e - k) * k, slot.length, k, NULL);
+                        if (memcmp(expected.data(), shares[e], slot.length) != 0) {
+                            slot.error = STREAM_ERROR_MISMATCH;
+                        }
+                    }
+
+                    // Décompression après vérification de toutes les parts
+                    if (slot.error == STREAM_OK && slot.codec != STREAM_CODEC_NONE
+                        && !stream_unpack(slot.data.data(), slot.plainLength, target, slot.length, slot.codec)) {
+                        slot.error = STREAM_ERROR_CHECKSUM;
+                    }
+                }
+
+                if (!toWrite.push(slot.index, s)) {
+                    break;
+                }
+            }
+        }));
+    }
+
+    // Ecriture incrémentale dans le thread appelant, dans l'ordre des morceaux
+    int error = STREAM_OK;
+    int s;
+    while (toWrite.pop(s))
+    {
+        stream_combine_slot & slot = slots[s];
+        if (slot.error != STREAM_OK) {
+            error = slot.error;
+            failedChunk = slot.index;
+            break;
+        }
+        if (slot.length == 0) {
+            break;
+        }
+
+        output.write((const char *) slot.data.data(), slot.plainLength);
+        if (!output.good()) {
+            error = STREAM_ERROR_IO;
+            failedChunk = slot.index;
+            break;
+        }
+        state.chunks = slot.index + 1;
+        state.plainOffset += slot.plainLength;
+        state.fileOffset += STREAM_RECORD_BYTES + slot.length;
+        freeSlots.push(s);
+
+        // Point de reprise : la sortie est vidée, checkpoint la rend durable avant d'enregistrer l'état
+        if (checkpoint != NULL && state.plainOffset - checkpointOffset >= STREAM_CHECKPOINT_BYTES)
+        {
+            checkpointOffset = state.plainOffset;
+            if (!output.flush() || !checkpoint->save(state)) {
+                error = STREAM_ERROR_IO;
+                failedChunk = slot.index;
+                break;
+            }
+        }
+    }
+
+    freeSlots.close();
+    toCompute.close();
+    toWrite.close();
+    reader.join();
+    for (size_t w = 0; w < pool.size(); w++) {
+        pool[w].join();
+    }
+
+    output.flush();
+    if (error == STREAM_OK && !output.good()) {
+        error = STREAM_ERROR_IO;
+    }
+    return error;
+}
+
+// Fonction qui lit les index de fin des flux de parts, qui doivent être identiques
+static int stream_read_indexes(std::vector<stream_index_entry> & index, std::vector<std::istream *> & inputs, unsigned long long & failedChunk)
+{
+    std::vector<stream_index_entry> other;
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        if (!stream_read_index(i == 0 ? index : other, *inputs[i])) {
+            return STREAM_ERROR_FORMAT;
+        }
+        if (i == 0) {
+            continue;
+        }
+        if (other.size() != index.size()) {
+            return STREAM_ERROR_MISMATCH;
+        }
+        for (size_t c = 0; c < index.size(); c++)
+        {
+            if (other[c].fileOffset != index[c].fileOffset || other[c].length != index[c].length || other[c].plainLength != index[c].plainLength) {
+                failedChunk = c;
+                return STREAM_ERROR_MISMATCH;
+            }
+        }
+    }
+    return STREAM_OK;
+}
+
+// Fonction qui reconstruit les octets [offset, offset + length[ de l'entrée en ne lisant que les morceaux concernés
+// Les index des fichiers doivent être identiques ; chaque enregistrement lu est vérifié comme dans stream_combine
+int stream_extract(std::vector<std::istream *> & inputs, std::ostream & output, unsigned long long offset, unsigned long long length, unsigned long long & failedChunk,
+                   const unsigned char * macKey)
+{
+    failedChunk = 0;
+    int count = inputs.size();
+
+    stream_header header;
+    std::vector<int> x(count);
+    if (!stream_read_headers(header, x, inputs)) {
+        return STREAM_ERROR_FORMAT;
+    }
+    if (!stream_key_matches(header, macKey)) {
+        return STREAM_ERROR_AUTH;
+    }
+    int k = header.k;
+
+    std::vector<stream_index_entry> index;
+    int error = stream_read_indexes(index, inputs, failedChunk);
+    if (error != STREAM_OK) {
+        return error;
+    }
+
+    unsigned long long total = index.empty() ? 0 : index.back().plainOffset + index.back().plainLength;
+    if (offset > total || length > total - offset) {
+        return STREAM_ERROR_RANGE;
+    }
+    if (length == 0) {
+        return STREAM_OK;
+    }
+
+    std::vector<unsigned char> weights(k), checkWeights((count - k) * k);
+    stream_lagrange_weights(weights.data(), x.data(), k, 0);
+    for (int e = k; e < count; e++) {
+        stream_lagrange_weights(checkWeights.data() + (e - k) * k, x.data(), k, x[e]);
+    }
+
+    // Premier morceau : le dernier qui commence avant offset
+    size_t first = 0, last = index.size();
+    while (last - first > 1)
+    {
+        size_t middle = (first + last) / 2;
+        if (index[middle].plainOffset <= offset) {
+            first = middle;
+        } else {
+            last = middle;
+        }
+    }
+
+    std::vector<unsigned char> records(count * STREAM_RECORD_BYTES), shareData(count * header.chunkSize), data(header.chunkSize), packed(header.chunkSize);
+    std::vector<unsigned char> expected(header.chunkSize);
+    std::vector<const unsigned char *> shares(count);
+    std::vector<unsigned int> checksums(count);
+    unsigned long long end = offset + length;
+    stream_mac mac(macKey, header.splitId);
+    if (!mac.ready()) {
+        return STREAM_ERROR_IO;
+    }
+
+    for (size_t c = first; c < index.size() && index[c].plainOffset < end; c++)
+    {
+        const stream_index_entry & entry = index[c];
+        failedChunk = c;
+        if (entry.length > header.chunkSize || entry.plainLength > header.chunkSize) {
+            return STREAM_ERROR_FORMAT;
+        }
+
+        // Lecture directe de l'enregistrement du morceau dans chaque fichier
+        for (int i = 0; i < count; i++)
+        {
+            unsigned char * record = records.data() + i * STREAM_RECORD_BYTES;
+            shares[i] = shareData.data() + i * header.chunkSize;
+
+            inputs[i]->clear();
+            inputs[i]->seekg(entry.fileOffset);
+            inputs[i]->read((char *) record, STREAM_RECORD_BYTES);
+            inputs[i]->read((char *) shares[i], entry.length);
+            if (!*inputs[i]) {
+                return inputs[i]->eof() ? STREAM_ERROR_TRUNCATED : STREAM_ERROR_IO;
+            }
+            if (load_uint(record, 8) != c || load_uint(record + 8, 4) != entry.length || load_uint(record + 12, 4) != entry.plainLength
+                || !stream_valid_record(record, header.chunkSize)) {
+                return STREAM_ERROR_CHECKSUM;
+            }
+            if (memcmp(record + 16, records.data() + 16, 4) != 0) {
+                return STREAM_ERROR_MISMATCH;
+            }
+        }
+
+        int codec = load_uint(records.data() + 16, 4);
+        unsigned char * target = codec == STREAM_CODEC_NONE ? data.data() : packed.data();
+        stream_reconstruct_chunk(target, shares.data(), weights.data(), entry.length, k, checksums.data());
+        error = stream_check_records(records.data(), shares.data(), entry.length, x.data(), count, k, mac, checksums.data());
+        if (error != STREAM_OK) {
+            return error;
+        }
+        for (int e = k; e < count; e++)
+        {
+            stream_reconstruct_chunk(expected.data(), shares.data(), checkWeights.data() + (e - k) * k, entry.length, k, NULL);
+            if (memcmp(expected.data(), shares[e], entry.length) != 0) {
+                return STREAM_ERROR_MISMATCH;
+            }
+        }
+        if (codec != STREAM_CODEC_NONE && !stream_unpack(data.data(), entry.plainLength, target, entry.length, codec)) {
+            return STREAM_ERROR_CHECKSUM;
+        }
+
+        // Seule la partie du morceau comprise dans la plage est écrite
+        unsigned long long from = std::max(offset, entry.plainOffset);
+        unsigned long long to = std::min(end, entry.plainOffset + entry.plainLength);
+        output.write((const char *) data.data() + (from - entry.plainOffset), to - from);
+        if (!output.good()) {
+            return STREAM_ERROR_IO;
+        }
+    }
+
+    output.flush();
+    return output.good() ? STREAM_OK : STREAM_ERROR_IO;
+}
+
+// Fonctions d'écriture et de lecture d'une carte des morceaux : magic, version, nombre de morceaux puis les empreintes
+bool stream_write_map(std::ostream & out, const std::vector<unsigned char> & digests)
+{
+    unsigned char header[13];
+    memcpy(header, STREAM_MAP_MAGIC, 4);
+    store_uint(header + 4, STREAM_MAP_VERSION, 1);
+    store_uint(header + 5, digests.size() / STREAM_DIGEST_BYTES, 8);
+
+    out.write((const char *) header, sizeof(header));
+    out.write((const char *) digests.data(), digests.size());
+    return out.good();
+}
+
+bool stream_read_map(std::vector<unsigned char> & digests, std::istream & in)
+{
+    unsigned char header[13];
+    in.read((char *) header, sizeof(header));
+    if (!in || memcmp(header, STREAM_MAP_MAGIC, 4) != 0 || load_uint(header + 4, 1) != STREAM_MAP_VERSION) {
+        return false;
+    }
+
+    // Lecture par blocs : le nombre de morceaux annoncé n'est pas cru avant d'avoir été lu
+    unsigned long long count = load_uint(header + 5, 8);
+    digests.clear();
+    unsigned char digest[STREAM_DIGEST_BYTES];
+    for (unsigned long long c = 0; c < count; c++)
+    {
+        in.read((char *) digest, STREAM_DIGEST_BYTES);
+        if (!in) {
+            return false;
+        }
+        digests.insert(digests.end(), digest, digest + STREAM_DIGEST_BYTES);
+    }
+    return in.peek() == EOF;
+}
+
+// Fonction qui écrit les n enregistrements d'un morceau à la position offset des fichiers de parts
+static bool stream_write_chunk(std::vector<std::iostream *> & files, unsigned long long offset, const unsigned char * records,
+                               const unsigned char * shares, size_t length, size_t chunkSize)
+{
+    bool ok = true;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        files[i]->clear();
+        files[i]->seekp(offset);
+        files[i]->write((const char *) records + i * STREAM_RECORD_BYTES, STREAM_RECORD_BYTES);
+        files[i]->write((const char *) shares + i * chunkSize, length);
+        ok = ok && files[i]->good();
+    }
+    return ok;
+}
+
+// Fonction qui relit les n enregistrements d'un morceau inchangé, les vérifie avec l'étiquette de l'ancien partage et
+// les réécrit avec celle du nouveau ; les parts restent en place
+static int stream_retag_chunk(std::vector<std::iostream *> & files, const stream_index_entry & entry, unsigned long long c,
+                              unsigned char * share, stream_mac & oldMac, stream_mac & newMac)
+{
+    unsigned char record[STREAM_RECORD_BYTES];
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        files[i]->clear();
+        files[i]->seekg(entry.fileOffset);
+        files[i]->read((char *) record, STREAM_RECORD_BYTES);
+        files[i]->read((char *) share, entry.length);
+        if (!files[i]->good()) {
+            return STREAM_ERROR_TRUNCATED;
+        }
+        if (load_uint(record, 8) != c || load_uint(record + 8, 4) != entry.length || load_uint(record + 12, 4) != entry.plainLength) {
+            return STREAM_ERROR_FORMAT;
+        }
+
+        unsigned int checksum = crc32c(0, share, entry.length);
+        int error = stream_check_record(record, share, entry.length, i + 1, oldMac, checksum);
+        if (error != STREAM_OK) {
+            return error;
+        }
+        int codec = load_uint(record + 16, 4);
+        if (!stream_make_record(record, c, share, entry.length, entry.plainLength, codec, i + 1, newMac, checksum)) {
+            return STREAM_ERROR_IO;
+        }
+        files[i]->seekp(entry.fileOffset);
+        files[i]->write((const char *) record, STREAM_RECORD_BYTES);
+        if (!files[i]->good()) {
+            return STREAM_ERROR_IO;
+        }
+    }
+    return STREAM_OK;
+}
+
+// Fonction qui met à jour sur place les n fichiers de parts d'après la nouvelle version de l'entrée
+// files[i] est le fichier de la part d'abscisse i + 1 et digests la carte des morceaux, remplacée par celle de la nouvelle version
+// Un morceau de même position et de même taille dont l'empreinte n'a pas changé garde ses enregistrements ; à partir du
+// premier morceau de taille différente, la disposition change et tous les morceaux suivants sont réécrits à la suite.
+// Avec compress, un morceau modifié est compressé comme dans stream_split ; s'il tient dans l'ancien enregistrement,
+// il y est complété par des zéros (ignorés à la décompression) pour rester sur place.
+// La mise à jour tire un nouvel identifiant de partage : avec une clé, les parts des morceaux inchangés sont relues et
+// vérifiées, et seules leurs étiquettes sont réécrites ; un fichier d'avant la mise à jour n'est plus accepté.
+// La mise à jour n'est pas atomique : une interruption laisse des fichiers à reprendre par un nouveau partage complet
+// macKey est la clé des parts authentifiées, nul sinon
+int stream_update(std::istream & input, std::vector<std::iostream *> & files, bool compress, std::vector<unsigned char> & digests,
+                  unsigned long long & fileSize, unsigned long long & changedChunks, const unsigned char * macKey)
+{
+    fileSize = 0;
+    changedChunks = 0;
+    int n = files.size();
+
+    // Tous les fichiers de parts sont nécessaires, dans l'ordre des abscisses
+    std::vector<std::istream *> inputs(files.begin(), files.end());
+    stream_header header;
+    std::vector<int> x(n);
+    if (n == 0 || !stream_read_headers(header, x, inputs) || header.n != n) {
+        return STREAM_ERROR_FORMAT;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        if (x[i] != i + 1) {
+            return STREAM_ERROR_FORMAT;
+        }
+    }
+    if (!stream_key_matches(header, macKey)) {
+        return STREAM_ERROR_AUTH;
+    }
+    int k = header.k;
+    size_t chunkSize = header.chunkSize;
+
+    std::vector<stream_index_entry> index;
+    unsigned long long failedChunk = 0;
+    int error = stream_read_indexes(index, inputs, failedChunk);
+    if (error != STREAM_OK) {
+        return error;
+    }
+    if (digests.size() != index.size() * STREAM_DIGEST_BYTES) {
+        return STREAM_ERROR_MISMATCH;
+    }
+
+    // Aléa neuf pour les morceaux partagés à nouveau et nouvel identifiant de partage
+    stream_header updated = header;
+    unsigned char key[STREAM_KEY_BYTES];
+    if (RAND_bytes(key, STREAM_KEY_BYTES) != 1 || RAND_bytes(updated.splitId, STREAM_SPLIT_ID_BYTES) != 1) {
+        return STREAM_ERROR_IO;
+    }
+    stream_mac oldMac(macKey, header.splitId), newMac(macKey, updated.splitId);
+    if (!oldMac.ready() || !newMac.ready()) {
+        return STREAM_ERROR_IO;
+    }
+
+    std::vector<unsigned char> data(chunkSize), packed(chunkSize), planes((k - 1) * chunkSize), shareData(n * chunkSize), records(n * STREAM_RECORD_BYTES);
+    std::vector<unsigned char *> shares(n);
+    std::vector<unsigned int> checksums(n);
+    for (int i = 0; i < n; i++) {
+        shares[i] = shareData.data() + i * chunkSize;
+    }
+
+    std::vector<stream_index_entry> newIndex;
+    std::vector<unsigned char> newDigests;
+    unsigned long long plainOffset = 0, fileOffset = STREAM_HEADER_BYTES;
+    bool moved = false;
+
+    for (unsigned long long c = 0; error == STREAM_OK; c++)
+    {
+        input.read((char *) data.data(), chunkSize);
+        size_t length = input.gcount();
+        if (input.bad()) {
+            error = STREAM_ERROR_IO;
+            break;
+        }
+        if (length == 0) {
+            break;
+        }
+
+        unsigned char digest[STREAM_DIGEST_BYTES];
+        if (!stream_digest(digest, data.data(), length)) {
+            error = STREAM_ERROR_IO;
+            break;
+        }
+
+        bool sameLayout = !moved && c < index.size() && index[c].plainLength == length;
+        bool unchanged = sameLayout && memcmp(digest, digests.data() + c * STREAM_DIGEST_BYTES, STREAM_DIGEST_BYTES) == 0;
+        size_t stored = unchanged ? index[c].length : length;
+
+        if (!unchanged)
+        {
+            const unsigned char * source = data.data();
+            int codec = compress ? stream_pack(packed.data(), stored, data.data(), length) : STREAM_CODEC_NONE;
+            if (codec == STREAM_CODEC_NONE) {
+                stored = length;
+            } else if (sameLayout && index[c].length == length) {
+                // L'ancien morceau n'était pas compressé : on reste sur place sans compresser
+                codec = STREAM_CODEC_NONE;
+                stored = length;
+            } else {
+                source = packed.data();
+                if (sameLayout && stored < index[c].length) {
+                    memset(packed.data() + stored, 0, index[c].length - stored);
+                    stored = index[c].length;
+                }
+            }
+
+            if (!stream_random_planes(planes.data(), (k - 1) * stored, key, c)) {
+                error = STREAM_ERROR_IO;
+                break;
+            }
+            stream_compute_shares(shares.data(), source, planes.data(), stored, k, n, checksums.data());
+            for (int i = 0; i < n; i++)
+            {
+                if (!stream_make_record(records.data() + i * STREAM_RECORD_BYTES, c, shares[i], stored, length, codec, i + 1, newMac, checksums[i])) {
+                    error = STREAM_ERROR_IO;
+                }
+            }
+            if (error == STREAM_OK && !stream_write_chunk(files, fileOffset, records.data(), shareData.data(), stored, chunkSize)) {
+                error = STREAM_ERROR_IO;
+            }
+            changedChunks++;
+        } else if (newMac.enabled()) {
+            error = stream_retag_chunk(files, index[c], c, shares[0], oldMac, newMac);
+        }
+        moved = !sameLayout || stored != index[c].length;
+
+        stream_index_entry entry = { plainOffset, fileOffset, (unsigned int) stored, (unsigned int) length };
+        newIndex.push_back(entry);
+        newDigests.insert(newDigests.end(), digest, digest + STREAM_DIGEST_BYTES);
+        plainOffset += length;
+        fileOffset += STREAM_RECORD_BYTES + stored;
+
+        if (length < chunkSize) {
+            break;
+        }
+    }
+
+    // Fin du flux et nouvel index à la suite du dernier morceau
+    if (error == STREAM_OK)
+    {
+        unsigned char record[STREAM_RECORD_BYTES];
+        for (int i = 0; i < n && error == STREAM_OK; i++)
+        {
+            if (!stream_make_record(record, newIndex.size(), NULL, 0, 0, STREAM_CODEC_NONE, i + 1, newMac, 0)) {
+                error = STREAM_ERROR_IO;
+                break;
+            }
+            files[i]->clear();
+            files[i]->seekp(fileOffset);
+            files[i]->write((const char *) record, STREAM_RECORD_BYTES);
+            if (!stream_write_index(*files[i], newIndex, fileOffset + STREAM_RECORD_BYTES)) {
+                error = STREAM_ERROR_IO;
+            }
+
+            // L'en-tête est réécrit en dernier, avec le nouvel identifiant
+            updated.x = i + 1;
+            files[i]->seekp(0);
+            if (!stream_write_header(*files[i], updated) || !files[i]->flush()) {
+                error = STREAM_ERROR_IO;
+            }
+        }
+    }
+
+    if (error == STREAM_OK)
+    {
+        fileSize = fileOffset + STREAM_RECORD_BYTES + newIndex.size() * STREAM_INDEX_ENTRY_BYTES + STREAM_TRAILER_BYTES;
+        digests.swap(newDigests);
+    }
+    OPENSSL_cleanse(key, STREAM_KEY_BYTES);
+    return error;
+}
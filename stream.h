@@ -0,0 +1,152 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#define STREAM_DEFAULT_CHUNK (1 << 20) // Taille par défaut d'un morceau de l'entrée
+#define STREAM_MAX_CHUNK (64 << 20)    // Taille maximale d'un morceau
+#define STREAM_SLOTS 4                 // Morceaux en vol (lecture, attente d'écriture) en plus de ceux des workers
+#define STREAM_MEMORY_BUDGET (1ULL << 30) // Mémoire des morceaux en vol : le nombre de workers est réduit pour y tenir
+#define STREAM_DIGEST_BYTES 32         // Empreinte SHA-256 d'un morceau dans la carte des morceaux
+#define STREAM_MAC_KEY_BYTES 32        // Clé HMAC-SHA256 des étiquettes d'enregistrement
+#define STREAM_KEY_BYTES 32            // Clé AES-256 des plans aléatoires d'un partage
+#define STREAM_SPLIT_ID_BYTES 16       // Identifiant aléatoire d'un partage, lié aux étiquettes d'enregistrement
+#define STREAM_CHECKPOINT_BYTES (64ULL << 20) // Octets écrits entre deux points de reprise
+
+// Codes de retour de la reconstruction
+#define STREAM_OK 0
+#define STREAM_ERROR_IO 1           // Lecture ou écriture impossible
+#define STREAM_ERROR_FORMAT 2       // En-têtes invalides ou incompatibles
+#define STREAM_ERROR_CHECKSUM 3     // Enregistrement altéré
+#define STREAM_ERROR_MISMATCH 4     // Parts incohérentes entre elles
+#define STREAM_ERROR_TRUNCATED 5    // Flux de parts tronqué
+#define STREAM_ERROR_RANGE 6        // Plage hors des limites de l'entrée d'origine
+#define STREAM_ERROR_AUTH 7         // Etiquette invalide, clé absente ou différente
+#define STREAM_ERROR_MEMORY 8       // Deux morceaux en vol dépassent STREAM_MEMORY_BUDGET
+
+// Options d'un flux de parts
+#define STREAM_FLAG_MAC 1           // Enregistrements authentifiés par HMAC-SHA256
+
+// Codecs des morceaux partagés
+#define STREAM_CODEC_NONE 0         // Morceau partagé tel quel
+#define STREAM_CODEC_DEFLATE 1      // Morceau compressé par zlib avant le partage
+
+// En-tête d'un flux de parts
+struct stream_header
+{
+    int version;
+    int k;                      // Seuil
+    int n;                      // Nombre de parts
+    int x;                      // Abscisse de la part dans GF(2^8), non nulle
+    unsigned int chunkSize;     // Taille maximale d'un morceau
+    unsigned int flags;         // Options STREAM_FLAG_*
+    unsigned char splitId[STREAM_SPLIT_ID_BYTES]; // Identifiant du partage, renouvelé par stream_update
+};
+
+// Entrée de l'index de fin d'un fichier de parts : un morceau de l'entrée et son enregistrement
+struct stream_index_entry
+{
+    unsigned long long plainOffset; // Position du morceau dans l'entrée d'origine
+    unsigned long long fileOffset;  // Position de son enregistrement dans le fichier de parts
+    unsigned int length;            // Taille de la part (du morceau compressé s'il l'est)
+    unsigned int plainLength;       // Taille du morceau
+};
+
+// Destination des n flux de parts écrits par stream_split : les n flux reçoivent toujours le même nombre d'octets
+struct stream_sink
+{
+    virtual ~stream_sink() {}
+
+    // Ajoute length octets à chaque flux i, lus à l'adresse data + i * stride (stride nul : mêmes octets partout)
+    virtual bool append(const unsigned char * data, size_t stride, size_t length) = 0;
+
+    // Rend durables les octets déjà ajoutés (avant un point de reprise)
+    virtual bool sync() = 0;
+
+    // Termine l'écriture des n flux
+    virtual bool finish() = 0;
+};
+
+// Etat d'un partage ou d'une reconstruction enregistré à chaque point de reprise : seuls les morceaux entièrement
+// écrits et rendus durables y sont comptés
+struct stream_state
+{
+    stream_header header;                   // Paramètres du flux de parts (abscisse non significative)
+    bool compress;                          // Partage avec compression des morceaux
+    unsigned long long chunks;              // Morceaux écrits
+    unsigned long long plainOffset;         // Octets de l'entrée partagés, ou de la sortie reconstruits
+    unsigned long long fileOffset;          // Position de l'enregistrement suivant dans les fichiers de parts
+};
+
+// Destination des points de reprise : save est appelée une fois les octets décrits par l'état rendus durables
+struct stream_checkpoint
+{
+    virtual ~stream_checkpoint() {}
+
+    virtual bool save(const stream_state & state) = 0;
+};
+
+// Fonctions d'écriture et de lecture de l'en-tête d'un flux de parts
+bool stream_write_header(std::ostream & out, const stream_header & header);
+bool stream_read_header(stream_header & header, std::istream & in);
+
+// Fonction qui calcule les parts d'un morceau de length octets dans GF(2^8) : shares[i] reçoit la part d'abscisse i + 1
+// Si checksums n'est pas nul, checksums[i] reçoit le CRC-32C de la part i
+void stream_compute_shares(unsigned char ** shares, const unsigned char * data, const unsigned char * planes, size_t length, int k, int n,
+                           unsigned int * checksums);
+
+// Fonction qui calcule le morceau (coefficient k-1) à partir de k parts et des poids de stream_lagrange_weights
+// Si checksums n'est pas nul, checksums[i] reçoit le CRC-32C de la part i
+void stream_reconstruct_chunk(unsigned char * data, const unsigned char * const * shares, const unsigned char * weights, size_t length, int k,
+                              unsigned int * checksums);
+
+// Fonction qui calcule les poids de Lagrange des k abscisses : pour le secret si at = 0, pour la valeur en at sinon
+void stream_lagrange_weights(unsigned char * weights, const int * x, int k, int at);
+
+// Fonction qui indique si deux morceaux de chunkSize octets répartis sur streams flux de parts tiennent dans STREAM_MEMORY_BUDGET
+bool stream_chunk_fits(size_t chunkSize, int streams);
+
+// Fonction qui partage un flux de taille quelconque en n flux de parts avec une mémoire bornée
+// Avec compress, chaque morceau est compressé avant d'être partagé quand il y gagne
+// Si digests n'est pas nul, il reçoit la carte des morceaux (empreinte de chaque morceau) pour stream_update
+// Si macKey n'est pas nul, les enregistrements sont authentifiés avec cette clé de STREAM_MAC_KEY_BYTES octets
+// Si checkpoint n'est pas nul, l'état est enregistré tous les STREAM_CHECKPOINT_BYTES octets écrits
+// Si resume n'est pas nul, le partage reprend après ses morceaux : sink écrit alors à partir de resume->fileOffset et
+// resumeIndex contient l'index des morceaux déjà écrits (stream_scan_records)
+bool stream_split(std::istream & input, stream_sink & sink, int k, int n, size_t chunkSize, bool compress,
+                  std::vector<unsigned char> * digests, const unsigned char * macKey, stream_checkpoint * checkpoint,
+                  const stream_state * resume, const std::vector<stream_index_entry> * resumeIndex);
+
+// Fonction qui relit les enregistrements des morceaux écrits avant un point de reprise dans un fichier de parts
+bool stream_scan_records(std::vector<stream_index_entry> & index, std::istream & in, const stream_state & state);
+
+// Fonctions d'écriture et de lecture d'une carte des morceaux
+bool stream_write_map(std::ostream & out, const std::vector<unsigned char> & digests);
+bool stream_read_map(std::vector<unsigned char> & digests, std::istream & in);
+
+// Fonction qui met à jour sur place les n fichiers de parts d'après la nouvelle version de l'entrée
+// Seuls les morceaux dont l'empreinte a changé sont partagés à nouveau ; fileSize reçoit la nouvelle taille des fichiers
+// macKey est la clé des parts authentifiées (STREAM_FLAG_MAC), nul sinon
+int stream_update(std::istream & input, std::vector<std::iostream *> & files, bool compress, std::vector<unsigned char> & digests,
+                  unsigned long long & fileSize, unsigned long long & changedChunks, const unsigned char * macKey);
+
+// Fonction qui reconstruit un flux à partir d'au moins k flux de parts, les flux au-delà des k premiers servent à la vérification
+// macKey est la clé des parts authentifiées (STREAM_FLAG_MAC), nul sinon
+// Si checkpoint n'est pas nul, l'état est enregistré tous les STREAM_CHECKPOINT_BYTES octets écrits, après output.flush()
+// Si resume n'est pas nul, la reconstruction reprend après ses morceaux : output est déjà positionné à resume->plainOffset
+int stream_combine(std::vector<std::istream *> & inputs, std::ostream & output, unsigned long long & failedChunk, const unsigned char * macKey,
+                   stream_checkpoint * checkpoint, const stream_state * resume);
+
+// Fonction qui lit l'index de fin d'un fichier de parts (le flux doit permettre le déplacement)
+bool stream_read_index(std::vector<stream_index_entry> & index, std::istream & in);
+
+// Fonction qui reconstruit les octets [offset, offset + length[ de l'entrée en ne lisant que les morceaux concernés
+int stream_extract(std::vector<std::istream *> & inputs, std::ostream & output, unsigned long long offset, unsigned long long length, unsigned long long & failedChunk,
+                   const unsigned char * macKey);
+
+// Fonction qui donne le message d'une erreur de reconstruction
+const char * stream_error_string(int error);
+
+#endif
@@ -0,0 +1,682 @@
+#include "vault.h"
+#include "bytes.h"
+#include "crc32c.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Coffre de parts structuré en journal (log-structured). Les parts sont ajoutées à la fin du segment actif
+ * par un group_journal : une écriture de part ne coûte ni lecture ni déplacement d'octets existants, et le
+ * fdatasync est partagé par tous les ajouts d'un lot. Un segment plein est scellé et un nouveau segment
+ * commence ; chaque segment est projeté une seule fois en mémoire (mmap) sur VAULT_SEGMENT_BYTES octets.
+ *
+ * Format d'un enregistrement : CRC-32C des octets qui le suivent dans l'enregistrement, taille de la part,
+ * identifiant du secret, abscisse du participant, type (part ou suppression), deux octets réservés, puis la
+ * part. L'index en mémoire associe (identifiant, abscisse) au segment et à la position du dernier
+ * enregistrement de la part : une lecture est une recherche dans la table puis un accès à la projection, soit
+ * au plus une lecture disque aléatoire.
+ *
+ * L'index est mis à jour sous le verrou au moment de l'ajout, dans l'ordre du journal ; à l'ouverture, il est
+ * reconstruit en rejouant les segments dans l'ordre, le dernier enregistrement d'une clé l'emportant. Une fin
+ * d'enregistrement déchirée n'est possible que dans le dernier segment (un segment n'est scellé qu'une fois
+ * entièrement durable) : elle y est tronquée, ailleurs elle rend le coffre inutilisable.
+ *
+ * Le compactage recopie à la fin du journal les enregistrements encore vivants d'un segment scellé peu occupé,
+ * puis supprime le segment une fois les copies durables. Une suppression n'est recopiée que si un segment plus
+ * ancien peut encore contenir la part qu'elle efface. Les suppressions comptent comme vivantes : un segment
+ * qui n'en contient presque que n'est pas choisi, sinon elles seraient recopiées à chaque passage tant qu'un
+ * segment plus ancien subsiste.
+ */
+
+#define VAULT_TYPE_PUT 1
+#define VAULT_TYPE_DELETE 2
+#define VAULT_INDEX_INITIAL 1024
+#define VAULT_MAX_SEGMENT 0xffffff  // Le numéro de segment occupe les 24 bits de poids fort de vault_slot::tag
+
+// Mélange splitmix64 de la clé (identifiant, abscisse)
+static unsigned long long vault_hash(unsigned long long id, int x)
+{
+    unsigned long long z = id + 0x9E3779B97F4A7C15ULL * (unsigned long long) (x + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+vault_index::vault_index() : slots_(VAULT_INDEX_INITIAL), count_(0)
+{
+}
+
+size_t vault_index::home(unsigned long long id, int x) const
+{
+    return vault_hash(id, x) & (slots_.size() - 1);
+}
+
+// Fonction qui cherche la case de la clé, NULL si elle est absente
+vault_slot * vault_index::find(unsigned long long id, int x)
+{
+    size_t mask = slots_.size() - 1;
+    for (size_t i = home(id, x); slots_[i].tag != 0; i = (i + 1) & mask)
+    {
+        if (slots_[i].id == id && (int) (slots_[i].tag & 0xff) == x) {
+            return &slots_[i];
+        }
+    }
+    return NULL;
+}
+
+// Fonction qui associe la clé à (segment, offset), en insérant la clé si besoin ; la table double à 3/4 de charge
+void vault_index::set(unsigned long long id, int x, unsigned int segment, unsigned int offset)
+{
+    vault_slot * slot = find(id, x);
+    if (slot == NULL)
+    {
+        if ((count_ + 1) * 4 > slots_.size() * 3) {
+            grow();
+        }
+        size_t mask = slots_.size() - 1;
+        size_t i = home(id, x);
+        while (slots_[i].tag != 0) {
+            i = (i + 1) & mask;
+        }
+        slot = &slots_[i];
+        slot->id = id;
+        count_++;
+    }
+    slot->offset = offset;
+    slot->tag = segment << 8 | x;
+}
+
+// Fonction qui retire la clé ; les cases suivantes de la même suite sont décalées pour ne pas laisser de trou
+bool vault_index::erase(unsigned long long id, int x)
+{
+    vault_slot * slot = find(id, x);
+    if (slot == NULL) {
+        return false;
+    }
+
+    size_t mask = slots_.size() - 1;
+    size_t hole = slot - slots_.data();
+    for (size_t i = (hole + 1) & mask; slots_[i].tag != 0; i = (i + 1) & mask)
+    {
+        // Une case peut combler le trou si sa position d'origine n'est pas strictement entre le trou et elle
+        size_t origin = home(slots_[i].id, slots_[i].tag & 0xff);
+        if (((i - origin) & mask) >= ((i - hole) & mask))
+        {
+            slots_[hole] = slots_[i];
+            hole = i;
+        }
+    }
+    slots_[hole].tag = 0;
+    count_--;
+    return true;
+}
+
+// Fonction qui ajoute à ids les identifiants des clés d'abscisse x (parcours de toute la table)
+void vault_index::collect(int x, std::vector<unsigned long long> & ids) const
+{
+    for (size_t i = 0; i < slots_.size(); i++)
+    {
+        if (slots_[i].tag != 0 && (int) (slots_[i].tag & 0xff) == x) {
+            ids.push_back(slots_[i].id);
+        }
+    }
+}
+
+void vault_index::grow()
+{
+    std::vector<vault_slot> old(slots_.size() * 2);
+    old.swap(slots_);
+
+    size_t mask = slots_.size() - 1;
+    for (size_t j = 0; j < old.size(); j++)
+    {
+        if (old[j].tag == 0) {
+            continue;
+        }
+        size_t i = home(old[j].id, old[j].tag & 0xff);
+        while (slots_[i].tag != 0) {
+            i = (i + 1) & mask;
+        }
+        slots_[i] = old[j];
+    }
+}
+
+vault_segment::~vault_segment()
+{
+    if (map != NULL) {
+        munmap((void *) map, VAULT_SEGMENT_BYTES);
+    }
+}
+
+// Fonction qui rend durable le contenu d'un répertoire (création ou suppression d'un segment)
+static bool vault_sync_directory(const std::string & directory)
+{
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+}
+
+// Fonction qui projette un segment en lecture seule ; la projection couvre la taille maximale du segment pour
+// que les ajouts du segment actif y soient visibles sans nouvelle projection
+static const unsigned char * vault_map(int fd)
+{
+    void * map = mmap(NULL, VAULT_SEGMENT_BYTES, PROT_READ, MAP_SHARED, fd, 0);
+    return map == MAP_FAILED ? NULL : (const unsigned char *) map;
+}
+
+// Fonction qui construit un enregistrement dans record (VAULT_HEADER_BYTES + length octets)
+static void vault_make_record(unsigned char * record, unsigned long long id, int x, int type, const unsigned char * share, size_t length)
+{
+    store_uint(record + 4, length, 4);
+    store_uint(record + 8, id, 8);
+    store_uint(record + 16, x, 1);
+    store_uint(record + 17, type, 1);
+    store_uint(record + 18, 0, 2);
+    if (length != 0) {
+        memcpy(record + VAULT_HEADER_BYTES, share, length);
+    }
+    store_uint(record, crc32c(0, record + 4, VAULT_HEADER_BYTES - 4 + length), 4);
+}
+
+// Fonction qui vérifie l'enregistrement à offset dans les size premiers octets de map et renvoie sa taille totale, 0 s'il est invalide
+static size_t vault_check_record(const unsigned char * map, unsigned long long size, unsigned long long offset)
+{
+    if (offset + VAULT_HEADER_BYTES > size) {
+        return 0;
+    }
+    const unsigned char * record = map + offset;
+    size_t length = load_uint(record + 4, 4);
+    int type = load_uint(record + 17, 1);
+    if (length > VAULT_MAX_SHARE_BYTES || offset + VAULT_HEADER_BYTES + length > size || (type != VAULT_TYPE_PUT && type != VAULT_TYPE_DELETE)) {
+        return 0;
+    }
+    if (load_uint(record, 4) != crc32c(0, record + 4, VAULT_HEADER_BYTES - 4 + length)) {
+        return 0;
+    }
+    return VAULT_HEADER_BYTES + length;
+}
+
+share_vault::share_vault()
+    : interval_(JOURNAL_DEFAULT_INTERVAL), batchBytes_(JOURNAL_DEFAULT_BATCH), failed_(false), stopping_(false)
+{
+}
+
+share_vault::~share_vault()
+{
+    close();
+}
+
+std::string share_vault::segment_path(unsigned int number) const
+{
+    char name[16];
+    snprintf(name, sizeof(name), "%08u.log", number);
+    return directory_ + "/" + name;
+}
+
+// Fonction qui projette un segment existant et rejoue ses enregistrements dans l'index
+// Le dernier segment est tronqué après son dernier enregistrement valide (ajout interrompu)
+bool share_vault::load_segment(unsigned int number, bool last)
+{
+    std::string path = segment_path(number);
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    std::shared_ptr<vault_segment> segment(new vault_segment());
+    bool ok = fstat(fd, &info) == 0 && info.st_size <= VAULT_SEGMENT_BYTES && (segment->map = vault_map(fd)) != NULL;
+    ::close(fd);
+    if (!ok) {
+        return false;
+    }
+    segment->number = number;
+    segments_[number] = segment;
+
+    // Le segment est déjà dans la table : retire décompte aussi les parts remplacées dans ce même segment
+    unsigned long long size = info.st_size, offset = 0;
+    while (offset < size)
+    {
+        size_t recordSize = vault_check_record(segment->map, size, offset);
+        if (recordSize == 0) {
+            break;
+        }
+
+        const unsigned char * record = segment->map + offset;
+        unsigned long long id = load_uint(record + 8, 8);
+        int x = load_uint(record + 16, 1);
+        retire(id, x);
+        if (load_uint(record + 17, 1) == VAULT_TYPE_PUT)
+        {
+            index_.set(id, x, number, offset);
+        } else {
+            index_.erase(id, x);
+        }
+        segment->live++;
+        segment->records++;
+        offset += recordSize;
+    }
+
+    if (offset < size)
+    {
+        // Seule la fin du dernier segment peut être incomplète
+        if (!last || truncate(path.c_str(), offset) != 0) {
+            return false;
+        }
+        fprintf(stderr, "vault: %s truncated after %llu bytes (interrupted write)\n", path.c_str(), offset);
+    }
+    segment->size = offset;
+    return true;
+}
+
+// Fonction qui ouvre (ou crée) le coffre dans directory et reconstruit l'index en relisant les segments
+bool share_vault::open(const std::string & directory, unsigned int intervalMicros, size_t batchBytes)
+{
+    if (mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) {
+        return false;
+    }
+    directory_ = directory;
+    interval_ = intervalMicros;
+    batchBytes_ = batchBytes;
+    failed_ = stopping_ = false;
+
+    DIR * dir = opendir(directory.c_str());
+    if (dir == NULL) {
+        return false;
+    }
+    std::vector<unsigned int> numbers;
+    for (struct dirent * entry = readdir(dir); entry != NULL; entry = readdir(dir))
+    {
+        unsigned int number;
+        char end;
+        if (strlen(entry->d_name) == 12 && sscanf(entry->d_name, "%8u.lo%c", &number, &end) == 2 && end == 'g' && number != 0) {
+            numbers.push_back(number);
+        }
+    }
+    closedir(dir);
+    std::sort(numbers.begin(), numbers.end());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < numbers.size(); i++)
+    {
+        if (!load_segment(numbers[i], i + 1 == numbers.size()))
+        {
+            fprintf(stderr, "vault: cannot load %s\n", segment_path(numbers[i]).c_str());
+            segments_.clear();
+            return false;
+        }
+    }
+
+    // Le dernier segment reste actif s'il n'est pas plein
+    bool ok;
+    if (!segments_.empty() && segments_.rbegin()->second->size < VAULT_SEGMENT_BYTES)
+    {
+        active_ = segments_.rbegin()->second;
+        active_->journal.reset(new group_journal());
+        ok = active_->journal->open(segment_path(active_->number), interval_, batchBytes_);
+    } else {
+        ok = start_segment();
+    }
+    if (!ok)
+    {
+        segments_.clear();
+        active_.reset();
+        return false;
+    }
+
+    compactor_ = std::thread(&share_vault::run_compaction, this);
+    return true;
+}
+
+// Fonction qui scelle le segment actif (tous ses ajouts durables) puis crée le segment suivant
+bool share_vault::start_segment()
+{
+    unsigned int number = segments_.empty() ? 1 : segments_.rbegin()->first + 1;
+    if (number > VAULT_MAX_SEGMENT) {
+        return false;
+    }
+
+    // Un segment n'est créé qu'une fois le précédent entièrement durable : seul le dernier peut être déchiré
+    if (active_ && active_->journal)
+    {
+        bool ok = active_->journal->close();
+        active_->journal.reset();
+        if (!ok) {
+            return false;
+        }
+    }
+
+    std::shared_ptr<vault_segment> segment(new vault_segment());
+    segment->number = number;
+    segment->journal.reset(new group_journal());
+    if (!segment->journal->open(segment_path(number), interval_, batchBytes_)) {
+        return false;
+    }
+    segment->map = vault_map(segment->journal->fd());
+    if (segment->map == NULL || !vault_sync_directory(directory_))
+    {
+        segment->journal->close();
+        return false;
+    }
+
+    segments_[number] = segment;
+    active_ = segment;
+    return true;
+}
+
+// Fonction qui ajoute un enregistrement au segment actif (verrou tenu), en commençant un segment si besoin
+// offset reçoit la position de l'enregistrement dans active_
+bool share_vault::append_record(const unsigned char * record, size_t size, unsigned long long & offset)
+{
+    if (failed_) {
+        return false;
+    }
+    if (active_->size + size > VAULT_SEGMENT_BYTES && !start_segment())
+    {
+        failed_ = true;
+        return false;
+    }
+    if (!active_->journal->append(record, size, NULL, &offset))
+    {
+        failed_ = true;
+        return false;
+    }
+    active_->size += size;
+    active_->records++;
+    return true;
+}
+
+// Fonction qui décompte (verrou tenu) l'enregistrement désigné par l'index pour la clé, qui va être remplacé
+void share_vault::retire(unsigned long long id, int x)
+{
+    vault_slot * slot = index_.find(id, x);
+    if (slot != NULL)
+    {
+        std::map<unsigned int, std::shared_ptr<vault_segment> >::iterator it = segments_.find(slot->tag >> 8);
+        if (it != segments_.end()) {
+            it->second->live--;
+        }
+    }
+}
+
+// Fonction qui range la part du participant x pour le secret id ; renvoie une fois la part durable
+int share_vault::put(unsigned long long id, int x, const unsigned char * share, size_t length)
+{
+    if (x < 1 || x > 255 || length > VAULT_MAX_SHARE_BYTES) {
+        return VAULT_ERROR_RANGE;
+    }
+
+    std::vector<unsigned char> record(VAULT_HEADER_BYTES + length);
+    vault_make_record(record.data(), id, x, VAULT_TYPE_PUT, share, length);
+
+    std::shared_ptr<group_journal> journal;
+    unsigned long long offset;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!active_ || !append_record(record.data(), record.size(), offset)) {
+            return VAULT_ERROR_IO;
+        }
+        retire(id, x);
+        index_.set(id, x, active_->number, offset);
+        active_->live++;
+        journal = active_->journal;
+    }
+
+    // L'attente de la validation se fait hors du verrou : les ajouts des autres threads rejoignent le même lot
+    return journal->sync_to(offset + record.size()) ? VAULT_OK : VAULT_ERROR_IO;
+}
+
+// Fonction qui range les n parts d'un secret, shares[i] étant celle du participant i + 1 ; renvoie une fois les n parts durables
+// Un seul intervalle de validation pour les n parts au lieu de n à la suite. Si les enregistrements passent sur un
+// nouveau segment, le précédent a été fermé (donc rendu durable) par start_segment : seul le dernier journal est attendu
+int share_vault::put_shares(unsigned long long id, const unsigned char * const * shares, int n, size_t length)
+{
+    if (n < 1 || n > 255 || length > VAULT_MAX_SHARE_BYTES) {
+        return VAULT_ERROR_RANGE;
+    }
+
+    size_t size = VAULT_HEADER_BYTES + length;
+    std::vector<unsigned char> records(n * size);
+    for (int i = 0; i < n; i++) {
+        vault_make_record(records.data() + i * size, id, i + 1, VAULT_TYPE_PUT, shares[i], length);
+    }
+
+    std::shared_ptr<group_journal> journal;
+    unsigned long long offset = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int i = 0; i < n; i++)
+        {
+            if (!active_ || !append_record(records.data() + i * size, size, offset)) {
+                return VAULT_ERROR_IO;
+            }
+            retire(id, i + 1);
+            index_.set(id, i + 1, active_->number, offset);
+            active_->live++;
+        }
+        journal = active_->journal;
+    }
+
+    return journal->sync_to(offset + size) ? VAULT_OK : VAULT_ERROR_IO;
+}
+
+// Fonction qui lit la part du participant x pour le secret id : une seule lecture aléatoire
+int share_vault::get(unsigned long long id, int x, std::vector<unsigned char> & share)
+{
+    std::shared_ptr<vault_segment> segment;
+    std::shared_ptr<group_journal> journal;
+    unsigned long long offset, size;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        vault_slot * slot = index_.find(id, x);
+        if (slot == NULL) {
+            return VAULT_ERROR_NOT_FOUND;
+        }
+        segment = segments_[slot->tag >> 8];
+        journal = segment->journal;
+        offset = slot->offset;
+        size = segment->size;
+    }
+
+    // Une part encore en attente de validation n'est lue qu'une fois durable. Un enregistrement n'est jamais
+    // coupé entre deux lots : la durabilité de son en-tête implique celle de la part
+    if (journal && !journal->sync_to(offset + VAULT_HEADER_BYTES)) {
+        return VAULT_ERROR_IO;
+    }
+
+    size_t recordSize = vault_check_record(segment->map, size, offset);
+    const unsigned char * record = segment->map + offset;
+    if (recordSize == 0 || load_uint(record + 8, 8) != id || (int) load_uint(record + 16, 1) != x || load_uint(record + 17, 1) != VAULT_TYPE_PUT) {
+        return VAULT_ERROR_CORRUPT;
+    }
+    share.assign(record + VAULT_HEADER_BYTES, record + recordSize);
+    return VAULT_OK;
+}
+
+// Fonction qui supprime la part du participant x pour le secret id ; renvoie une fois la suppression durable
+int share_vault::remove(unsigned long long id, int x)
+{
+    if (x < 1 || x > 255) {
+        return VAULT_ERROR_RANGE;
+    }
+
+    unsigned char record[VAULT_HEADER_BYTES];
+    vault_make_record(record, id, x, VAULT_TYPE_DELETE, NULL, 0);
+
+    std::shared_ptr<group_journal> journal;
+    unsigned long long offset;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index_.find(id, x) == NULL) {
+            return VAULT_ERROR_NOT_FOUND;
+        }
+        if (!active_ || !append_record(record, sizeof(record), offset)) {
+            return VAULT_ERROR_IO;
+        }
+        retire(id, x);
+        index_.erase(id, x);
+        active_->live++;
+        journal = active_->journal;
+    }
+
+    return journal->sync_to(offset + sizeof(record)) ? VAULT_OK : VAULT_ERROR_IO;
+}
+
+// Fonction qui arrête le compactage et ferme le coffre
+bool share_vault::close()
+{
+    if (compactor_.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        compactor_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool ok = !failed_;
+    if (active_ && active_->journal)
+    {
+        ok = active_->journal->close() && ok;
+        active_->journal.reset();
+    }
+    active_.reset();
+    segments_.clear();
+    index_ = vault_index();
+    return ok;
+}
+
+// Fonction qui donne les identifiants des secrets ayant une part pour le participant x, dans l'ordre croissant
+void share_vault::ids(int x, std::vector<unsigned long long> & ids)
+{
+    ids.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        index_.collect(x, ids);
+    }
+    std::sort(ids.begin(), ids.end());
+}
+
+size_t share_vault::count()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+}
+
+size_t share_vault::segments()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return segments_.size();
+}
+
+// Thread de compactage : à chaque période, le segment scellé le moins occupé est recopié s'il est sous le seuil
+void share_vault::run_compaction()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_)
+    {
+        wake_.wait_for(lock, std::chrono::milliseconds(VAULT_COMPACT_PERIOD), [this] { return stopping_; });
+        if (stopping_ || failed_) {
+            continue;
+        }
+
+        std::shared_ptr<vault_segment> candidate;
+        for (std::map<unsigned int, std::shared_ptr<vault_segment> >::iterator it = segments_.begin(); it != segments_.end(); ++it)
+        {
+            const vault_segment & segment = *it->second;
+            if (it->second == active_ || segment.live * VAULT_COMPACT_RATIO >= segment.records) {
+                continue;
+            }
+            // Plus petite proportion d'enregistrements vivants : live / records < candidate.live / candidate.records
+            if (!candidate || segment.live * candidate->records < candidate->live * segment.records) {
+                candidate = it->second;
+            }
+        }
+        if (!candidate) {
+            continue;
+        }
+
+        lock.unlock();
+        bool ok = compact(candidate);
+        lock.lock();
+        if (!ok) {
+            fprintf(stderr, "vault: compaction of %s failed\n", segment_path(candidate->number).c_str());
+        }
+    }
+}
+
+// Fonction qui recopie les enregistrements encore utiles d'un segment scellé puis le supprime
+bool share_vault::compact(std::shared_ptr<vault_segment> segment)
+{
+    std::shared_ptr<group_journal> journal;
+    unsigned long long end = 0;
+
+    for (unsigned long long offset = 0; offset < segment->size; )
+    {
+        size_t recordSize = vault_check_record(segment->map, segment->size, offset);
+        if (recordSize == 0) {
+            return false;
+        }
+        const unsigned char * record = segment->map + offset;
+        unsigned long long id = load_uint(record + 8, 8);
+        int x = load_uint(record + 16, 1);
+
+        // Le verrou est pris enregistrement par enregistrement : les put et get concurrents ne sont retardés que d'une copie
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return true;
+        }
+
+        bool copy;
+        if (load_uint(record + 17, 1) == VAULT_TYPE_PUT)
+        {
+            // Une part n'est recopiée que si l'index la désigne encore
+            vault_slot * slot = index_.find(id, x);
+            copy = slot != NULL && slot->tag >> 8 == segment->number && slot->offset == offset;
+        } else {
+            // Une suppression n'est utile que si aucune part plus récente n'existe et qu'un segment plus ancien subsiste
+            copy = index_.find(id, x) == NULL && segments_.begin()->first < segment->number;
+        }
+
+        if (copy)
+        {
+            unsigned long long position;
+            if (!append_record(record, recordSize, position)) {
+                return false;
+            }
+            if (load_uint(record + 17, 1) == VAULT_TYPE_PUT) {
+                index_.set(id, x, active_->number, position);
+            }
+            segment->live--;
+            active_->live++;
+            journal = active_->journal;
+            end = position + recordSize;
+        }
+        offset += recordSize;
+    }
+
+    // Le segment n'est supprimé qu'une fois ses copies durables
+    if (journal && !journal->sync_to(end)) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        segments_.erase(segment->number);
+    }
+    std::string path = segment_path(segment->number);
+    return unlink(path.c_str()) == 0 && vault_sync_directory(directory_);
+}
@@ -0,0 +1,131 @@
+#ifndef VAULT_H
+#define VAULT_H
+
+#include "journal.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define VAULT_HEADER_BYTES 20           // En-tête d'un enregistrement : CRC-32C, taille, identifiant, abscisse, type
+#define VAULT_SEGMENT_BYTES (64 << 20)  // Taille maximale d'un segment du journal de parts
+#define VAULT_MAX_SHARE_BYTES 65536     // Taille maximale d'une part
+#define VAULT_COMPACT_RATIO 2           // Un segment scellé est compacté quand moins d'un enregistrement sur VAULT_COMPACT_RATIO y est vivant
+#define VAULT_COMPACT_PERIOD 1000       // Intervalle (ms) entre deux recherches de segment à compacter
+
+// Codes de retour du coffre de parts
+#define VAULT_OK 0
+#define VAULT_ERROR_IO 1            // Ecriture ou validation impossible
+#define VAULT_ERROR_NOT_FOUND 2     // Aucune part pour ce secret et ce participant
+#define VAULT_ERROR_CORRUPT 3       // Enregistrement altéré
+#define VAULT_ERROR_RANGE 4         // Participant hors de [1; 255] ou part trop grande
+
+// Position d'une part dans le journal : (identifiant du secret, abscisse du participant) -> (segment, position)
+struct vault_slot
+{
+    unsigned long long id;      // Identifiant du secret
+    unsigned int offset;        // Position de l'enregistrement dans le segment
+    unsigned int tag;           // Segment << 8 | abscisse, 0 pour une case libre
+};
+
+// Index en mémoire des parts vivantes : table de hachage à adressage ouvert (sondage linéaire), 16 octets par part
+class vault_index
+{
+public:
+    vault_index();
+
+    vault_slot * find(unsigned long long id, int x);
+    void set(unsigned long long id, int x, unsigned int segment, unsigned int offset);
+    bool erase(unsigned long long id, int x);
+    void collect(int x, std::vector<unsigned long long> & ids) const;
+    size_t size() const { return count_; }
+
+private:
+    size_t home(unsigned long long id, int x) const;
+    void grow();
+
+    std::vector<vault_slot> slots_;
+    size_t count_;
+};
+
+// Segment du journal, projeté en lecture seule ; le segment actif reçoit les ajouts par son journal
+struct vault_segment
+{
+    vault_segment() : number(0), map(NULL), size(0), records(0), live(0) {}
+    ~vault_segment();
+
+    unsigned int number;                    // Numéro du segment (nom du fichier), croissant dans l'ordre du journal
+    const unsigned char * map;              // Projection de VAULT_SEGMENT_BYTES octets
+    std::shared_ptr<group_journal> journal; // Journal du segment actif, fermé une fois le segment scellé
+    unsigned long long size;                // Octets écrits (en attente de validation compris)
+    unsigned long long records;             // Enregistrements du segment
+    unsigned long long live;                // Parts encore désignées par l'index, plus les suppressions
+};
+
+// Coffre de parts structuré en journal : parts de chaque secret rangées par (identifiant, participant) dans des
+// segments en ajout seul, validés par groupes, avec un index en mémoire et un compactage en arrière-plan
+class share_vault
+{
+public:
+    share_vault();
+    ~share_vault();
+
+    // Fonction qui ouvre (ou crée) le coffre dans directory et reconstruit l'index en relisant les segments
+    bool open(const std::string & directory, unsigned int intervalMicros, size_t batchBytes);
+
+    // Fonction qui range la part du participant x pour le secret id ; renvoie une fois la part durable
+    int put(unsigned long long id, int x, const unsigned char * share, size_t length);
+
+    // Fonction qui range les n parts d'un secret, shares[i] étant celle du participant i + 1 : les n enregistrements
+    // sont ajoutés sous un seul verrou et validés par une seule attente
+    int put_shares(unsigned long long id, const unsigned char * const * shares, int n, size_t length);
+
+    // Fonction qui lit la part du participant x pour le secret id : une seule lecture aléatoire
+    int get(unsigned long long id, int x, std::vector<unsigned char> & share);
+
+    // Fonction qui supprime la part du participant x pour le secret id ; renvoie une fois la suppression durable
+    int remove(unsigned long long id, int x);
+
+    // Fonction qui donne les identifiants des secrets ayant une part pour le participant x, dans l'ordre croissant
+    void ids(int x, std::vector<unsigned long long> & ids);
+
+    // Fonction qui arrête le compactage et ferme le coffre
+    bool close();
+
+    // Nombre de parts vivantes et de segments
+    size_t count();
+    size_t segments();
+
+private:
+    share_vault(const share_vault &);
+    share_vault & operator=(const share_vault &);
+
+    std::string segment_path(unsigned int number) const;
+    bool load_segment(unsigned int number, bool last);
+    bool start_segment();
+    bool append_record(const unsigned char * record, size_t size, unsigned long long & offset);
+    void retire(unsigned long long id, int x);
+    void run_compaction();
+    bool compact(std::shared_ptr<vault_segment> segment);
+
+    std::string directory_;
+    unsigned int interval_;
+    size_t batchBytes_;
+
+    std::mutex mutex_;                      // Protège l'index, la table des segments et l'ordre des ajouts
+    vault_index index_;
+    std::map<unsigned int, std::shared_ptr<vault_segment> > segments_;
+    std::shared_ptr<vault_segment> active_;
+    bool failed_;
+
+    std::condition_variable wake_;
+    bool stopping_;
+    std::thread compactor_;
+};
+
+#endif
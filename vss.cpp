@@ -0,0 +1,90 @@
+#include "vss.h"
+
+#include <algorithm>
+
+// Fonction qui donne k points à commitments : les points en trop sont libérés, seuls les nouveaux sont initialisés
+void vss_resize_commitments(std::vector<ec_point> & commitments, int k)
+{
+    for (size_t j = k; j < commitments.size(); j++) {
+        ec_point_clear(commitments[j]);
+    }
+    size_t previous = std::min(commitments.size(), (size_t) k);
+    commitments.resize(k);
+    for (size_t j = previous; j < (size_t) k; j++) {
+        ec_point_init(commitments[j]);
+    }
+}
+
+// Fonction qui libère les points des engagements et vide le vecteur
+void vss_clear_commitments(std::vector<ec_point> & commitments)
+{
+    vss_resize_commitments(commitments, 0);
+}
+
+// Fonction qui calcule les engagements de Feldman C_j = a_j * G des k coefficients du polynome
+// Les coefficients doivent appartenir au corps Z/nZ où n est l'ordre du groupe
+// Seuls les points ajoutés à commitments sont initialisés : ceux qu'il contient déjà sont réutilisés
+void vss_commit(std::vector<ec_point> & commitments, mpz_t * coefficients, int k, ec_group & g)
+{
+    vss_resize_commitments(commitments, k);
+
+    for (int j = 0; j < k; j++) {
+        ec_point_mul_base(commitments[j], coefficients[j], g);
+    }
+}
+
+// Fonction qui vérifie une part (x, y) à partir des engagements : y * G == somme des x^j * C_j
+bool vss_verify_share(mpz_t x, mpz_t y, std::vector<ec_point> & commitments, int k, ec_group & g)
+{
+    ec_point expected, acc;
+    ec_point_init(expected);
+    ec_point_init(acc);
+
+    // Schéma de Horner sur les points : acc = x * acc + C_j. L'abscisse est publique et petite : la multiplication
+    // en temps variable ne coûte que quelques doublements
+    ec_point_set(acc, commitments[k - 1]);
+    for (int j = k - 2; j >= 0; j--)
+    {
+        ec_point_mul_public(acc, x, acc, g);
+        ec_point_add(acc, acc, commitments[j], g);
+    }
+
+    ec_point_mul_base(expected, y, g);
+    bool valid = ec_point_equal(expected, acc, g);
+
+    ec_point_clear(expected);
+    ec_point_clear(acc);
+    return valid;
+}
+
+// Fonction qui sérialise les engagements sous forme de points compressés
+void vss_encode_commitments(std::vector<unsigned char> & out, std::vector<ec_point> & commitments, int k, ec_group & g)
+{
+    out.resize(k * EC_POINT_BYTES);
+
+    for (int j = 0; j < k; j++) {
+        ec_point_encode(out.data() + j * EC_POINT_BYTES, commitments[j], g);
+    }
+}
+
+// Fonction qui désérialise les engagements, renvoie false si l'un d'eux n'est pas un point de la courbe
+// En cas d'échec, commitments est vidé (ses points libérés)
+bool vss_decode_commitments(std::vector<ec_point> & commitments, const std::vector<unsigned char> & in, int k, ec_group & g)
+{
+    if (in.size() != (size_t) k * EC_POINT_BYTES)
+    {
+        vss_clear_commitments(commitments);
+        return false;
+    }
+
+    vss_resize_commitments(commitments, k);
+    for (int j = 0; j < k; j++)
+    {
+        if (!ec_point_decode(commitments[j], in.data() + j * EC_POINT_BYTES, g))
+        {
+            vss_clear_commitments(commitments);
+            return false;
+        }
+    }
+    return true;
+}
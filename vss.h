@@ -0,0 +1,25 @@
+#ifndef VSS_H
+#define VSS_H
+
+#include <gmp.h>
+#include <vector>
+
+#include "ec.h"
+
+// Fonction qui donne k points à commitments : les points en trop sont libérés, seuls les nouveaux sont initialisés
+void vss_resize_commitments(std::vector<ec_point> & commitments, int k);
+
+// Fonction qui libère les points des engagements et vide le vecteur
+void vss_clear_commitments(std::vector<ec_point> & commitments);
+
+// Fonction qui calcule les engagements de Feldman C_j = a_j * G des k coefficients du polynome
+void vss_commit(std::vector<ec_point> & commitments, mpz_t * coefficients, int k, ec_group & g);
+
+// Fonction qui vérifie une part (x, y) à partir des engagements : y * G == somme des x^j * C_j
+bool vss_verify_share(mpz_t x, mpz_t y, std::vector<ec_point> & commitments, int k, ec_group & g);
+
+// Fonctions de sérialisation des engagements (EC_POINT_BYTES octets par engagement)
+void vss_encode_commitments(std::vector<unsigned char> & out, std::vector<ec_point> & commitments, int k, ec_group & g);
+bool vss_decode_commitments(std::vector<ec_point> & commitments, const std::vector<unsigned char> & in, int k, ec_group & g);
+
+#endif